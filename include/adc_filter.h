@@ -0,0 +1,81 @@
+/*
+ * ADC acquisition filter
+ * Each sample period the thermistor is read in a short burst. The burst is sorted and the
+ * k readings around the median are averaged, which throws away spikes and gives sub-LSB
+ * resolution (Q4). The result then goes through a fixed-point exponential moving average
+ * whose time constant is 2^shift sample periods.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifndef ADC_BURST_SAMPLES
+#define ADC_BURST_SAMPLES 9  // analogRead() calls per sample period
+#endif
+#ifndef ADC_MEDIAN_KEEP
+#define ADC_MEDIAN_KEEP 5    // Readings around the median that are averaged (1 = plain median)
+#endif
+#ifndef ADC_EMA_SHIFT
+#define ADC_EMA_SHIFT 2      // EMA weight 1/2^shift, time constant ~2^shift sample periods
+#endif
+
+#define ADC_FILTER_Q4_ONE 16  // 1 ADC code in Q4
+#define ADC_EMA_MAX_SHIFT 8   // Keeps the accumulator within 32 bits
+
+class AdcFilter {
+public:
+  explicit AdcFilter(uint8_t shift = ADC_EMA_SHIFT) { setShift(shift); }
+
+  // Feed one burst of raw readings (reordered in place), returns the filtered code in Q4
+  uint16_t update(uint16_t* burst, uint8_t count) {
+    burstQ4 = medianOfK(burst, count);
+    if (!primed) {
+      acc = (uint32_t)burstQ4 << shift;  // Start from the first reading instead of 0
+      primed = true;
+    } else {
+      acc = acc - (acc >> shift) + burstQ4;  // acc = acc * (1 - 1/2^shift) + x
+    }
+    filteredQ4 = (uint16_t)((acc + (1u << shift >> 1)) >> shift);
+    return filteredQ4;
+  }
+
+  // Change the time constant, the filter state is kept
+  void setShift(uint8_t newShift) {
+    if (newShift > ADC_EMA_MAX_SHIFT) newShift = ADC_EMA_MAX_SHIFT;
+    if (primed) acc = (uint32_t)filteredQ4 << newShift;
+    shift = newShift;
+  }
+
+  void reset() { primed = false; }
+
+  uint8_t emaShift() const { return shift; }
+  uint16_t lastBurstQ4() const { return burstQ4; }  // Outlier-rejected burst before the EMA
+  uint16_t lastFilteredQ4() const { return filteredQ4; }
+
+  // Sort the burst and average the ADC_MEDIAN_KEEP readings around the median, in Q4
+  static uint16_t medianOfK(uint16_t* v, uint8_t n) {
+    if (n == 0) return 0;
+    // Insertion sort, the burst is only a handful of samples
+    for (uint8_t i = 1; i < n; i++) {
+      uint16_t x = v[i];
+      int8_t j = i - 1;
+      while (j >= 0 && v[j] > x) {
+        v[j + 1] = v[j];
+        j--;
+      }
+      v[j + 1] = x;
+    }
+    uint8_t keep = ADC_MEDIAN_KEEP < n ? ADC_MEDIAN_KEEP : n;
+    uint8_t first = (n - keep) / 2;
+    uint32_t sum = 0;
+    for (uint8_t i = first; i < first + keep; i++) sum += v[i];
+    return (uint16_t)((sum * ADC_FILTER_Q4_ONE + keep / 2) / keep);
+  }
+
+private:
+  uint32_t acc = 0;         // EMA state, Q4 << shift
+  uint16_t burstQ4 = 0;
+  uint16_t filteredQ4 = 0;
+  uint8_t shift = ADC_EMA_SHIFT;
+  bool primed = false;
+};
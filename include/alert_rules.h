@@ -0,0 +1,114 @@
+/*
+ * Rule-based alerts
+ * A rule raises when the reading passes its threshold in its direction and stays there for
+ * minDurationS (debounce), and clears once the reading is back past threshold - hysteresis.
+ * Raised and cleared transitions go into a fixed ring of timestamped events.
+ *
+ * A below rule is an above rule on the negated reading, so each direction is one sorted
+ * list. Per direction two cursors mark where the last reading falls among the raise points
+ * and among the clear points; a reading moves the cursors and visits only the rules whose
+ * points it passed. Rules waiting out their minimum duration are kept in deadline order,
+ * so only the first one is checked. update() therefore costs the same whatever the number
+ * of rules, plus one step per rule that changes state.
+ *
+ * Plain C++ (no Arduino headers).
+ */
+#pragma once
+
+#include <stdint.h>
+#include "centi_temp.h"
+
+#ifndef ALERT_MAX_RULES
+#define ALERT_MAX_RULES 8
+#endif
+#ifndef ALERT_EVENT_CAPACITY
+#define ALERT_EVENT_CAPACITY 32  // Events kept, the oldest is overwritten
+#endif
+
+enum AlertDirection : uint8_t { ALERT_ABOVE, ALERT_BELOW };
+enum AlertSeverity : uint8_t { ALERT_INFO, ALERT_WARNING, ALERT_CRITICAL };
+
+struct AlertRule {
+  const char* name;
+  AlertDirection direction;
+  CentiC threshold;
+  CentiC hysteresis;       // Clears this far back on the safe side of the threshold
+  uint16_t minDurationS;   // Raised only after this long past the threshold, 0 = at once
+  AlertSeverity severity;
+};
+
+struct AlertEvent {
+  uint32_t timestampMs;    // Reading that caused it
+  CentiC value;
+  uint8_t rule;
+  bool raised;             // false = cleared
+};
+
+class AlertEngine {
+public:
+  // Copies the rules, all start cleared
+  void begin(const AlertRule* rules, uint8_t count);
+  // Move a threshold (Settings screen), the rule is judged again on the last reading
+  void setThreshold(uint8_t rule, CentiC threshold);
+  // Evaluate a reading, true when it logged an event
+  bool update(uint32_t timestampMs, CentiC value);
+
+  uint8_t ruleCount() const { return count; }
+  const AlertRule& rule(uint8_t i) const { return rules[i]; }
+  bool active(uint8_t rule) const { return state[rule] == ACTIVE; }
+  uint8_t activeCount() const { return activeRules; }
+
+  // Event log, i = 0 is the newest
+  uint16_t eventCount() const { return eventsStored; }
+  const AlertEvent& event(uint16_t i) const {
+    return events[(eventHead + ALERT_EVENT_CAPACITY - 1 - i) % ALERT_EVENT_CAPACITY];
+  }
+  uint32_t eventsLogged() const { return eventsTotal; }  // Since boot, changes with every new event
+
+private:
+  enum State : uint8_t { IDLE, PENDING, ACTIVE };
+
+  // One direction: rule indexes sorted by raise point and by clear point, and where the
+  // last reading falls among them
+  struct Side {
+    uint8_t byRaise[ALERT_MAX_RULES];
+    uint8_t byClear[ALERT_MAX_RULES];
+    uint8_t count;
+    uint8_t raised;   // byRaise[0..raised) have their raise point below the reading
+    uint8_t cleared;  // byClear[cleared..count) have their clear point above the reading
+  };
+
+  void sort();
+  void enter(uint8_t rule, uint32_t timestampMs, CentiC value);
+  void leave(uint8_t rule);
+  void raise(uint8_t rule, uint32_t timestampMs, CentiC value);
+  void clear(uint8_t rule, uint32_t timestampMs, CentiC value);
+  void log(uint8_t rule, bool raised, uint32_t timestampMs, CentiC value);
+  void updateSide(Side& side, int32_t key, uint32_t timestampMs, CentiC value);
+  int32_t key(uint8_t rule, CentiC value) const {
+    return rules[rule].direction == ALERT_ABOVE ? value.raw : -(int32_t)value.raw;
+  }
+
+  AlertRule rules[ALERT_MAX_RULES];
+  uint8_t count = 0;
+  int32_t raiseAt[ALERT_MAX_RULES];   // Keys: the reading, negated for below rules
+  int32_t clearAt[ALERT_MAX_RULES];
+  State state[ALERT_MAX_RULES];
+  Side sides[2];
+  uint8_t activeRules = 0;
+
+  // Pending rules in deadline order, a doubly linked list through the rule indexes
+  static const uint8_t NONE = 0xFF;
+  uint32_t deadline[ALERT_MAX_RULES];
+  uint8_t pendingNext[ALERT_MAX_RULES], pendingPrev[ALERT_MAX_RULES];
+  uint8_t pendingFirst = NONE, pendingLast = NONE;
+
+  bool haveLast = false;
+  uint32_t lastMs = 0;
+  CentiC lastValue;
+
+  AlertEvent events[ALERT_EVENT_CAPACITY];
+  uint16_t eventHead = 0;     // Slot of the next event
+  uint16_t eventsStored = 0;
+  uint32_t eventsTotal = 0;
+};
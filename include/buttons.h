@@ -0,0 +1,88 @@
+/*
+ * Button input
+ * The GPIO interrupts only timestamp each edge into a queue. The button task runs the edges
+ * through a time-based debounce state machine per button and turns them into events:
+ *
+ *   PRESS   contact closed. Leading-edge debounce: the first edge is acted on at once and
+ *           changes within BUTTON_DEBOUNCE_MS after it are contact bounce
+ *   SHORT   released before BUTTON_LONG_MS
+ *   LONG    still held after BUTTON_LONG_MS
+ *   REPEAT  every BUTTON_REPEAT_MS after LONG while still held
+ *   COMBO   every button of the combo mask held together for BUTTON_COMBO_MS. While they are
+ *           all down those buttons give no LONG or REPEAT, and no SHORT once the combo fired
+ */
+#pragma once
+
+#include <Arduino.h>
+#include "event_queue.h"
+
+#define BUTTON_MAX 4              // Buttons one ButtonInput can handle
+#ifndef BUTTON_DEBOUNCE_MS
+#define BUTTON_DEBOUNCE_MS 25     // Contact bounce lockout after an accepted change
+#endif
+#ifndef BUTTON_LONG_MS
+#define BUTTON_LONG_MS 600        // Hold time of a long press
+#endif
+#ifndef BUTTON_REPEAT_MS
+#define BUTTON_REPEAT_MS 150      // Auto-repeat interval after a long press
+#endif
+#ifndef BUTTON_COMBO_MS
+#define BUTTON_COMBO_MS 1000      // Hold time of a combo
+#endif
+#define BUTTON_EDGE_QUEUE 32      // Edges buffered between two button task runs
+#define BUTTON_ID_COMBO 0xFF      // ButtonEvent::button of a COMBO event
+
+enum ButtonEventType : uint8_t { BUTTON_PRESS, BUTTON_SHORT, BUTTON_LONG, BUTTON_REPEAT, BUTTON_COMBO };
+
+struct ButtonEvent {
+  uint8_t button;        // Button index, BUTTON_ID_COMBO for a combo
+  ButtonEventType type;
+  uint32_t ms;           // When it happened: the edge for PRESS and SHORT, the hold time otherwise
+};
+
+struct ButtonEdge {
+  uint8_t button;
+  uint8_t pressed;       // Contact closed after the edge
+  uint32_t ms;           // millis() in the interrupt
+};
+
+typedef void (*ButtonHandler)(const ButtonEvent& event);
+
+class ButtonInput {
+public:
+  ButtonInput(uint8_t count, uint8_t comboMask) : count(count < BUTTON_MAX ? count : BUTTON_MAX), comboMask(comboMask) {}
+
+  // Interrupt side: record one edge, nothing else
+  void IRAM_ATTR edge(uint8_t button, bool pressed, uint32_t ms) { edges.push({ button, (uint8_t)pressed, ms }); }
+
+  // Task side: debounce the queued edges, run the hold timers up to nowMs, call handler per event
+  void poll(uint32_t nowMs, ButtonHandler handler);
+
+  bool pressed(uint8_t button) const { return button < count && state[button].stable; }  // Debounced
+  uint32_t droppedEdges() const { return edges.dropped(); }
+  uint32_t lastLatencyMs() const { return lastLatency; }  // Edge to PRESS event of the last press
+  uint32_t maxLatencyMs() const { return maxLatency; }
+
+private:
+  enum Phase : uint8_t { RELEASED, DOWN, HELD, IN_COMBO };
+
+  struct State {
+    bool raw = false;      // Level of the last edge
+    bool stable = false;   // Debounced level
+    Phase phase = RELEASED;
+    uint32_t rawMs = 0;    // Time of the last edge
+    uint32_t stableMs = 0; // Time of the last accepted change
+    uint32_t nextRepeatMs = 0;
+  };
+
+  void accept(uint8_t button, uint32_t ms, uint32_t nowMs, ButtonHandler handler);
+  bool comboDown() const;
+
+  EventQueue<ButtonEdge, BUTTON_EDGE_QUEUE> edges;
+  State state[BUTTON_MAX];
+  uint8_t count;
+  uint8_t comboMask;
+  bool comboFired = false;
+  uint32_t lastLatency = 0;
+  uint32_t maxLatency = 0;
+};
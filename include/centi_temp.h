@@ -0,0 +1,64 @@
+/*
+ * Fixed-point temperature
+ * A CentiC is a temperature in hundredths of a degree C in an int16_t (-327.68 .. 327.67 C,
+ * well beyond what the thermistor can report). Readings, limits, history, rollups and the
+ * chart scales all use it, so comparing, averaging and scaling temperatures are integer
+ * operations: the ESP8266 has no FPU and every float operation is a libgcc call.
+ *
+ * Results that do not fit saturate at the int16 limits instead of wrapping.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+struct CentiC {
+  int16_t raw;  // Hundredths of a degree C
+
+  static constexpr CentiC fromCenti(int32_t centi) {
+    return { (int16_t)(centi > INT16_MAX ? INT16_MAX : centi < INT16_MIN ? INT16_MIN : centi) };
+  }
+  static constexpr CentiC fromDegrees(int32_t degrees) { return fromCenti(degrees * 100); }
+
+  // Whole degrees, rounded to nearest (halves away from zero)
+  constexpr int16_t degrees() const { return (int16_t)((raw < 0 ? raw - 50 : raw + 50) / 100); }
+
+  constexpr CentiC operator+(CentiC other) const { return fromCenti((int32_t)raw + other.raw); }
+  constexpr CentiC operator-(CentiC other) const { return fromCenti((int32_t)raw - other.raw); }
+  constexpr CentiC operator-() const { return fromCenti(-(int32_t)raw); }
+  CentiC& operator+=(CentiC other) { return *this = *this + other; }
+  CentiC& operator-=(CentiC other) { return *this = *this - other; }
+
+  constexpr bool operator==(CentiC other) const { return raw == other.raw; }
+  constexpr bool operator!=(CentiC other) const { return raw != other.raw; }
+  constexpr bool operator<(CentiC other) const { return raw < other.raw; }
+  constexpr bool operator<=(CentiC other) const { return raw <= other.raw; }
+  constexpr bool operator>(CentiC other) const { return raw > other.raw; }
+  constexpr bool operator>=(CentiC other) const { return raw >= other.raw; }
+};
+
+// Mean of a sum of raw values, rounded to nearest
+inline CentiC centiMean(int32_t sum, uint32_t count) {
+  if (count == 0) return { 0 };
+  int32_t half = (int32_t)(count / 2);
+  return CentiC::fromCenti(sum < 0 ? (sum - half) / (int32_t)count : (sum + half) / (int32_t)count);
+}
+
+// Midpoint of two temperatures (chart scales)
+inline CentiC centiMid(CentiC a, CentiC b) { return CentiC::fromCenti(((int32_t)a.raw + b.raw) / 2); }
+
+// "25.37" with decimals = 2, "25.4" with decimals = 1 (rounded), like %.2f / %.1f on the value
+inline int formatCentiC(char* out, size_t size, CentiC t, uint8_t decimals = 2) {
+  int32_t v = t.raw < 0 ? -(int32_t)t.raw : t.raw;
+  if (decimals < 2) v = (v + 5) / 10;  // Tenths, the rounding is on the magnitude
+  const char* sign = t.raw < 0 && v != 0 ? "-" : "";
+  if (decimals < 2) return snprintf(out, size, "%s%ld.%ld", sign, (long)(v / 10), (long)(v % 10));
+  return snprintf(out, size, "%s%ld.%02ld", sign, (long)(v / 100), (long)(v % 100));
+}
+
+// Formatted value as a printf argument: snprintf(line, size, "Temp: %s", CentiText(t).str)
+struct CentiText {
+  char str[8];  // "-327.68"
+  explicit CentiText(CentiC t, uint8_t decimals = 2) { formatCentiC(str, sizeof(str), t, decimals); }
+};
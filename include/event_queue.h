@@ -0,0 +1,50 @@
+/*
+ * Lock-free single-producer/single-consumer event queue
+ * The producer (Ticker callback) only writes head, the consumer (loop) only writes tail,
+ * so neither side ever waits on the other. When the queue is full the new event is
+ * dropped and counted rather than overwriting one the consumer may be reading.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+template <typename T, uint32_t N>
+class EventQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "EventQueue size must be a power of two");
+
+public:
+  // Producer side: returns false (and counts a drop) when the queue is full.
+  // Always inlined, so a producer running from IRAM (a GPIO interrupt) never calls into flash
+  __attribute__((always_inline)) bool push(const T& item) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= N) {
+      drops.store(drops.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      return false;
+    }
+    items[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);  // Publish the item
+    return true;
+  }
+
+  // Consumer side: returns false when there is nothing to read
+  bool pop(T& item) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    item = items[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);  // Free the slot
+    return true;
+  }
+
+  bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+  uint32_t size() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+  uint32_t dropped() const { return drops.load(std::memory_order_relaxed); }
+
+private:
+  T items[N];
+  std::atomic<uint32_t> head{0};   // Next slot to write, only the producer stores it
+  std::atomic<uint32_t> tail{0};   // Next slot to read, only the consumer stores it
+  std::atomic<uint32_t> drops{0};  // Events lost because the queue was full
+};
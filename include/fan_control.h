@@ -0,0 +1,97 @@
+/*
+ * Fan speed controller
+ * Fixed-point PID on the filtered temperature in centi-degrees, output as a PWM duty in
+ * permille. The fan starts when the temperature rises above the setpoint and runs at no
+ * less than the minimum duty (fans stall below it) until the temperature has dropped
+ * hysteresis below the setpoint, so it no longer toggles on every reading around the limit.
+ *
+ *   error = T - setpoint                        (positive = too warm = more fan)
+ *   P     = Kp * error                          Kp in % duty per C
+ *   I    += Ki * error * dt                     Ki in % duty per C per hour
+ *   D     = Kd * dT/dt                          Kd in % duty per (C per minute), on T only
+ *
+ * With prestart set (an over-temperature is predicted, see temp_predictor.h) the fan also
+ * starts below the setpoint and then runs at the minimum duty, the PID output being below it,
+ * and the stop rule waits until prestart is cleared again.
+ *
+ * Anti-windup: the integral is clamped to the duty range and is not advanced while the
+ * output is saturated in the direction the error would push it.
+ *
+ * Autotune applies a full-duty step, records the cooling response and derives a PI tuning
+ * from a first-order-plus-dead-time fit (28 % / 63 % points, SIMC rules).
+ */
+#pragma once
+
+#include <stdint.h>
+#include "centi_temp.h"
+
+#ifndef FAN_PWM_PIN
+#define FAN_PWM_PIN D0        // GPIO16, free with the display and buttons as wired
+#endif
+#ifndef FAN_PWM_FREQ
+#define FAN_PWM_FREQ 25000    // Hz, above hearing and what 4-wire fans expect
+#endif
+#define FAN_PWM_RANGE 1000    // analogWriteRange(), one step per permille of duty
+#define FAN_DUTY_MAX 1000     // Full duty in permille
+
+#define FAN_AUTOTUNE_POINTS 64           // Response samples kept, thinned out as the step goes on
+#define FAN_AUTOTUNE_MAX_MS 3600000UL    // Give up on a response that has not settled after an hour
+#define FAN_AUTOTUNE_MIN_CENTI_C 50      // A step that moves the temperature less than this is not usable
+
+// User settings, edited on the Settings screen
+struct FanTuning {
+  int16_t setpointC = 38;        // Fan starts above this
+  uint8_t kp = 25;               // % per C
+  uint16_t ki = 150;             // % per C per hour
+  uint8_t kd = 0;                // % per (C per minute)
+  uint8_t minDutyPct = 20;       // Lowest duty while running
+  uint8_t hysteresisDeciC = 15;  // Fan stops this far below the setpoint (tenths of a C)
+};
+
+class FanController {
+public:
+  enum AutotuneState { TUNE_IDLE, TUNE_RUNNING, TUNE_DONE, TUNE_FAILED };
+
+  // Feed one filtered reading, returns the duty to apply in permille (0 = off)
+  uint16_t update(CentiC temperature, uint32_t timestampMs);
+
+  // Start early, before the setpoint is reached
+  void setPrestart(bool active) { prestart = active; }
+  bool prestarted() const { return prestart && output > 0; }
+
+  // Step test: full duty until the response settles, then the tuning is replaced
+  void startAutotune();
+  void cancelAutotune();
+  AutotuneState autotuneState() const { return tuneState; }
+  uint32_t autotuneElapsedMs() const { return tuneLastMs - tuneStartMs; }
+
+  uint16_t duty() const { return output; }
+  bool running() const { return output > 0; }
+  uint32_t starts() const { return startCount; }  // Times the fan was switched on
+
+  FanTuning tuning;
+
+private:
+  uint16_t runPid(int32_t centiC, uint32_t dtMs);
+  void autotuneStep(int32_t centiC, uint32_t timestampMs);
+  void finishAutotune();
+
+  bool primed = false;          // False until the first reading
+  bool on = false;              // Between a start above the setpoint and a stop below setpoint - hysteresis
+  bool prestart = false;        // Run even below the setpoint
+  int32_t integralQ16 = 0;      // Integral term in permille, Q16
+  int32_t lastCentiC = 0;
+  uint32_t lastMs = 0;
+  uint16_t output = 0;
+  uint32_t startCount = 0;
+
+  AutotuneState tuneState = TUNE_IDLE;
+  bool tuneRequested = false;
+  uint32_t tuneStartMs = 0, tuneLastMs = 0;
+  int32_t tuneStartCentiC = 0;
+  int32_t tuneMinuteCentiC = 0;  // Reading at the start of the current settling check
+  uint32_t tuneMinuteMs = 0;
+  int16_t tunePoints[FAN_AUTOTUNE_POINTS];  // Response relative to the start, centi-C
+  uint8_t tuneCount = 0;
+  uint8_t tuneShift = 0;        // Points are 2^tuneShift seconds apart
+};
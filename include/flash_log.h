@@ -0,0 +1,138 @@
+/*
+ * Persistent history log in LittleFS
+ * Append-only log of records (one per closed minute of readings) in segment files
+ * /log/<seq>.seg. Records are packed with the series codes (series_codec.h) into blocks of
+ * FLASH_LOG_BLOCK_BYTES: the first record of a block in full, the others as changes from
+ * the one before, 0.5-3.5 bytes each instead of 16. The open block is kept in RAM and
+ * written (in place, once it is on flash) every FLASH_LOG_SYNC_RECORDS records and when it
+ * is full; when the newest segment holds FLASH_LOG_SEGMENT_BLOCKS blocks a new one is
+ * started, and past FLASH_LOG_SEGMENTS the oldest is deleted. LittleFS spreads the writes
+ * over the flash blocks itself.
+ *
+ *   segment  header: magic, version, block size, seq, time of the first record, CRC-32
+ *            of the header; then whole blocks
+ *   block    record count, packed bits, first record, packed records, CRC-32
+ *
+ * Blocks have a fixed size, so a block is found by seeking and a block that is not full
+ * (the open one, or the last one before a restart) is still a whole block on flash. Record
+ * times never go backwards.
+ *
+ * begin() reads only the segment headers plus the last block of the newest segment: a
+ * block that was torn by a reset during the write fails its size or CRC check and is cut
+ * off. query() finds the segments of a time range from the header table, binary searches
+ * the first block by its first record time and streams the records to a callback, so a
+ * range of days is read block by block, never loaded as a whole.
+ */
+#pragma once
+
+#include <Arduino.h>
+#include <FS.h>
+#include "centi_temp.h"
+#include "rollup.h"
+
+#ifndef FLASH_LOG_ENABLE
+#define FLASH_LOG_ENABLE 1
+#endif
+#define FLASH_LOG_DIR "/log"
+#ifndef FLASH_LOG_SYNC_RECORDS
+#define FLASH_LOG_SYNC_RECORDS 16    // Records between writes of the open block (16 minutes)
+#endif
+#define FLASH_LOG_BLOCK_BYTES 256    // Block size on flash (70 records when noisy, 300 when steady)
+#ifndef FLASH_LOG_SEGMENT_BLOCKS
+#define FLASH_LOG_SEGMENT_BLOCKS 60  // Blocks per segment file (3 days or more, 15 KB)
+#endif
+#ifndef FLASH_LOG_SEGMENTS
+#define FLASH_LOG_SEGMENTS 16        // Segments kept (7 weeks or more, 240 KB)
+#endif
+#define FLASH_LOG_MAGIC 0x474F4C54UL // "TLOG"
+#define FLASH_LOG_VERSION 2          // 1: unpacked records
+
+struct FlashLogRecord {
+  uint32_t time;       // Seconds, wall clock (continued from the last record while unsynced)
+  CentiC min;
+  CentiC max;
+  CentiC mean;
+  uint16_t count;      // Readings in the interval
+  uint32_t crossings;  // Peak crossings since the log was started
+};
+static_assert(sizeof(FlashLogRecord) == 16, "FlashLogRecord is stored as is");
+
+struct FlashLogHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t blockBytes;
+  uint32_t seq;        // Segment number, increases by one per segment
+  uint32_t firstTime;  // Time of the first record
+  uint32_t crc;        // CRC-32 of the fields above
+};
+
+struct FlashLogBlock {
+  uint16_t count;        // Records in the block, the first one included
+  uint16_t bits;         // Packed bits in use
+  FlashLogRecord first;  // In full, its time is what the block search reads
+  uint8_t data[FLASH_LOG_BLOCK_BYTES - 24];  // The other records, packed
+  uint32_t crc;          // CRC-32 of everything above
+};
+static_assert(sizeof(FlashLogBlock) == FLASH_LOG_BLOCK_BYTES, "FlashLogBlock is stored as is");
+
+// Visitor for query(), return false to stop
+typedef bool (*FlashLogVisitor)(const FlashLogRecord& record, void* context);
+
+// A record as the minute bucket it was logged from
+RollupBucket flashLogBucket(const FlashLogRecord& record);
+// Visitor that merges the records into a RollupSummary (context)
+bool flashLogFoldSummary(const FlashLogRecord& record, void* context);
+
+class FlashLog {
+public:
+  // Scan the segment headers and recover the tail, false when the log cannot be used
+  bool begin(FS& fs);
+  // Add a record to the open block, which is written every FLASH_LOG_SYNC_RECORDS records
+  void append(FlashLogRecord record);
+  // Write the open block now (e.g. before a restart)
+  bool flush();
+  // Visit the records with from <= time < to, oldest first (queued ones included),
+  // returns the number visited
+  uint32_t query(uint32_t from, uint32_t to, FlashLogVisitor visit, void* context);
+
+  bool ready() const { return fs != nullptr; }
+  bool last(FlashLogRecord& record) const;   // Newest record, false when the log is empty
+  uint32_t appended() const { return appendCount; }  // Records appended since begin()
+  uint8_t segments() const { return segCount; }
+  uint32_t storedBlocks() const;
+  uint32_t blockWrites() const { return writeCount; }  // Including rewrites of the open block
+  uint32_t crcErrors() const { return badBlocks; }   // Blocks skipped by queries and recovery
+  uint32_t recoveredBlocks() const { return cutBlocks; }  // Torn blocks cut off by begin()
+
+private:
+  struct Segment {
+    uint32_t seq;
+    uint32_t firstTime;
+    uint16_t blocks;
+  };
+
+  bool writeBlock();
+  bool startSegment(uint32_t firstTime);
+  void recoverTail();
+  void segmentPath(uint32_t seq, char* path, size_t size) const;
+  bool readBlock(File& file, uint16_t index, FlashLogBlock& block);
+  uint32_t blockFirstTime(File& file, uint16_t index);
+
+  FS* fs = nullptr;
+  Segment segs[FLASH_LOG_SEGMENTS];  // Oldest first
+  uint8_t segCount = 0;
+  FlashLogBlock pending = {};        // Open block
+  FlashLogRecord pendingLast = {};   // Its newest record and time step, what the next is packed from
+  int32_t pendingStep = 0;
+  bool pendingStored = false;        // The open block is the newest block on flash
+  uint16_t unsynced = 0;             // Records added since the open block was written
+  FlashLogBlock scratch;             // Block being read by a query
+  FlashLogRecord newest = {};
+  bool haveNewest = false;
+  uint32_t appendCount = 0;
+  uint32_t writeCount = 0;
+  uint32_t badBlocks = 0;
+  uint32_t cutBlocks = 0;
+};
+
+uint32_t flashLogCrc32(const uint8_t* data, size_t length);  // CRC-32 (IEEE, as zlib)
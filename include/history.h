@@ -0,0 +1,110 @@
+/*
+ * Fixed-capacity ring buffer of timestamped readings
+ * push() overwrites the oldest sample once the buffer is full, nothing is ever shifted.
+ * Two monotonic deques of slot indices keep the minimum and maximum of the stored
+ * samples, so min()/max() are O(1) and push() is amortized O(1).
+ * Timestamps and values are kept in separate arrays, so a 2-byte value (CentiC) takes
+ * 2 bytes per sample instead of being padded out to the 4-byte timestamp.
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifndef HISTORY_CAPACITY
+#define HISTORY_CAPACITY 300  // Readings kept (5 minutes at one reading per second)
+#endif
+
+template <typename T>
+struct HistorySample {
+  uint32_t timestampMs; // millis() of the reading
+  T value;
+};
+
+template <typename T, uint16_t N>
+class RingHistory {
+  static_assert(N >= 2, "RingHistory needs room for at least two samples");
+
+public:
+  // Forward iterator, oldest to newest
+  class Iterator {
+  public:
+    Iterator(const RingHistory* history, uint16_t index) : history(history), index(index) {}
+    HistorySample<T> operator*() const { return (*history)[index]; }
+    Iterator& operator++() { index++; return *this; }
+    bool operator!=(const Iterator& other) const { return index != other.index; }
+
+  private:
+    const RingHistory* history;
+    uint16_t index;
+  };
+
+  void push(uint32_t timestampMs, T value) {
+    uint16_t slot;
+    if (count == N) {
+      // Full: the oldest sample is overwritten, drop it from the deques first
+      slot = head;
+      if (minQ.front() == slot) minQ.popFront();
+      if (maxQ.front() == slot) maxQ.popFront();
+      head = next(head);
+    } else {
+      slot = index(count);
+      count++;
+    }
+    times[slot] = timestampMs;
+    values[slot] = value;
+    pushes++;
+
+    // Keep the deques monotonic: values that can no longer be the min/max are removed
+    while (!minQ.empty() && values[minQ.back()] >= value) minQ.popBack();
+    minQ.pushBack(slot);
+    while (!maxQ.empty() && values[maxQ.back()] <= value) maxQ.popBack();
+    maxQ.pushBack(slot);
+  }
+
+  void clear() { head = count = 0; minQ.clear(); maxQ.clear(); }
+
+  // i = 0 is the oldest sample, size() - 1 the newest
+  HistorySample<T> operator[](uint16_t i) const { return sample(index(i)); }
+  HistorySample<T> newest() const { return sample(index(count - 1)); }
+  HistorySample<T> oldest() const { return sample(head); }
+
+  // Only valid when !empty()
+  T min() const { return values[minQ.front()]; }
+  T max() const { return values[maxQ.front()]; }
+
+  uint16_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  bool full() const { return count == N; }
+  static constexpr uint16_t capacity() { return N; }
+  uint32_t totalPushed() const { return pushes; }  // Readings since boot, including overwritten ones
+
+  Iterator begin() const { return Iterator(this, 0); }
+  Iterator end() const { return Iterator(this, count); }
+
+private:
+  // Slot deque, at most N entries (one per stored sample)
+  struct SlotDeque {
+    uint16_t slots[N];
+    uint16_t first = 0, length = 0;
+
+    bool empty() const { return length == 0; }
+    uint16_t front() const { return slots[first]; }
+    uint16_t back() const { return slots[(first + length - 1) % N]; }
+    void pushBack(uint16_t slot) { slots[(first + length) % N] = slot; length++; }
+    void popFront() { first = (first + 1) % N; length--; }
+    void popBack() { length--; }
+    void clear() { first = length = 0; }
+  };
+
+  HistorySample<T> sample(uint16_t slot) const { return { times[slot], values[slot] }; }
+  uint16_t next(uint16_t slot) const { return slot + 1 == N ? 0 : slot + 1; }
+  uint16_t index(uint16_t i) const { return (uint16_t)((head + i) % N); }
+
+  uint32_t times[N];
+  T values[N];
+  uint16_t head = 0;   // Slot of the oldest sample
+  uint16_t count = 0;  // Samples stored
+  uint32_t pushes = 0;
+  SlotDeque minQ;      // Slots with increasing values, front = minimum
+  SlotDeque maxQ;      // Slots with decreasing values, front = maximum
+};
@@ -0,0 +1,74 @@
+/*
+ * Local wall clock
+ * Keeps time of day from a 64-bit extension of millis() and only asks the network for the
+ * time on a schedule: every CLOCK_SYNC_INTERVAL_MS after a good sync, with exponential
+ * backoff after failures. Small corrections are slewed in, large ones are stepped, and
+ * hours/minutes/seconds are cached so reading them costs nothing. The source is polled
+ * by update() until it has an answer, so a resync never waits on the network.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+#ifndef CLOCK_SYNC_INTERVAL_MS
+#define CLOCK_SYNC_INTERVAL_MS 3600000UL  // Resync once an hour when the last sync worked
+#endif
+#ifndef CLOCK_RETRY_MIN_MS
+#define CLOCK_RETRY_MIN_MS 10000UL        // First retry after a failed sync, doubled each failure
+#endif
+#ifndef CLOCK_STEP_THRESHOLD_MS
+#define CLOCK_STEP_THRESHOLD_MS 2000      // Larger errors are stepped instead of slewed
+#endif
+#ifndef CLOCK_SLEW_MS_PER_S
+#define CLOCK_SLEW_MS_PER_S 50            // Slew rate, 5% of elapsed time
+#endif
+
+enum ClockSyncResult : uint8_t { CLOCK_SYNC_PENDING, CLOCK_SYNC_OK, CLOCK_SYNC_FAILED };
+
+// Time source used for resyncs, called with start = true when one is due and then with
+// start = false on every update() while it returns CLOCK_SYNC_PENDING. Must not block;
+// fills epochSeconds (local time zone) on CLOCK_SYNC_OK and gives up on its own timeout.
+typedef ClockSyncResult (*ClockSyncSource)(bool start, uint32_t& epochSeconds);
+
+class LocalClock {
+public:
+  void begin(ClockSyncSource source);
+  // Advance the clock, slew and run a resync if one is due; call periodically from loop()
+  void update();
+  // Set the time of day by hand (Settings screen), kept until the next successful sync
+  void setTimeOfDay(int h, int m, int s);
+  // Force a resync on the next update()
+  void requestSync() { nextSyncMs = monotonicMs(); }
+
+  int hours() const { return cachedHours; }
+  int minutes() const { return cachedMinutes; }
+  int seconds() const { return cachedSeconds; }
+  uint64_t monotonicMs();  // millis() extended to 64 bits
+  uint64_t wallMs() { return monotonicMs() + offsetMs; }
+
+  bool isSynced() const { return syncCount > 0; }
+  bool isSyncPending() const { return syncPending; }  // Waiting for the source's answer
+  bool isManuallySet() const { return manuallySet; }
+  uint32_t syncs() const { return syncCount; }
+  uint32_t failures() const { return failureCount; }
+  int32_t lastErrorMs() const { return lastSyncErrorMs; }  // Clock minus source at the last sync
+
+private:
+  void applySync(uint64_t sourceMs, uint64_t now);
+  void refreshTimeOfDay(uint64_t now);
+
+  ClockSyncSource syncSource = nullptr;
+  uint32_t lastMillis = 0;        // Last millis() value seen, to detect wrap
+  uint32_t millisHigh = 0;        // Number of millis() wraps
+  int64_t offsetMs = 0;           // Wall time minus monotonic time
+  int64_t slewRemainingMs = 0;    // Correction still to be applied
+  uint64_t lastSlewMs = 0;        // When the slew was last advanced
+  uint64_t nextSyncMs = 0;        // When the next resync is due
+  uint8_t backoffExp = 0;         // Consecutive failures, sets the retry delay
+  bool syncPending = false;       // The source has a request out
+  uint32_t syncCount = 0;
+  uint32_t failureCount = 0;
+  int32_t lastSyncErrorMs = 0;
+  bool manuallySet = false;
+  int cachedHours = 0, cachedMinutes = 0, cachedSeconds = 0;
+};
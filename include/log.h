@@ -0,0 +1,87 @@
+/*
+ * Leveled, buffered logging
+ * LOG_ERROR/WARN/INFO/DEBUG format into a fixed-size record and queue it, the log task
+ * drains the queue to the UART only as fast as the TX FIFO has room, so logging never
+ * waits on the serial line. Messages below LOG_LEVEL are compiled out. A message that
+ * repeats exactly is counted instead of queued and printed once with "xN".
+ * Binary telemetry frames share the queue, so they never interleave with a text line.
+ */
+#pragma once
+
+#include <Arduino.h>
+#include "event_queue.h"
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO  // Messages above this level are compiled out
+#endif
+
+#define LOG_LINE_MAX 64           // Message text, longer messages are cut
+#define LOG_QUEUE_DEPTH 16        // Records waiting for the UART (power of two)
+#define LOG_REPEAT_FLUSH_MS 5000  // A run of repeats is printed at least this often
+
+struct LogRecord {
+  uint32_t timestampMs;      // millis() of the (first) message
+  uint8_t level;             // LOG_LEVEL_NONE: text holds a raw frame of repeats bytes
+  uint16_t repeats;          // Extra identical messages folded into this record
+  char text[LOG_LINE_MAX];
+};
+
+class Logger {
+public:
+  // Format and queue a message, never blocks. The format string may be in flash (PSTR).
+  void write(uint8_t level, const char* format, ...) __attribute__((format(printf, 3, 4)));
+  // Queue raw bytes (at most LOG_LINE_MAX) to be sent as they are, between log lines
+  void writeFrame(const uint8_t* data, uint8_t length);
+  // Send queued records to out while its TX buffer has room, returns when it is full
+  void drain(HardwareSerial& out);
+  // Send everything, waiting on the UART (setup only, before the scheduler runs)
+  void flush(HardwareSerial& out);
+
+  uint32_t queued() const { return queue.size(); }      // Records waiting for the UART
+  uint32_t dropped() const { return queue.dropped(); }  // Records lost because the queue was full
+  uint32_t suppressed() const { return repeatsTotal; }  // Repeats counted instead of queued
+
+private:
+  void endRepeatRun();  // Queue the "xN" record of the current run of repeats
+  bool nextLine();      // Pop and format the next record into line, false when none
+
+  EventQueue<LogRecord, LOG_QUEUE_DEPTH> queue;
+  LogRecord last = {};       // Last message queued, repeats are compared against it
+  uint32_t lastHash = 0;
+  uint16_t repeatCount = 0;  // Repeats of last not queued yet
+  uint32_t repeatStartMs = 0;
+  uint32_t repeatsTotal = 0;
+
+  char line[LOG_LINE_MAX + 24];  // Record being sent, with prefix and repeat count
+  uint8_t lineLength = 0;
+  uint8_t lineSent = 0;
+};
+
+extern Logger logger;
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(fmt, ...) logger.write(LOG_LEVEL_ERROR, PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_ERROR(fmt, ...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(fmt, ...) logger.write(LOG_LEVEL_WARN, PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_WARN(fmt, ...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(fmt, ...) logger.write(LOG_LEVEL_INFO, PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_INFO(fmt, ...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(fmt, ...) logger.write(LOG_LEVEL_DEBUG, PSTR(fmt), ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(fmt, ...) do {} while (0)
+#endif
@@ -0,0 +1,54 @@
+/*
+ * ST7735 driver subclass
+ * Gives access to protected controller functions and counts the bytes each drawing call
+ * puts on the SPI bus (address window + 2 bytes per pixel), so screens can be compared
+ * by how much they actually send.
+ */
+#pragma once
+
+#include <Adafruit_ST7735.h>
+
+#define ST7735_WINDOW_BYTES 11  // CASET + 4, RASET + 4, RAMWR
+#define ST7735_RAM_ROWS 162     // Frame memory rows, the vertical scroll works on these
+#ifndef ST77XX_VSCRDEF
+#define ST77XX_VSCRDEF 0x33     // Vertical scroll definition (older library versions lack these)
+#endif
+#ifndef ST77XX_VSCRSADD
+#define ST77XX_VSCRSADD 0x37    // Vertical scroll start address
+#endif
+
+class MyST7735 : public Adafruit_ST7735 { // Create a derived class to access protected members
+public: // Public access
+  MyST7735(int8_t cs, int8_t dc, int8_t rst) : Adafruit_ST7735(cs, dc, rst) {}// Constructor
+
+  void setColRowStartOffset(int8_t col, int8_t row) {// Set the column and row start offset
+    setColRowStart(col, row); // Call the protected function
+  }
+
+  // Drawing primitives, forwarded to the library after counting their SPI traffic
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+  void writePixel(int16_t x, int16_t y, uint16_t color) override;
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+  void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+  void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+  void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+
+  // Send a w x h block of pixels (row-major) in one address window transaction
+  void pushRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t* pixels);
+
+  // Hardware vertical scroll. The RAM rows run along the screen's x axis in rotation 3, so
+  // the screen columns x0..x1 scroll horizontally and everything outside them stays put.
+  void setScrollArea(int16_t x0, int16_t x1);  // VSCRDEF
+  void setScrollOffset(uint16_t offset);       // VSCRSADD, RAM row shown at the area's right edge
+  void resetScroll();                          // Whole RAM, no offset (normal addressing)
+
+  uint32_t spiBytes() const { return spiByteCount; } // Bytes sent since boot (wraps)
+
+private:
+  void countRect(int16_t x, int16_t y, int16_t w, int16_t h); // Add one clipped window transfer
+
+  uint32_t spiByteCount = 0;
+  uint16_t scrollTop = 0;  // First RAM row of the scroll area
+};
@@ -0,0 +1,177 @@
+/*
+ * Compressed ring of timestamped readings
+ * The interface of RingHistory<CentiC, N>, but the readings are bit-packed with the series
+ * codes (series_codec.h) into BLOCKS blocks of BLOCK_BYTES. A reading goes into the newest
+ * block, when it does not fit a new block is started and once all are in use the oldest
+ * block is dropped as a whole, so the number of readings held depends on how much the
+ * temperature moves: at one reading per second 2-6 bits each instead of 6 bytes.
+ *
+ * Each block keeps its own min/max and the closed blocks a combined one, so min()/max()
+ * stay O(1). newest() is kept unpacked. [] decodes from the start of the block, but keeps
+ * its place, so reading forward through the history (iterators, the strip chart backfill)
+ * decodes every reading once.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "centi_temp.h"
+#include "history.h"
+#include "series_codec.h"
+
+#ifndef HISTORY_BLOCKS
+#define HISTORY_BLOCKS 8        // At least 7 full blocks are kept
+#endif
+#ifndef HISTORY_BLOCK_BYTES
+#define HISTORY_BLOCK_BYTES 96  // 59 readings at the noisiest, 300+ at steady temperature
+#endif
+
+template <uint8_t BLOCKS, uint16_t BLOCK_BYTES>
+class PackedHistory {
+  static_assert(BLOCKS >= 2, "PackedHistory needs at least two blocks");
+
+public:
+  // Forward iterator, oldest to newest
+  class Iterator {
+  public:
+    Iterator(const PackedHistory* history, uint16_t index) : history(history), index(index) {}
+    HistorySample<CentiC> operator*() const { return (*history)[index]; }
+    Iterator& operator++() { index++; return *this; }
+    bool operator!=(const Iterator& other) const { return index != other.index; }
+
+  private:
+    const PackedHistory* history;
+    uint16_t index;
+  };
+
+  void push(uint32_t timestampMs, CentiC value) {
+    if (blockCount > 0) {
+      Block& open = block(blockCount - 1);
+      BitWriter out(open.data, BLOCK_BYTES, open.bits);
+      if (seriesAppend(out, tail, timestampMs, value.raw)) {
+        open.bits = out.bits();
+        open.count++;
+        if (value < open.min) open.min = value;
+        if (value > open.max) open.max = value;
+        count++;
+        pushes++;
+        return;
+      }
+    }
+    openBlock(timestampMs, value);
+    count++;
+    pushes++;
+  }
+
+  void clear() { head = blockCount = 0; count = 0; }
+
+  // i = 0 is the oldest sample, size() - 1 the newest
+  HistorySample<CentiC> operator[](uint16_t i) const {
+    if (i + 1 == count) return newest();
+    uint32_t seq = pushes - count + i;  // Readings are numbered from boot
+    if (!cursor.valid || seq < cursor.seq || !holds(cursor.slot, cursor.seq) || !holds(cursor.slot, seq)) seek(seq);
+    BitReader in(blocks[cursor.slot].data, cursor.bits);
+    while (cursor.seq < seq) {
+      seriesNext(in, cursor.point);
+      cursor.seq++;
+    }
+    cursor.bits = in.bits();
+    return { cursor.point.time, CentiC::fromCenti(cursor.point.value) };
+  }
+  HistorySample<CentiC> newest() const { return { tail.time, CentiC::fromCenti(tail.value) }; }
+  HistorySample<CentiC> oldest() const { return { block(0).firstTime, block(0).first }; }
+
+  // Only valid when !empty()
+  CentiC min() const {
+    CentiC open = block(blockCount - 1).min;
+    return blockCount > 1 && closedMin < open ? closedMin : open;
+  }
+  CentiC max() const {
+    CentiC open = block(blockCount - 1).max;
+    return blockCount > 1 && closedMax > open ? closedMax : open;
+  }
+
+  uint16_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  uint32_t totalPushed() const { return pushes; }  // Readings since boot, including dropped ones
+  uint16_t packedBytes() const {                   // Bytes of packed readings in use
+    uint32_t bits = 0;
+    for (uint8_t i = 0; i < blockCount; i++) bits += block(i).bits;
+    return (uint16_t)((bits + 7) / 8);
+  }
+  static constexpr uint8_t blockCapacity() { return BLOCKS; }
+
+  Iterator begin() const { return Iterator(this, 0); }
+  Iterator end() const { return Iterator(this, count); }
+
+private:
+  struct Block {
+    uint32_t firstSeq;   // Number of the first reading
+    uint32_t firstTime;  // The first reading in full, the rest are packed
+    CentiC first;
+    CentiC min;
+    CentiC max;
+    uint16_t count;
+    uint16_t bits;       // Packed bits in use
+    uint8_t data[BLOCK_BYTES];
+  };
+
+  // Decoder position of [], one reading behind the next to decode
+  struct Cursor {
+    bool valid = false;
+    uint8_t slot;
+    uint16_t bits;
+    uint32_t seq;
+    SeriesPoint point;
+  };
+
+  void openBlock(uint32_t timestampMs, CentiC value) {
+    if (blockCount == BLOCKS) {
+      count -= block(0).count;
+      head = (head + 1) % BLOCKS;
+      blockCount--;
+    }
+    // The open block becomes a closed one, fold the closed ones again
+    for (uint8_t i = 0; i < blockCount; i++) {
+      const Block& b = block(i);
+      if (i == 0 || b.min < closedMin) closedMin = b.min;
+      if (i == 0 || b.max > closedMax) closedMax = b.max;
+    }
+    Block& b = blocks[(head + blockCount) % BLOCKS];
+    b.firstSeq = pushes;
+    b.firstTime = timestampMs;
+    b.first = b.min = b.max = value;
+    b.count = 1;
+    b.bits = 0;
+    blockCount++;
+    tail = { timestampMs, 0, value.raw };
+  }
+
+  // Whether the block in slot is in use and holds reading seq
+  bool holds(uint8_t slot, uint32_t seq) const {
+    return (uint8_t)((slot + BLOCKS - head) % BLOCKS) < blockCount && seq - blocks[slot].firstSeq < blocks[slot].count;
+  }
+
+  // Put the cursor on the first reading of the block holding seq
+  void seek(uint32_t seq) const {
+    uint8_t i = blockCount - 1;
+    while (i > 0 && block(i).firstSeq > seq) i--;  // Newest first, [] is mostly used near the end
+    const Block& b = block(i);
+    cursor.valid = true;
+    cursor.slot = (head + i) % BLOCKS;
+    cursor.bits = 0;
+    cursor.seq = b.firstSeq;
+    cursor.point = { b.firstTime, 0, b.first.raw };
+  }
+
+  Block& block(uint8_t i) { return blocks[(head + i) % BLOCKS]; }
+  const Block& block(uint8_t i) const { return blocks[(head + i) % BLOCKS]; }
+
+  Block blocks[BLOCKS];
+  uint8_t head = 0;        // Slot of the oldest block
+  uint8_t blockCount = 0;  // Blocks in use, the newest one is open
+  uint16_t count = 0;      // Readings stored
+  uint32_t pushes = 0;
+  SeriesPoint tail = {};   // Newest reading, where the next one is packed from
+  CentiC closedMin, closedMax;
+  mutable Cursor cursor;
+};
@@ -0,0 +1,84 @@
+/*
+ * Profiling zones
+ * PROFILE_ZONE("name") at the top of a block times the rest of the block with the CPU
+ * cycle counter (ESP.getCycleCount(), one register read) and folds the duration into a
+ * static per-zone record: call count, total, max and a log2 histogram. No heap, and
+ * nothing at all is compiled in when PROFILE_ENABLE is 0.
+ *
+ * Zones nest, an outer zone includes the time of the inner ones. The cycle counter wraps
+ * after 53 s at 80 MHz, far beyond any zone. The native build backs getCycleCount() with
+ * a steady clock at 80 cycles per microsecond, so the same zones measure host time there.
+ *
+ * Histogram bucket 0 counts zones shorter than 2^8 cycles, bucket i (1..14) those of
+ * 2^(i+7) up to 2^(i+8) cycles, the last bucket everything from 2^22 cycles (52 ms) up.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+#ifndef PROFILE_ENABLE
+#define PROFILE_ENABLE 1  // 0 compiles the zones and the profiler table out
+#endif
+
+#define PROFILE_MAX_ZONES 8      // Size of the static zone table
+#define PROFILE_HIST_BUCKETS 16  // log2 histogram buckets per zone
+#define PROFILE_HIST_MIN_BITS 8  // Bucket 0 holds durations below 2^8 cycles
+#define PROFILE_NO_ZONE 0xFF     // zone() result when the table is full
+
+#if PROFILE_ENABLE
+
+struct ProfileZone {
+  const char* name;
+  uint32_t calls;
+  uint32_t maxCycles;
+  uint64_t totalCycles;
+  uint32_t hist[PROFILE_HIST_BUCKETS];
+};
+
+class Profiler {
+public:
+  // Find or register the zone called name, PROFILE_NO_ZONE when the table is full
+  uint8_t zone(const char* name);
+  void record(uint8_t id, uint32_t cycles);
+  void reset();  // Clear the figures, the zones stay registered
+
+  uint8_t zoneCount() const { return count; }
+  const ProfileZone& entry(uint8_t id) const { return zones[id]; }
+  // Upper bound in cycles of the bucket holding the given percentile of the calls
+  uint32_t percentileCycles(uint8_t id, uint8_t percent) const;
+
+  // Serial dump, one line at a time so it can go through the log queue
+  void startDump() { dumpNext = 0; }
+  bool dumpLine(char* line, size_t size);  // False when there is nothing (more) to dump
+
+private:
+  ProfileZone zones[PROFILE_MAX_ZONES];
+  uint8_t count = 0;
+  int16_t dumpNext = -1;  // -1 = no dump running, 0 = the legend is next, then zone dumpNext - 1
+};
+
+extern Profiler profiler;
+
+// Times its own lifetime
+class ProfileScope {
+public:
+  explicit ProfileScope(uint8_t id) : id(id), start(ESP.getCycleCount()) {}
+  ~ProfileScope() { profiler.record(id, ESP.getCycleCount() - start); }
+
+private:
+  uint8_t id;
+  uint32_t start;
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+// The zone is looked up once per call site, then the cost is two counter reads and record()
+#define PROFILE_ZONE(name)                                                       \
+  static const uint8_t PROFILE_CONCAT(profileZoneId, __LINE__) = profiler.zone(name); \
+  ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(PROFILE_CONCAT(profileZoneId, __LINE__))
+
+#else
+
+#define PROFILE_ZONE(name) do {} while (0)
+
+#endif
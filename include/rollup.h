@@ -0,0 +1,113 @@
+/*
+ * Fixed-size downsampled history
+ * A RollupTier keeps the last N buckets of a fixed period (e.g. one minute). Each reading
+ * is folded into the open bucket's min/max/sum/count as it arrives, so a tier can be read
+ * at any time without going back to the raw samples. Periods without readings become
+ * empty buckets, which keeps bucket i at a known time offset.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "centi_temp.h"
+
+#define ROLLUP_MINUTE_MS 60000UL
+#define ROLLUP_HOUR_MS 3600000UL
+
+struct RollupBucket {
+  uint32_t period;  // timestamp / periodMs of the bucket
+  CentiC min;
+  CentiC max;
+  int32_t sum;      // Of the raw values, 65535 readings of 327.67 C still fit
+  uint16_t count;   // Readings folded in, 0 = no data for this period
+
+  CentiC mean() const { return centiMean(sum, count); }
+
+  void add(CentiC value) {
+    if (count == 0 || value < min) min = value;
+    if (count == 0 || value > max) max = value;
+    sum += value.raw;
+    count++;
+  }
+
+  // Fold another bucket in (for summaries over several buckets)
+  void merge(const RollupBucket& other) {
+    if (other.count == 0) return;
+    if (count == 0 || other.min < min) min = other.min;
+    if (count == 0 || other.max > max) max = other.max;
+    sum += other.sum;
+    count += other.count;
+  }
+};
+
+// Summary over many buckets: a week of readings overflows a bucket's 16-bit count and, once
+// it averages above 35.5 C, its 32-bit sum
+struct RollupSummary {
+  CentiC min;
+  CentiC max;
+  int64_t sum;      // Of the raw values
+  uint32_t count;   // Readings, 0 = no data
+
+  CentiC mean() const {
+    if (count == 0) return { 0 };
+    int64_t half = count / 2;
+    return CentiC::fromCenti((int32_t)(sum < 0 ? (sum - half) / (int64_t)count : (sum + half) / (int64_t)count));
+  }
+
+  void merge(const RollupBucket& bucket) {
+    if (bucket.count == 0) return;
+    if (count == 0 || bucket.min < min) min = bucket.min;
+    if (count == 0 || bucket.max > max) max = bucket.max;
+    sum += bucket.sum;
+    count += bucket.count;
+  }
+};
+
+template <uint16_t N>
+class RollupTier {
+  static_assert(N >= 2, "RollupTier needs at least two buckets");
+
+public:
+  explicit RollupTier(uint32_t periodMs) : periodMs(periodMs) {}
+
+  void add(uint32_t timestampMs, CentiC value) {
+    uint32_t period = timestampMs / periodMs;
+    if (count == 0) {
+      open(period);
+    } else if (period != newest().period) {
+      // Close the open bucket, with empty ones for any periods that had no readings
+      uint32_t gap = period - newest().period;  // Also covers the millis() wrap (treated as a long gap)
+      if (gap > N) gap = N;
+      for (uint32_t i = 1; i < gap; i++) open(period - gap + i);
+      open(period);
+    }
+    buckets[index(count - 1)].add(value);
+  }
+
+  // i = 0 is the oldest bucket, size() - 1 the open one
+  const RollupBucket& operator[](uint16_t i) const { return buckets[index(i)]; }
+  const RollupBucket& newest() const { return buckets[index(count - 1)]; }
+  uint16_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  static constexpr uint16_t capacity() { return N; }
+
+  // Summary of the newest n buckets
+  RollupBucket summary(uint16_t n) const {
+    RollupBucket total = {};
+    if (n > count) n = count;
+    for (uint16_t i = count - n; i < count; i++) total.merge((*this)[i]);
+    return total;
+  }
+
+private:
+  void open(uint32_t period) {
+    if (count == N) head = (head + 1) % N;  // Overwrite the oldest bucket
+    else count++;
+    buckets[index(count - 1)] = { period, {}, {}, 0, 0 };
+  }
+  uint16_t index(uint16_t i) const { return (uint16_t)((head + i) % N); }
+
+  uint32_t periodMs;
+  RollupBucket buckets[N];
+  uint16_t head = 0;   // Slot of the oldest bucket
+  uint16_t count = 0;  // Buckets in use
+};
@@ -0,0 +1,48 @@
+/*
+ * Cooperative task scheduler
+ * Runs periodic tasks from loop() against millis() deadlines and keeps per-task
+ * runtime and overrun counters so the loop budget can be inspected on the Diagnostics screen.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+#define SCHEDULER_MAX_TASKS 8  // Size of the static task table
+
+typedef void (*TaskCallback)();  // Task body, must do a bounded amount of work and return
+
+struct SchedulerTask {
+  const char* name;       // Short name shown on the Diagnostics screen
+  TaskCallback callback;  // Function run when the task is due
+  uint32_t periodMs;      // Interval between runs (0 = run on every scheduler tick)
+  uint32_t budgetUs;      // Runtime budget, a run longer than this counts as an overrun
+  uint32_t nextRunMs;     // Deadline of the next run
+  uint32_t runCount;      // Completed runs
+  uint32_t overrunCount;  // Runs that took longer than budgetUs
+  uint32_t lateCount;     // Runs that started a full period or more after their deadline
+  uint32_t lastRunUs;     // Duration of the last run
+  uint32_t maxRunUs;      // Longest run seen
+  uint64_t totalRunUs;    // Total time spent in the task
+  bool enabled;           // Disabled tasks keep their stats but are skipped
+};
+
+class Scheduler {
+public:
+  // Register a task, returns its id or -1 when the table is full
+  int addTask(const char* name, TaskCallback callback, uint32_t periodMs, uint32_t budgetUs);
+  // Enable or disable a task, a re-enabled task runs on the next tick
+  void setEnabled(int id, bool enabled);
+  // Run every task that is due, call once per loop()
+  void run();
+  // Clear the runtime and overrun counters of all tasks
+  void resetStats();
+
+  uint8_t taskCount() const { return count; }
+  const SchedulerTask& task(uint8_t id) const { return tasks[id]; }
+  uint32_t tickCount() const { return ticks; }
+
+private:
+  SchedulerTask tasks[SCHEDULER_MAX_TASKS];
+  uint8_t count = 0;
+  uint32_t ticks = 0;
+};
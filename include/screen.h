@@ -0,0 +1,86 @@
+/*
+ * Screen framework
+ * The menu and the screens behind it are a table of ScreenDef entries, in menu order. The
+ * manager owns navigation and decides when to draw:
+ *
+ *   enter   the screen was opened: draw the static content (the screen is not cleared first)
+ *   update  polled every tick while open, returns true when something it shows has changed
+ *   render  draw what changed, called only while the screen is dirty
+ *   input   a button event while open, returns true when used (otherwise BACK closes it)
+ *   leave   the screen is closing (optional, e.g. to stop a hardware scroll)
+ *
+ * A screen is dirty after enter, after input it used, after markDirty() (new reading, clock
+ * second) and when update() says so. Input is drawn as soon as it is handled, everything else
+ * waits for the next tick. The menu itself repaints only the rows that changed:
+ * the old and new cursor rows, or every visible row when the window scrolls.
+ */
+#pragma once
+
+#include <Adafruit_GFX.h>
+#include "buttons.h"
+#include "text_field.h"
+
+#ifndef SCREEN_MENU_ROWS
+#define SCREEN_MENU_ROWS 5         // Menu rows visible at a time
+#endif
+#define SCREEN_MENU_ROW_HEIGHT 20  // Pixels between menu rows
+#define SCREEN_MENU_TOP 30         // Baseline of the first menu row
+#define SCREEN_HINT_Y 90           // Baseline of the button hints
+
+// Indexes of the buttons in ButtonEvent::button
+#define SCREEN_KEY_UP 0
+#define SCREEN_KEY_SELECT 1
+#define SCREEN_KEY_BACK 2
+
+struct ScreenDef {
+  const char* name;                          // Menu label
+  const char* hint;                          // Button hints at the bottom, nullptr = none
+  void (*enter)();
+  void (*render)();                          // nullptr for a screen without changing content
+  bool (*update)();                          // Optional
+  bool (*input)(const ButtonEvent& event);   // Optional
+  void (*leave)();                           // Optional
+};
+
+class ScreenManager {
+public:
+  ScreenManager(Adafruit_GFX& gfx, const ScreenDef* screens, uint8_t count, const GFXfont* font, uint16_t color,
+                uint16_t bg)
+    : gfx(gfx), screens(screens), count(count), font(font), color(color), bg(bg) {}
+
+  void begin();                           // Show the menu
+  bool tick();                            // Screen task: returns true when something was drawn
+  void handle(const ButtonEvent& event);  // PRESS and REPEAT events
+  void markDirty() { dirty = true; }      // Something any screen may show has changed
+  void restart();                         // Enter the open screen again (e.g. a new layout)
+
+  void open(uint8_t index);
+  void close();
+  bool isOpen() const { return openIndex >= 0; }
+  int8_t openScreen() const { return openIndex; }  // -1 while the menu is shown
+  uint32_t renders() const { return renderCount; }
+  uint32_t skippedTicks() const { return skipCount; }  // Ticks with nothing to draw
+
+private:
+  void enterMenu();
+  void drawMenuRow(uint8_t row);
+
+  Adafruit_GFX& gfx;
+  const ScreenDef* screens;
+  uint8_t count;
+  const GFXfont* font;
+  uint16_t color, bg;
+
+  int8_t openIndex = -1;
+  bool dirty = false;
+  uint8_t cursor = 0;       // Menu entry under the cursor
+  uint8_t firstRow = 0;     // Menu entry on the top visible row
+  uint8_t shownCursor = 0;  // Cursor and window as drawn
+  uint8_t shownFirst = 0;
+  bool menuValid = false;   // False until the menu is drawn in full
+  uint32_t renderCount = 0;
+  uint32_t skipCount = 0;
+
+  TextField menuRows[SCREEN_MENU_ROWS];
+  TextField hintField;
+};
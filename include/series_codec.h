@@ -0,0 +1,73 @@
+/*
+ * Bit-packed time series codes (Gorilla style)
+ * Readings arrive at a steady rate and the temperature moves slowly, so a sample is stored
+ * as the change of its time step (delta-of-delta) and the change of its value, each as a
+ * zigzag number behind a prefix that picks the width:
+ *
+ *   zigzag value       time step change        value change
+ *   0                  '0'                     '0'
+ *   < 2^a              '10'   + a bits (a=7)   '10'   + a bits (a=6)
+ *   < 2^b              '110'  + b bits (b=9)   '110'  + b bits (b=8)
+ *   < 2^c              '1110' + c bits (c=12)  '1110' + c bits (c=12)
+ *   other              '1111' + 32 bits        '1111' + 32 bits
+ *
+ * A steady 1 s reading with an unchanged value costs 2 bits instead of 6 bytes. The value
+ * widths fit the ADC steps seen in the serial captures (about 0.15 C and 0.8-1.3 C).
+ * Bits are written MSB first into a byte buffer. The first sample of a block is kept in
+ * full by the caller, SeriesPoint carries the state from one sample to the next.
+ *
+ * Plain C++ (no Arduino headers), shared by the in-memory history and the flash log.
+ */
+#pragma once
+
+#include <stdint.h>
+
+class BitWriter {
+public:
+  BitWriter(uint8_t* data, uint16_t bytes, uint16_t bitPos = 0) : data(data), capacity((uint32_t)bytes * 8), pos(bitPos) {}
+  bool fits(uint32_t bits) const { return pos + bits <= capacity; }
+  void put(uint32_t value, uint8_t bits);  // Low bits of value, the caller checks fits()
+  uint16_t bits() const { return (uint16_t)pos; }
+
+private:
+  uint8_t* data;
+  uint32_t capacity;
+  uint32_t pos;
+};
+
+class BitReader {
+public:
+  BitReader(const uint8_t* data, uint16_t bitPos = 0) : data(data), pos(bitPos) {}
+  uint32_t get(uint8_t bits);
+  uint16_t bits() const { return pos; }
+
+private:
+  const uint8_t* data;
+  uint16_t pos;
+};
+
+// Time step changes (delta-of-delta)
+uint8_t timeCodeLength(int32_t change);
+void putTimeCode(BitWriter& out, int32_t change);
+int32_t getTimeCode(BitReader& in);
+
+// Value changes
+uint8_t valueCodeLength(int32_t change);
+void putValueCode(BitWriter& out, int32_t change);
+int32_t getValueCode(BitReader& in);
+
+// Changes in unsigned arithmetic, they wrap instead of overflowing
+inline int32_t seriesChange(int32_t to, int32_t from) { return (int32_t)((uint32_t)to - (uint32_t)from); }
+inline int32_t seriesApply(int32_t from, int32_t change) { return (int32_t)((uint32_t)from + (uint32_t)change); }
+
+// Last sample of a series and the time step that led to it
+struct SeriesPoint {
+  uint32_t time;
+  int32_t step;
+  int32_t value;
+};
+
+// Append (time, value) after last, false (nothing written) when it does not fit
+bool seriesAppend(BitWriter& out, SeriesPoint& last, uint32_t time, int32_t value);
+// Decode the sample after last into last
+void seriesNext(BitReader& in, SeriesPoint& last);
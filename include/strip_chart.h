@@ -0,0 +1,48 @@
+/*
+ * Scrolling strip chart
+ * Uses the ST7735 hardware vertical scroll: every new value draws a single column at the
+ * right edge and moves the scroll offset, so the rest of the chart is never resent.
+ * Columns that scroll out on the left are overwritten by the next ones.
+ */
+#pragma once
+
+#include "my_st7735.h"
+#include "centi_temp.h"
+
+#define STRIP_CHART_MAX_ROWS 128  // Tallest column (screen height in rotation 3)
+#define STRIP_CHART_TICK_ROWS 3   // Length of the time ticks under the plot
+
+class StripChart {
+public:
+  explicit StripChart(MyST7735& tft) : tft(tft) {}
+
+  // Clear and start scrolling screen columns x0..x1, values minValue..maxValue map to rows bottom..top
+  void begin(int16_t x0, int16_t x1, int16_t top, int16_t bottom, CentiC minValue, CentiC maxValue, uint16_t bg);
+  // Dashed reference lines drawn into every new column (e.g. the alert limits)
+  void setLimits(CentiC low, CentiC high, uint16_t color);
+  // Join consecutive values with a vertical segment instead of single dots
+  void setJoinPoints(bool join) { joinPoints = join; }
+  // Add one column at the right edge, tick = draw a time mark under it
+  void push(CentiC value, uint16_t color, bool tick);
+  // Stop scrolling, the screen goes back to normal addressing
+  void end();
+
+  bool active() const { return running; }
+  uint32_t columns() const { return pushed; } // Columns added since begin()
+
+private:
+  int16_t rowFor(CentiC value) const; // Screen row of a value, clamped to the plot
+
+  MyST7735& tft;
+  bool running = false;
+  int16_t x0 = 0, x1 = 0, top = 0, bottom = 0;
+  int32_t minValue = 0, maxValue = 1;  // Raw centi-C
+  uint16_t bg = 0;
+  int16_t lowRow = -1, highRow = -1; // Limit rows, -1 = none
+  uint16_t limitColor = 0;
+  bool joinPoints = false;
+  uint16_t offset = 0;      // Scroll offset, the RAM column shown at the right edge is x1 - offset
+  int16_t lastRow = -1;     // Row of the previous value, joins the points in line style
+  uint32_t pushed = 0;
+  uint16_t column[STRIP_CHART_MAX_ROWS + STRIP_CHART_TICK_ROWS + 1];
+};
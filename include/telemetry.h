@@ -0,0 +1,88 @@
+/*
+ * Binary telemetry frames
+ * One frame per reading: timestamp, ADC code, temperature and fan/alert flags. Most frames
+ * carry only the change from the previous reading as (zigzag) varints, every
+ * TELEMETRY_KEYFRAME_EVERY-th frame is a keyframe with absolute values so a decoder can
+ * start or recover mid-stream. The payload plus a CRC-16 is COBS encoded and framed by
+ * 0x00 on both sides, so frames survive being mixed with text log lines on the same UART.
+ *
+ * Payload: [type << 5 | flags] [seq] fields... [crc16 LE]
+ *   keyframe: varint timestampMs, varint adcQ4, zigzag centiC
+ *   delta:    varint dt ms,       zigzag dAdcQ4, zigzag dCentiC
+ *
+ * Plain C++ (no Arduino headers), the host decoder in tools/ links this file as well.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef TELEMETRY_BINARY
+#define TELEMETRY_BINARY 0           // 1 = send a frame per reading instead of the temperature log line
+#endif
+#ifndef TELEMETRY_KEYFRAME_EVERY
+#define TELEMETRY_KEYFRAME_EVERY 16  // Frames between keyframes (lost frames cost at most this many)
+#endif
+
+#define TELEMETRY_PAYLOAD_MAX 20     // Longest keyframe payload with its CRC
+#define TELEMETRY_FRAME_MAX 24       // Longest encoded frame with both delimiters
+
+#define TELEMETRY_TYPE_KEY 1
+#define TELEMETRY_TYPE_DELTA 2
+
+#define TELEMETRY_FLAG_FAN 0x01      // Blower running
+#define TELEMETRY_FLAG_HIGH 0x02     // Above the high temperature alert
+#define TELEMETRY_FLAG_LOW 0x04      // Below the low temperature alert
+#define TELEMETRY_FLAG_EARLY 0x08    // High temperature predicted within the warning horizon
+
+struct TelemetrySample {
+  uint32_t timestampMs;
+  uint16_t adcQ4;     // Outlier-rejected ADC burst, 1/16 code
+  int32_t centiC;     // Temperature in 0.01 C
+  uint8_t flags;      // TELEMETRY_FLAG_*
+};
+
+class TelemetryEncoder {
+public:
+  // Encode the next frame into out (TELEMETRY_FRAME_MAX bytes), returns its length
+  size_t encode(const TelemetrySample& sample, uint8_t* out);
+  // Make the next frame a keyframe
+  void reset() { sent = 0; }
+
+private:
+  TelemetrySample prev = {};
+  uint32_t sent = 0;  // Frames since the last reset
+};
+
+class TelemetryDecoder {
+public:
+  enum Result {
+    NONE,      // Byte consumed, no frame completed
+    SAMPLE,    // sample holds a decoded reading
+    BAD,       // A short chunk between delimiters failed COBS/CRC/format checks (or was text)
+    SKIPPED,   // A valid delta frame arrived after a lost frame, waiting for a keyframe
+  };
+
+  // Feed one received byte
+  Result feed(uint8_t byte, TelemetrySample& sample);
+
+  uint32_t samples = 0;  // Frames decoded
+  uint32_t bad = 0;      // Chunks that failed the checks
+  uint32_t skipped = 0;  // Delta frames dropped while out of sync
+  uint32_t lost = 0;     // Frames missing according to the sequence numbers
+
+private:
+  Result decodeChunk(TelemetrySample& sample);
+
+  uint8_t chunk[TELEMETRY_FRAME_MAX];
+  uint8_t chunkLength = 0;
+  bool oversized = false;  // Current chunk is longer than any frame (a text line)
+  bool synced = false;     // prev is valid, delta frames can be applied
+  uint8_t nextSeq = 0;
+  TelemetrySample prev = {};
+};
+
+// Building blocks
+uint16_t telemetryCrc16(const uint8_t* data, size_t length);             // CRC-16/CCITT-FALSE
+size_t cobsEncode(const uint8_t* in, size_t length, uint8_t* out);       // out needs length + length/254 + 1
+size_t cobsDecode(const uint8_t* in, size_t length, uint8_t* out);       // 0 if malformed
@@ -0,0 +1,101 @@
+/*
+ * Over-temperature prediction
+ * A straight line is fitted to the recent readings by least squares with exponentially
+ * decaying weights (time constant PREDICT_TAU_S), so the fit follows the last few minutes
+ * and needs no stored readings: each reading updates five weighted sums in O(1).
+ *
+ *   rate     slope of the fit, centi-degrees C per minute (dT/dt)
+ *   level    fitted temperature at the newest reading (the noise of one ADC step averaged out)
+ *   eta      (limit - level) / rate, seconds until the limit is reached at the current rate
+ *
+ * A line fitted across a turn (a rise that levels off or reverses) overshoots and its slope
+ * lags, so no crossing is predicted while the newest reading is more than PREDICT_MAX_DROP
+ * below the fitted level.
+ *
+ * The sums are integers: weights in Q16, t in whole seconds and y in centi-degrees, both
+ * relative to the newest reading, so they are shifted when a reading arrives and stay small
+ * whatever the uptime. A reading multiplies the sums by the precomputed decay of one second,
+ * once per second elapsed. The fit drops them to Q4 first so its products fit in 64 bits
+ * for time constants up to PREDICT_MAX_TAU_S.
+ *
+ * update() turns the estimate into an early warning: raised once the limit has been predicted
+ * within the horizon for PREDICT_CONFIRM_S, held for at least PREDICT_HOLD_S and then cleared
+ * when the prediction moves past PREDICT_CLEAR_PCT of the horizon or the temperature stops
+ * rising. Reaching the limit clears it at once, the high alert takes over.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "centi_temp.h"
+
+#ifndef PREDICT_TAU_S
+#define PREDICT_TAU_S 60             // Fit time constant, seconds
+#endif
+#define PREDICT_MAX_TAU_S 120        // The integer sums are sized for this
+#define PREDICT_MIN_SAMPLES 30       // Readings before the first prediction
+#define PREDICT_MIN_RATE 6           // Centi-degrees per minute (0.06 C/min), slower is "not rising"
+#define PREDICT_MAX_ETA_S 86400      // Longer predictions are reported as none
+#define PREDICT_MAX_DROP 50          // Centi-degrees the newest reading may sit below the fit, more means the rise has ended
+#ifndef PREDICT_CONFIRM_S
+#define PREDICT_CONFIRM_S 10         // The crossing must stay predicted this long to raise the warning
+#endif
+#ifndef PREDICT_HOLD_S
+#define PREDICT_HOLD_S 60            // A raised warning stays at least this long
+#endif
+#define PREDICT_CLEAR_PCT 150        // Warning clears beyond this % of the horizon
+#define PREDICT_MAX_STEP_S 10        // Longer gaps between readings count as this
+#define PREDICT_WEIGHT_BITS 16       // Fractional bits of the weights
+#define PREDICT_FIT_SHIFT 12         // The fit works on the sums in Q4
+#define PREDICT_RATE_BITS 8          // Fractional bits of the fitted rate
+
+// exp(-1 / tau) in Q16, the weight lost per second, by its series (tau >= 1, so it converges quickly)
+constexpr uint32_t predictDecayQ16(double tau) {
+  double x = -1.0 / tau;
+  double term = 1.0;
+  double sum = 1.0;
+  for (int n = 1; n < 12; n++) {
+    term *= x / n;
+    sum += term;
+  }
+  return (uint32_t)(sum * (1UL << PREDICT_WEIGHT_BITS) + 0.5);
+}
+
+#define PREDICT_DECAY_Q16 predictDecayQ16(PREDICT_TAU_S)  // 64453 for 60 s
+
+// User settings, edited on the Settings screen
+struct PredictSettings {
+  uint8_t horizonMin = 5;            // Warn this long before the predicted crossing, 0 = off
+  uint8_t fanPrestart = 1;           // Also start the fan at its minimum duty
+};
+
+class TempPredictor {
+public:
+  // Fold in a reading, then evaluate the warning against limit, true while it is raised
+  bool update(uint32_t timestampMs, CentiC value, CentiC limit);
+
+  bool ready() const { return samples >= PREDICT_MIN_SAMPLES; }
+  CentiC ratePerMin() const;                                     // Centi-degrees C per minute
+  CentiC level() const { return CentiC::fromCenti(fitLevel); }
+  // Seconds until limit at the current rate, -1 when it is not being approached
+  int32_t etaSeconds(CentiC limit) const;
+  bool warning() const { return warned; }
+  uint32_t warnings() const { return warnCount; }                // Warnings raised since boot
+
+  PredictSettings settings;
+
+private:
+  void fit();
+
+  // Weighted sums over the readings in Q16, t in seconds and y in centi-degrees relative to the newest reading
+  int64_t s0 = 0, st = 0, stt = 0, sy = 0, sty = 0;
+  int32_t reference = 0;               // y of the newest reading, centi-degrees
+  uint32_t lastMs = 0;                 // Time of the newest reading, advanced in whole seconds
+  uint32_t samples = 0;
+  int32_t rateQ8 = 0;                  // Slope of the fit, centi-degrees per minute in Q8
+  int32_t fitLevel = 0;                // The line at the newest reading, centi-degrees
+  bool haveFit = false;
+  bool warned = false;
+  uint32_t changeMs = 0;               // Since when the crossing is predicted (not warned) or the warning raised
+  bool predicted = false;
+  uint32_t warnCount = 0;
+};
@@ -0,0 +1,40 @@
+/*
+ * Retained-mode text field
+ * A field remembers the string it last drew at a fixed cursor position. Drawing a new
+ * string repaints only the glyph cells that changed, each cleared with one tight fillRect,
+ * instead of clearing the screen and printing everything again.
+ * Glyphs are assumed to stay inside their advance cell (true for TomThumb and the built-in
+ * font), so clearing one cell never touches a neighbour.
+ */
+#pragma once
+
+#include <Adafruit_GFX.h>
+
+#define TEXT_FIELD_MAX_CHARS 40  // A full 160 px line of TomThumb, longer strings are cut
+#define TEXT_FIELD_LINE_BUFFER 64  // snprintf() buffer for a line of counters: every count fits at full width, draw() cuts
+
+class TextField {
+public:
+  // x/y is the text cursor (the baseline for GFX fonts), font nullptr = built-in 6x8 font
+  TextField(int16_t x = 0, int16_t y = 0, const GFXfont* font = nullptr, uint8_t size = 1)
+    : x(x), y(y), font(font), size(size) {}
+
+  // Draw text, only glyphs that differ from the previous call are repainted
+  void draw(Adafruit_GFX& gfx, const char* text, uint16_t color, uint16_t bg);
+  // The area was repainted by someone else (e.g. a new screen), so the next draw starts fresh
+  void invalidate() { valid = false; }
+
+private:
+  int16_t advance(char c) const;                      // Horizontal advance of one glyph
+  int16_t textWidth(const char* s, size_t n) const;   // Advance of n glyphs
+  void measureLine();                                 // Vertical extent of the font
+
+  int16_t x, y;
+  const GFXfont* font;
+  uint8_t size;
+  char last[TEXT_FIELD_MAX_CHARS + 1] = "";
+  uint16_t lastColor = 0;
+  bool valid = false;
+  int16_t top = 0;     // First row of the line box relative to y
+  int16_t height = 0;  // Height of the line box, 0 until measured
+};
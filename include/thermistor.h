@@ -0,0 +1,90 @@
+/*
+ * Thermistor ADC-to-temperature conversion
+ * The Beta equation (with the calibration offset folded in) is evaluated at compile time
+ * for every THERMISTOR_TABLE_STEP-th ADC code; at run time a reading costs one table
+ * lookup and one fixed-point interpolation, no float or log() on the ESP8266.
+ * Against the float formula the error stays within THERMISTOR_MAX_ERROR_CENTI over the
+ * codes the sensor actually reads; --bench in the native build checks it.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "centi_temp.h"
+
+#ifndef THERMISTOR_BETA
+#define THERMISTOR_BETA 3950.0  // BETA coefficient of the thermistor
+#endif
+#ifndef THERMISTOR_R0
+#define THERMISTOR_R0 10000.0   // Resistance of the thermistor at 25°C (10k ohms)
+#endif
+#ifndef THERMISTOR_T0
+#define THERMISTOR_T0 298.15    // Reference temperature in Kelvin (25°C)
+#endif
+#ifndef THERMISTOR_OFFSET_C
+#define THERMISTOR_OFFSET_C 40.0  // Temperature offset correction
+#endif
+
+#define ADC_MAX_CODE 1023                                     // 10-bit ADC full scale
+#define ADC_FRACTION_BITS 4                                   // Fractional bits of a filtered (Q4) ADC code
+#define THERMISTOR_TABLE_SHIFT 3                              // Table holds every 8th ADC code
+#define THERMISTOR_TABLE_STEP (1 << THERMISTOR_TABLE_SHIFT)
+#define THERMISTOR_TABLE_SIZE ((ADC_MAX_CODE + 1) / THERMISTOR_TABLE_STEP + 1)
+#define THERMISTOR_CHECKED_FROM 30                            // ADC codes 30..800 (3..97 C) are within the bound,
+#define THERMISTOR_CHECKED_TO 800                             // the curve gets too steep towards the rails
+#define THERMISTOR_MAX_ERROR_CENTI 10                         // Table against the float Beta equation, 0.1 C
+
+// Natural log usable in constant expressions: ln(m * 2^k) = k*ln2 + 2*atanh((m-1)/(m+1))
+constexpr double thermistorLn(double x) {
+  int k = 0;
+  while (x >= 2.0) { x /= 2.0; k++; }
+  while (x < 1.0) { x *= 2.0; k--; }
+  double y = (x - 1.0) / (x + 1.0);  // 0 <= y < 1/3, so the series converges quickly
+  double y2 = y * y;
+  double term = y;
+  double sum = 0.0;
+  for (int n = 1; n < 40; n += 2) {
+    sum += term / n;
+    term *= y2;
+  }
+  return k * 0.69314718055994530942 + 2.0 * sum;
+}
+
+// Beta equation for one ADC code, in centi-degrees C with the offset applied
+constexpr int32_t thermistorCentiCExact(int code) {
+  // Codes 0 and 1023 mean an open or shorted divider, clamp so the ends stay finite
+  double c = code < 1 ? 1.0 : (code > ADC_MAX_CODE - 1 ? ADC_MAX_CODE - 1.0 : (double)code);
+  double r = THERMISTOR_R0 * ((double)ADC_MAX_CODE / c - 1.0);  // Thermistor resistance
+  double kelvin = 1.0 / (1.0 / THERMISTOR_T0 + thermistorLn(r / THERMISTOR_R0) / THERMISTOR_BETA);
+  double centi = (kelvin - 273.15 + THERMISTOR_OFFSET_C) * 100.0;
+  if (centi > 32767.0) centi = 32767.0;  // Fit the int16 table entries
+  if (centi < -32768.0) centi = -32768.0;
+  return (int32_t)(centi < 0 ? centi - 0.5 : centi + 0.5);
+}
+
+struct ThermistorTable {
+  int16_t centiC[THERMISTOR_TABLE_SIZE];  // Temperature at ADC code i * THERMISTOR_TABLE_STEP
+
+  constexpr ThermistorTable() : centiC() {
+    for (int i = 0; i < THERMISTOR_TABLE_SIZE; i++) {
+      centiC[i] = (int16_t)thermistorCentiCExact(i * THERMISTOR_TABLE_STEP);
+    }
+  }
+};
+
+static constexpr ThermistorTable thermistorTable{};
+
+// Filtered ADC code with ADC_FRACTION_BITS fractional bits to centi-degrees C
+inline CentiC thermistorCentiCFromQ4(uint32_t codeQ4) {
+  const uint32_t shift = THERMISTOR_TABLE_SHIFT + ADC_FRACTION_BITS;
+  if (codeQ4 > ((uint32_t)ADC_MAX_CODE << ADC_FRACTION_BITS)) codeQ4 = (uint32_t)ADC_MAX_CODE << ADC_FRACTION_BITS;
+  uint32_t index = codeQ4 >> shift;
+  int32_t fraction = codeQ4 & ((1u << shift) - 1);
+  int32_t lo = thermistorTable.centiC[index];
+  int32_t hi = thermistorTable.centiC[index + 1];
+  return { (int16_t)(lo + (((hi - lo) * fraction + (1 << (shift - 1))) >> shift)) };  // Between two int16 entries
+}
+
+// Raw 10-bit ADC code to centi-degrees C
+inline CentiC thermistorCentiC(uint16_t code) {
+  return thermistorCentiCFromQ4((uint32_t)code << ADC_FRACTION_BITS);
+}
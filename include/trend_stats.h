@@ -0,0 +1,231 @@
+/*
+ * Streaming statistics for the Trends screen
+ * Every reading is folded in once (add()), in integer arithmetic only (the ESP8266 has no
+ * FPU); the summaries of the last hour and day are worked out when the screen asks:
+ *
+ *   mean, stddev  count, sum and sum of squares per bucket (exact), merged over the window
+ *   p50/p95/p99   P-square estimates (Jain & Chlamtac, five markers each), no samples kept,
+ *                 marker heights in 1/256 centi-degree and positions in Q32
+ *   crossings     events, not readings: one per rise above the limit, ended once the
+ *                 reading falls STATS_CROSS_HYSTERESIS below it
+ *   above         time spent above the limit (each reading holds until the next)
+ *
+ * A window is a ring of buckets like RollupTier (1 h = 20 x 3 min, 24 h = 24 x 1 h) and
+ * slides a bucket at a time. The closed buckets are merged when a bucket opens (O(buckets)
+ * once per bucket period), each reading then costs the same whatever the window. P-square
+ * cannot forget old readings, so each window runs two sets of estimators started half a
+ * window apart and reports the older one: its percentiles cover the last half to whole
+ * window.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "centi_temp.h"
+
+#ifndef STATS_CROSS_HYSTERESIS
+#define STATS_CROSS_HYSTERESIS 50    // Centi-degrees below the limit that end a crossing
+#endif
+#define STATS_MAX_STEP_MS 10000UL    // Longest gap between readings counted as time above
+#define STATS_HOUR_BUCKETS 20        // 1 h window, 3 min buckets
+#define STATS_DAY_BUCKETS 24         // 24 h window, 1 h buckets
+
+#define P2_HEIGHT_BITS 8             // Fraction bits of the P-square marker heights
+
+// Moments of centi-degree readings as exact sums, mergeable by adding. A reading squared is
+// below 2^30, so sumSq holds more than 2^33 readings (a day at 1 Hz is under 2^17)
+struct MomentSums {
+  uint32_t n;
+  int64_t sum;
+  int64_t sumSq;
+
+  void add(int16_t x) {
+    n++;
+    sum += x;
+    sumSq += (int32_t)x * x;
+  }
+  void merge(const MomentSums& other) {
+    n += other.n;
+    sum += other.sum;
+    sumSq += other.sumSq;
+  }
+  int32_t mean() const;       // Rounded, 0 when empty
+  uint32_t variance() const;  // Sample variance in centi-degrees squared
+};
+
+// P-square estimate of one quantile
+class P2Quantile {
+public:
+  explicit P2Quantile(uint16_t permille = 500) : p((uint32_t)(((uint64_t)permille << 32) / 1000)) {}
+  void reset() { count = 0; }
+  void add(int16_t x);
+  int32_t value() const;  // Rounded, 0 before the first sample, exact up to five samples
+  uint32_t samples() const { return count; }
+
+private:
+  uint32_t p;           // The quantile, Q32
+  int32_t q[5];         // Marker heights, P2_HEIGHT_BITS fraction bits
+  int64_t want[5];      // Desired marker positions, Q32
+  int32_t pos[5];       // Actual marker positions
+  uint32_t count = 0;
+};
+
+uint32_t isqrtRounded(uint32_t x);  // Nearest integer to sqrt(x)
+
+struct TrendSummary {
+  uint32_t samples;     // Readings in the window
+  CentiC min, max, mean;
+  CentiC stddev;
+  CentiC p50, p95, p99;
+  uint16_t crossings;   // Crossing events that started in the window
+  uint32_t aboveMs;     // Time above the limit in the window
+};
+
+// One sliding window, BUCKETS buckets of periodMs
+template <uint16_t BUCKETS>
+class StatsWindow {
+  static_assert(BUCKETS >= 2 && BUCKETS % 2 == 0, "StatsWindow needs an even number of buckets");
+
+public:
+  explicit StatsWindow(uint32_t periodMs) : periodMs(periodMs) {
+    static const uint16_t permille[3] = { 500, 950, 990 };
+    for (int set = 0; set < 2; set++) {
+      for (int i = 0; i < 3; i++) quantiles[set][i] = P2Quantile(permille[i]);
+    }
+  }
+
+  void add(uint32_t timestampMs, CentiC value, uint32_t aboveMs, bool crossing) {
+    uint32_t period = timestampMs / periodMs;
+    if (count == 0 || period != bucket(count - 1).period) open(period);
+    Bucket& b = bucket(count - 1);
+    b.moments.add(value.raw);
+    if (b.moments.n == 1 || value < b.min) b.min = value;
+    if (b.moments.n == 1 || value > b.max) b.max = value;
+    b.crossings += crossing;
+    b.aboveMs += aboveMs;
+    for (int set = 0; set < 2; set++) {
+      for (int i = 0; i < 3; i++) quantiles[set][i].add(value.raw);
+    }
+    stale = true;
+  }
+
+  // Worked out on demand, the screen asks far less often than readings arrive
+  const TrendSummary& summary() const {
+    if (stale) summarize();
+    return current;
+  }
+
+private:
+  struct Bucket {
+    uint32_t period;    // timestamp / periodMs
+    MomentSums moments;
+    CentiC min, max;
+    uint16_t crossings;
+    uint32_t aboveMs;
+  };
+
+  // Start the bucket of period (and empty ones for a gap), then merge the closed buckets
+  void open(uint32_t period) {
+    uint32_t half = BUCKETS / 2;
+    if (count > 0) {
+      uint32_t last = bucket(count - 1).period;
+      uint32_t gap = period - last;  // Also covers the millis() wrap (treated as a long gap)
+      if (gap > BUCKETS) gap = BUCKETS;
+      for (uint32_t i = 1; i < gap; i++) push(period - gap + i);
+      // Half a window on: restart the older estimator set, the other one becomes the older
+      if (period / half != last / half) {
+        if (period / half - last / half >= 2) resetSet(older ^ 1);  // Both are out of the window
+        resetSet(older);
+        older ^= 1;
+      }
+    }
+    push(period);
+
+    closed = {};
+    for (uint16_t i = 0; i + 1 < count; i++) {
+      const Bucket& b = bucket(i);
+      if (b.moments.n == 0) continue;
+      if (closed.moments.n == 0 || b.min < closed.min) closed.min = b.min;
+      if (closed.moments.n == 0 || b.max > closed.max) closed.max = b.max;
+      closed.moments.merge(b.moments);
+      closed.crossings += b.crossings;
+      closed.aboveMs += b.aboveMs;
+    }
+  }
+
+  void push(uint32_t period) {
+    if (count == BUCKETS) head = (head + 1) % BUCKETS;  // Overwrite the oldest bucket
+    else count++;
+    bucket(count - 1) = { period, {}, {}, {}, 0, 0 };
+  }
+
+  void resetSet(uint8_t set) {
+    for (int i = 0; i < 3; i++) quantiles[set][i].reset();
+  }
+
+  void summarize() const {
+    stale = false;
+    if (count == 0) return;
+    const Bucket& open = bucket(count - 1);
+    MomentSums moments = closed.moments;
+    moments.merge(open.moments);
+    bool haveClosed = closed.moments.n > 0;
+    current.samples = moments.n;
+    current.min = haveClosed && closed.min < open.min ? closed.min : open.min;
+    current.max = haveClosed && closed.max > open.max ? closed.max : open.max;
+    current.mean = CentiC::fromCenti((int16_t)moments.mean());
+    uint32_t sd = isqrtRounded(moments.variance());
+    current.stddev = CentiC::fromCenti((int16_t)(sd > INT16_MAX ? INT16_MAX : sd));
+    const P2Quantile* set = quantiles[older];
+    current.p50 = CentiC::fromCenti((int16_t)set[0].value());
+    current.p95 = CentiC::fromCenti((int16_t)set[1].value());
+    current.p99 = CentiC::fromCenti((int16_t)set[2].value());
+    current.crossings = closed.crossings + open.crossings;
+    current.aboveMs = closed.aboveMs + open.aboveMs;
+  }
+
+  Bucket& bucket(uint16_t i) { return buckets[(head + i) % BUCKETS]; }
+  const Bucket& bucket(uint16_t i) const { return buckets[(head + i) % BUCKETS]; }
+
+  uint32_t periodMs;
+  Bucket buckets[BUCKETS];
+  uint16_t head = 0;         // Slot of the oldest bucket
+  uint16_t count = 0;        // Buckets in use, the newest one is open
+  Bucket closed = {};        // The closed buckets merged
+  P2Quantile quantiles[2][3];
+  uint8_t older = 0;         // Estimator set that has run longer, the one reported
+  mutable TrendSummary current = {};
+  mutable bool stale = false;  // A reading arrived since current was worked out
+};
+
+class TrendStats {
+public:
+  // Fold in a reading, limit is the high temperature alert at the time
+  void add(uint32_t timestampMs, CentiC value, CentiC limit);
+  // Continue the crossing count of an earlier run (from the flash log)
+  void restoreCrossings(uint32_t crossings) { events = crossings; }
+
+  const TrendSummary& hour() const { return hourWindow.summary(); }
+  const TrendSummary& day() const { return dayWindow.summary(); }
+  uint32_t crossings() const { return events; }       // Crossing events, restored ones included
+  bool crossing() const { return inEvent; }            // A crossing is going on
+  uint32_t lastCrossingMs() const { return lastEventMs; }  // Duration of the last finished crossing
+  uint32_t longestCrossingMs() const { return longestEventMs; }
+  uint32_t aboveMs() const { return totalAboveMs; }    // Time above the limit since boot
+
+private:
+  StatsWindow<STATS_HOUR_BUCKETS> hourWindow{ 3600000UL / STATS_HOUR_BUCKETS };
+  StatsWindow<STATS_DAY_BUCKETS> dayWindow{ 86400000UL / STATS_DAY_BUCKETS };
+  uint32_t lastMs = 0;
+  bool haveLast = false;
+  bool lastAbove = false;
+  bool inEvent = false;
+  uint32_t eventStartMs = 0;
+  uint32_t events = 0;
+  uint32_t lastEventMs = 0;
+  uint32_t longestEventMs = 0;
+  uint32_t totalAboveMs = 0;
+};
+
+// "45s", "12m40s", "3h05m" or "2d04h"
+void formatDuration(char* out, size_t size, uint32_t ms);
@@ -0,0 +1,106 @@
+/*
+ * Native HAL shim: Adafruit_ST7735.h
+ * Emulates the ST7735 controller RAM (132x162) so that rotation, address windows,
+ * column/row offsets and vertical scrolling behave like the panel. Every transfer is
+ * counted in spiBytesTotal() so render cost can be measured on the host.
+ */
+#pragma once
+
+#include <Adafruit_GFX.h>
+#include <SPI.h>
+
+#define ST7735_TFTWIDTH_128 128
+#define ST7735_TFTHEIGHT_160 160
+
+#define INITR_GREENTAB 0x00
+#define INITR_REDTAB 0x01
+#define INITR_BLACKTAB 0x02
+
+#define ST77XX_CASET 0x2A
+#define ST77XX_RASET 0x2B
+#define ST77XX_RAMWR 0x2C
+#define ST77XX_MADCTL 0x36
+#define ST77XX_VSCRDEF 0x33
+#define ST77XX_VSCRSADD 0x37
+
+#define ST77XX_BLACK 0x0000
+#define ST77XX_WHITE 0xFFFF
+#define ST77XX_RED 0xF800
+#define ST77XX_GREEN 0x07E0
+#define ST77XX_BLUE 0x001F
+#define ST77XX_CYAN 0x07FF
+#define ST77XX_MAGENTA 0xF81F
+#define ST77XX_YELLOW 0xFFE0
+#define ST77XX_ORANGE 0xFC00
+
+#define ST7735_BLACK ST77XX_BLACK
+#define ST7735_WHITE ST77XX_WHITE
+#define ST7735_RED ST77XX_RED
+#define ST7735_GREEN ST77XX_GREEN
+#define ST7735_BLUE ST77XX_BLUE
+#define ST7735_CYAN ST77XX_CYAN
+#define ST7735_MAGENTA ST77XX_MAGENTA
+#define ST7735_YELLOW ST77XX_YELLOW
+#define ST7735_ORANGE ST77XX_ORANGE
+
+#define NATIVE_TFT_RAM_COLS 132
+#define NATIVE_TFT_RAM_ROWS 162
+
+class Adafruit_SPITFT : public Adafruit_GFX {
+public:
+  Adafruit_SPITFT(uint16_t w, uint16_t h) : Adafruit_GFX(w, h) {}
+
+  virtual void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) = 0;
+
+  void startWrite(void) override {}
+  void endWrite(void) override {}
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+  void writePixel(int16_t x, int16_t y, uint16_t color) override;
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+  void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+  void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+  void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+
+  void writePixels(uint16_t *colors, uint32_t len, bool block = true, bool bigEndian = false);
+  void writeColor(uint16_t color, uint32_t len);
+  void sendCommand(uint8_t commandByte, const uint8_t *dataBytes = NULL, uint8_t numDataBytes = 0);
+
+  // Host-side instrumentation
+  uint32_t spiBytesTotal() const { return spiBytes; }
+  uint16_t ramPixel(uint16_t col, uint16_t row) const { return ram[row][col]; }
+  uint16_t screenPixel(int16_t x, int16_t y) const;  // What the panel shows at (x, y), scroll included
+  uint16_t scrollStart() const { return vscrsadd; }
+
+protected:
+  void writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void writePixelPreclipped(int16_t x, int16_t y, uint16_t color);
+  void fillRectClipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void ramWrite(uint16_t color);
+
+  uint16_t ram[NATIVE_TFT_RAM_ROWS][NATIVE_TFT_RAM_COLS] = {};
+  uint32_t spiBytes = 0;
+  uint8_t madctl = 0;
+  uint16_t winX0 = 0, winX1 = 0, winY0 = 0, winY1 = 0;
+  uint16_t winX = 0, winY = 0;
+  uint16_t vscrTfa = 0, vscrVsa = NATIVE_TFT_RAM_ROWS, vscrBfa = 0, vscrsadd = 0;
+  uint8_t _colstart = 0, _rowstart = 0, _xstart = 0, _ystart = 0;
+};
+
+class Adafruit_ST77xx : public Adafruit_SPITFT {
+public:
+  Adafruit_ST77xx(uint16_t w, uint16_t h, int8_t cs, int8_t dc, int8_t rst) : Adafruit_SPITFT(w, h) { (void)cs; (void)dc; (void)rst; }
+  void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) override;
+  void setRotation(uint8_t r) override;
+
+protected:
+  void setColRowStart(int8_t col, int8_t row) { _colstart = col; _rowstart = row; }
+};
+
+class Adafruit_ST7735 : public Adafruit_ST77xx {
+public:
+  Adafruit_ST7735(int8_t cs, int8_t dc, int8_t rst) : Adafruit_ST77xx(ST7735_TFTWIDTH_128, ST7735_TFTHEIGHT_160, cs, dc, rst) {}
+  void initR(uint8_t options = INITR_GREENTAB);
+  void setRotation(uint8_t m) override;
+};
@@ -0,0 +1,13 @@
+/*
+ * Native HAL shim: ArduinoOTA.h
+ */
+#pragma once
+
+#include <Arduino.h>
+
+class ArduinoOTAClass {
+public:
+  void begin() {}
+  void handle() {}
+};
+extern ArduinoOTAClass ArduinoOTA;
@@ -0,0 +1,24 @@
+/*
+ * Native HAL shim: ESP8266WiFi.h
+ * WiFi only counts as connected while the script has NTP answering (native_set_ntp_epoch),
+ * otherwise the firmware's offline paths run.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+typedef enum { WL_IDLE_STATUS = 0, WL_NO_SSID_AVAIL = 1, WL_CONNECTED = 3, WL_CONNECT_FAILED = 4, WL_DISCONNECTED = 6 } wl_status_t;
+
+class IPAddress {
+public:
+  operator const char *() const { return "0.0.0.0"; }
+  String toString() const { return String("0.0.0.0"); }
+};
+
+class ESP8266WiFiClass {
+public:
+  wl_status_t begin(const char *ssid, const char *passphrase = NULL) { (void)ssid; (void)passphrase; return WL_DISCONNECTED; }
+  wl_status_t status();
+  IPAddress localIP() { return IPAddress(); }
+};
+extern ESP8266WiFiClass WiFi;
@@ -0,0 +1,72 @@
+/*
+ * Native HAL shim: ESP8266 file system API
+ * The subset of FS/File/Dir the firmware uses, on an in-memory file table. Writes are
+ * counted (calls and bytes) so flash wear can be compared between builds.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+struct FSInfo {
+  size_t totalBytes;
+  size_t usedBytes;
+  size_t blockSize;
+  size_t pageSize;
+  size_t maxOpenFiles;
+  size_t maxPathLength;
+};
+
+class File {
+public:
+  File() {}
+  File(const std::string &path, bool readable, bool writable, bool append)
+    : path(path), readable(readable), writable(writable), append(append), valid(true) {}
+
+  size_t write(const uint8_t *buffer, size_t size);
+  size_t write(uint8_t c) { return write(&c, 1); }
+  size_t read(uint8_t *buffer, size_t size);
+  int read();
+  int available() { return (int)(size() - pos); }
+  bool seek(uint32_t offset, SeekMode mode = SeekSet);
+  size_t position() const { return pos; }
+  size_t size() const;
+  bool truncate(uint32_t size);
+  void flush() {}
+  void close() { valid = false; }
+  const char *name() const;
+  explicit operator bool() const { return valid; }
+
+private:
+  std::string path;
+  size_t pos = 0;
+  bool readable = false, writable = false, append = false, valid = false;
+};
+
+class Dir {
+public:
+  Dir() {}
+  explicit Dir(const std::string &path) : path(path) {}
+  bool next();
+  String fileName() const { return String(current.c_str()); }  // Name inside the directory
+  size_t fileSize() const;
+  File openFile(const char *mode);
+
+private:
+  std::string path, current;
+};
+
+class FS {
+public:
+  bool begin() { return true; }
+  void end() {}
+  bool format();
+  File open(const char *path, const char *mode);
+  Dir openDir(const char *path) { return Dir(path); }
+  bool exists(const char *path);
+  bool remove(const char *path);
+  bool rename(const char *from, const char *to);
+  bool mkdir(const char *path) { (void)path; return true; }  // Directories are implicit
+  bool info(FSInfo &info);
+};
@@ -0,0 +1,9 @@
+/*
+ * Native HAL shim: Fonts/FreeSansBold12pt7b.h
+ * Metrics-only stand-in (14px advance, 29px line).
+ */
+#pragma once
+
+#include <Adafruit_GFX.h>
+
+extern const GFXfont FreeSansBold12pt7b;
@@ -0,0 +1,9 @@
+/*
+ * Native HAL shim: Fonts/TomThumb.h
+ * Metrics-only stand-in for the 3x5 TomThumb font (4px advance, 6px line).
+ */
+#pragma once
+
+#include <Adafruit_GFX.h>
+
+extern const GFXfont TomThumb;
@@ -0,0 +1,8 @@
+/*
+ * Native HAL shim: LittleFS
+ */
+#pragma once
+
+#include "FS.h"
+
+extern FS LittleFS;
@@ -0,0 +1,13 @@
+/*
+ * Native HAL shim: SPI.h
+ */
+#pragma once
+
+#include <Arduino.h>
+
+class SPIClass {
+public:
+  void begin() {}
+  void setFrequency(uint32_t freq) { (void)freq; }
+};
+extern SPIClass SPI;
@@ -0,0 +1,28 @@
+/*
+ * Native HAL shim: Ticker.h
+ * Callbacks fire from native_advance_us() (delay() and the runner) as virtual time passes,
+ * like the ESP8266 Ticker they run between two statements of loop(), never inside one.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+class Ticker {
+public:
+  typedef void (*callback_t)(void);
+
+  Ticker();
+  ~Ticker();
+  void attach_ms(uint32_t milliseconds, callback_t callback);
+  void detach();
+  bool active() const { return cb != nullptr; }
+
+  // Called by the native runner; fires every Ticker that is due
+  static void serviceAll();
+
+private:
+  callback_t cb = nullptr;
+  uint32_t periodMs = 0;
+  unsigned long nextMs = 0;
+  Ticker *next = nullptr;
+};
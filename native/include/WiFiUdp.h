@@ -0,0 +1,28 @@
+/*
+ * Native HAL shim: WiFiUdp.h
+ * Only what NTP needs: a request sent to port 123 is answered NATIVE_NTP_DELAY_MS later
+ * (virtual time) with the epoch set by native_set_ntp_epoch(), or not at all while it is 0.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+#define NATIVE_NTP_DELAY_MS 40  // Round trip to the NTP server
+
+class WiFiUDP {
+public:
+  uint8_t begin(uint16_t port) { (void)port; return 1; }
+  int beginPacket(const char *host, uint16_t port);
+  size_t write(const uint8_t *buffer, size_t size);
+  int endPacket();
+  int parsePacket();  // Size of the answer that has arrived, 0 when none
+  int read(uint8_t *buffer, size_t size);
+  void flush() { available = 0; }
+
+private:
+  uint16_t destPort = 0;
+  size_t sent = 0;
+  uint64_t answerAtMs = 0;  // When the answer to the request out arrives, 0 = none out
+  uint8_t answer[48];
+  size_t available = 0;
+};
@@ -0,0 +1,6 @@
+/*
+ * Native HAL shim: Wire.h (I2C is not used by the firmware)
+ */
+#pragma once
+
+#include <Arduino.h>
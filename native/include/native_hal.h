@@ -0,0 +1,28 @@
+/*
+ * Native HAL shim: runner interface
+ * Functions the native runner uses to drive virtual time and the scripted inputs.
+ */
+#pragma once
+
+#include <Arduino.h>
+
+typedef int (*NativeAdcSource)(uint64_t timeUs);  // Returns the 10-bit A0 reading at a time
+
+void native_reset();
+void native_advance_us(uint64_t us);   // Advance virtual time and fire due Tickers
+uint64_t native_time_us();
+void native_set_pin(uint8_t pin, int level);  // Drive a digital input, firing its interrupt
+int native_get_output(uint8_t pin);    // Last digitalWrite()/analogWrite() value
+void native_set_adc_source(NativeAdcSource source);
+void native_set_serial_sink(FILE *sink);
+void native_serial_input(const char *text);  // Bytes for Serial.read(), as if typed on the port
+uint64_t native_serial_bytes();
+uint64_t native_serial_blocked_us();  // Time Serial.write() spent waiting for FIFO room
+void native_set_ntp_epoch(uint32_t epoch);  // 0 = no NTP answer
+void native_count_spi(uint32_t bytes);  // Called by the display emulation
+#define NATIVE_FLASH_FS_BYTES (2 * 1024 * 1024)  // LittleFS size on a 4 MB NodeMCU (4m2m layout)
+uint64_t native_flash_writes();          // File writes, truncates, creates and removes
+uint64_t native_flash_bytes_written();
+bool native_flash_load(const char *path);  // Replace the file system with an image
+bool native_flash_save(const char *path);  // Write the file system to an image
+uint64_t native_spi_bytes();
@@ -0,0 +1,14 @@
+/*
+ * Native runner interface
+ * Lets the benchmarks drive the firmware the same way the command-line runner does.
+ */
+#pragma once
+
+#include <stdint.h>
+
+void native_runner_begin();                           // Reset the shim, apply the script's start state, run setup()
+void native_runner_step();                            // Scripted inputs, one loop(), then 1 ms of virtual time
+void native_run_until(uint64_t ms);                   // Step until virtual time reaches ms
+void native_press(uint64_t atMs, const char *button); // Queue a 100 ms press of "up", "select" or "back"
+double native_script_temperature(uint64_t ms);        // Sensor temperature the script sets at ms
+int native_bench();                                   // Microbenchmark suite (bench.cpp), returns the exit code
@@ -0,0 +1,48 @@
+/*
+ * Thermal plant model
+ * First-order model of the enclosure the fan cools: one heat capacity, a constant heat input,
+ * passive loss to the ambient air and extra loss while the fan runs.
+ *
+ *   C dT/dt = heat - (loss + fan * duty) * (T - ambient(t))
+ *
+ * The ambient temperature drifts over the day, ambient(t) = ambient + drift * sin(2 pi t / 24 h).
+ * Between calls the fan duty is constant, so each step uses the exact exponential solution
+ * (ambient held at its mid-step value); steps are at most 1 s, far below the time constants.
+ */
+#pragma once
+
+#include <stdint.h>
+
+struct ThermalPlantParams {
+  double heatW = 30.0;            // Heat from the inverter
+  double lossWPerK = 0.6;         // Passive loss through the enclosure
+  double fanWPerK = 2.5;          // Extra loss at full fan duty
+  double capacityJPerK = 2000.0;  // Enclosure and air
+  double ambientC = 27.0;         // Mean ambient temperature
+  double driftC = 3.0;            // Daily ambient swing (amplitude)
+  double startC = -273.0;         // Initial temperature, below -273 means "start at ambient"
+};
+
+// Applies "key=value,key=value" (heat, loss, fan, cap, ambient, drift, start) on top of params.
+// "default" keeps the defaults. Returns false on an unknown key or a bad number.
+bool parseThermalPlantParams(const char *spec, ThermalPlantParams &params);
+
+class ThermalPlant {
+ public:
+  explicit ThermalPlant(const ThermalPlantParams &params);
+
+  void advance(uint64_t ms);                  // Integrate up to ms with the current fan duty
+  void setFanDuty(uint64_t ms, double duty);  // Integrate up to ms, then switch to duty (0..1)
+  void setHeat(uint64_t ms, double watts);
+  void setAmbient(uint64_t ms, double celsius);
+
+  double temperature() const { return tempC; }
+  double ambient(uint64_t ms) const;
+  const ThermalPlantParams &parameters() const { return params; }
+
+ private:
+  ThermalPlantParams params;
+  double tempC;
+  double duty = 0;
+  uint64_t nowMs = 0;
+};
@@ -0,0 +1,394 @@
+/*
+ * Native microbenchmarks
+ * Host timings are only comparable with each other (same machine, same build), the SPI byte
+ * counts are what the ESP8266 would actually send and translate directly into panel time.
+ *
+ *   conversion: ADC burst filter, ADC-to-temperature against the float Beta equation (time and
+ *               error, fails above THERMISTOR_MAX_ERROR_CENTI), one full readTemperature()
+ *   loop:       loop() calls per second of host time with the menu idle
+ *   render:     per screen, host time and SPI bytes per frame (screen task at 10 Hz)
+ *   compress:   the readings of the serial captures (one per second) through the series
+ *               codes, the packed history and the flash log, size and host speed
+ *   alerts:     AlertEngine::update() on the same readings with 1 to ALERT_MAX_RULES rules
+ *   filter:     the same readings through the EMA of AdcFilter for each shift, RMS change
+ *               between readings before and after, and the delay of a step
+ */
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <chrono>
+#include <dirent.h>
+#include <string>
+#include <vector>
+#include "native_hal.h"
+#include "native_runner.h"
+#include "thermistor.h"
+#include "adc_filter.h"
+#include "series_codec.h"
+#include "history.h"
+#include "packed_history.h"
+#include "rollup.h"
+#include "flash_log.h"
+#include "alert_rules.h"
+
+#define BENCH_SPI_HZ 40000000  // SPI.setFrequency() in setup()
+#define BENCH_CAPTURE_DIR "src/serial_outputs"  // Relative to the repository root
+
+void readTemperature();
+
+static volatile int32_t sink;  // Keeps the measured work from being optimised away
+
+static double nowNs() {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The conversion readTemperature() did before the table, in float as on the ESP8266
+static float betaCelsius(int code) {
+  float voltage = code * (3.3f / ADC_MAX_CODE);
+  float r = THERMISTOR_R0 * (3.3f / voltage - 1);
+  float kelvin = 1 / (1 / (float)THERMISTOR_T0 + logf(r / (float)THERMISTOR_R0) / (float)THERMISTOR_BETA);
+  return kelvin - 273.15f + (float)THERMISTOR_OFFSET_C;
+}
+
+// Returns false when the table is off the formula by more than the documented bound
+static bool benchConversion() {
+  const int rounds = 2000;
+  double start = nowNs();
+  for (int r = 0; r < rounds; r++) {
+    for (uint32_t q4 = 0; q4 < (1024u << ADC_FRACTION_BITS); q4 += 7) sink += thermistorCentiCFromQ4(q4).raw;
+  }
+  double perCall = (nowNs() - start) / (rounds * ((1024u << ADC_FRACTION_BITS) / 7 + 1));
+  printf("conversion  thermistorCentiCFromQ4      %8.1f ns/call\n", perCall);
+  start = nowNs();
+  for (int r = 0; r < rounds / 10; r++) {
+    for (int code = 1; code < ADC_MAX_CODE; code++) sink += thermistorCentiC(code).raw;
+  }
+  double tableNs = (nowNs() - start) / (rounds / 10 * (ADC_MAX_CODE - 1));
+  volatile float floatSink = 0;
+  start = nowNs();
+  for (int r = 0; r < rounds / 10; r++) {
+    for (int code = 1; code < ADC_MAX_CODE; code++) floatSink = floatSink + betaCelsius(code);
+  }
+  double formulaNs = (nowNs() - start) / (rounds / 10 * (ADC_MAX_CODE - 1));
+  printf("conversion  thermistorCentiC / float Beta %6.1f / %.1f ns/call\n", tableNs, formulaNs);
+
+  // Largest difference per code range, codes 0 and 1023 are an open or shorted divider
+  static const struct { int from, to; } ranges[] = {
+    { 1, THERMISTOR_CHECKED_FROM - 1 },
+    { THERMISTOR_CHECKED_FROM, THERMISTOR_CHECKED_TO },
+    { THERMISTOR_CHECKED_TO + 1, ADC_MAX_CODE - 1 },
+  };
+  bool ok = true;
+  for (auto &range : ranges) {
+    float worst = 0;
+    int worstCode = range.from;
+    for (int code = range.from; code <= range.to; code++) {
+      float error = fabsf(thermistorCentiC(code).raw - betaCelsius(code) * 100);
+      if (error > worst) {
+        worst = error;
+        worstCode = code;
+      }
+    }
+    bool checked = range.from == THERMISTOR_CHECKED_FROM;
+    bool over = checked && worst > THERMISTOR_MAX_ERROR_CENTI;
+    ok = ok && !over;
+    printf("conversion  max error codes %4d..%-4d  %8.2f C at code %d (%.1f C)%s\n", range.from, range.to,
+           worst / 100, worstCode, betaCelsius(worstCode),
+           over ? "  OVER THE BOUND" : checked ? "" : "  (not checked)");
+  }
+
+  AdcFilter filter;
+  uint16_t burst[ADC_BURST_SAMPLES];
+  const int bursts = 2000000;
+  start = nowNs();
+  for (int i = 0; i < bursts; i++) {
+    for (int k = 0; k < ADC_BURST_SAMPLES; k++) burst[k] = (uint16_t)(500 + ((i * 7 + k * 13) & 15));
+    sink += filter.update(burst, ADC_BURST_SAMPLES);
+  }
+  printf("conversion  AdcFilter::update (%d)       %8.1f ns/burst\n", ADC_BURST_SAMPLES, (nowNs() - start) / bursts);
+
+  const int reads = 200000;
+  start = nowNs();
+  for (int i = 0; i < reads; i++) readTemperature();
+  printf("conversion  readTemperature()           %8.1f ns/call (burst, filter, history, rollups, alerts, log)\n",
+         (nowNs() - start) / reads);
+  return ok;
+}
+
+static double idleLoopNs = 0;  // Host cost of one idle loop() call, taken out of the render numbers
+
+static void benchLoop() {
+  const uint64_t seconds = 60;
+  uint64_t fromMs = native_time_us() / 1000, calls = 0;
+  double start = nowNs();
+  while (native_time_us() < (fromMs + seconds * 1000) * 1000) {
+    native_runner_step();
+    calls++;
+  }
+  double ns = nowNs() - start;
+  idleLoopNs = ns / calls;
+  printf("loop        menu idle, %llu s virtual      %8.0f loop()/s host, %.0f ns/call\n", (unsigned long long)seconds,
+         calls / (ns / 1e9), ns / calls);
+}
+
+static void benchRender() {
+  static const char *const names[] = { "Home", "Settings", "Chart", "Trends", "Alerts", "Diagnostics", "About" };
+  printf("render      screen       open: SPI B  SPI ms | frame: host us  SPI B  SPI us  (SPI at %d MHz)\n",
+         BENCH_SPI_HZ / 1000000);
+  for (int screen = 0; screen < 7; screen++) {
+    // Back to the menu's first entry, scroll to the screen and open it
+    uint64_t ms = native_time_us() / 1000;
+    for (int i = 0; i < 3; i++) native_press(ms + 200 * i, "back");
+    ms += 600;
+    for (int i = 0; i < screen; i++, ms += 200) native_press(ms, "up");
+    native_run_until(ms);
+    uint64_t openSpi = native_spi_bytes();
+    native_press(ms, "select");
+    native_run_until(ms + 3000);  // The first full frame and the settling of the screen
+    openSpi = native_spi_bytes() - openSpi;
+
+    const uint64_t frames = 100;  // 10 s of screen task at 10 Hz
+    uint64_t spiStart = native_spi_bytes(), endMs = ms + 3000 + frames * 100;
+    double start = nowNs();
+    native_run_until(endMs);
+    double ns = nowNs() - start - idleLoopNs * (endMs - ms - 3000);
+    uint64_t spi = native_spi_bytes() - spiStart;
+    printf("render      %-12s %11llu %7.2f | %12.1f %6.0f %7.1f\n", names[screen], (unsigned long long)openSpi,
+           openSpi * 8.0 * 1e3 / BENCH_SPI_HZ, ns > 0 ? ns / frames / 1000 : 0.0, (double)spi / frames,
+           spi * 8.0 * 1e6 / BENCH_SPI_HZ / frames);
+  }
+
+  // One step of the menu cursor
+  uint64_t ms = native_time_us() / 1000;
+  for (int i = 0; i < 3; i++) native_press(ms + 200 * i, "back");
+  native_run_until(ms + 1000);
+  uint64_t spi = native_spi_bytes();
+  native_press(ms + 1000, "up");
+  native_run_until(ms + 1500);
+  spi = native_spi_bytes() - spi;
+  printf("render      menu, one UP %11llu %7.2f\n", (unsigned long long)spi, spi * 8.0 * 1e3 / BENCH_SPI_HZ);
+}
+
+// The "Temperature:" readings of each capture in BENCH_CAPTURE_DIR, in centi-degrees
+static std::vector<std::vector<int16_t>> loadCaptures() {
+  std::vector<std::vector<int16_t>> captures;
+  DIR *dir = opendir(BENCH_CAPTURE_DIR);
+  if (!dir) return captures;
+  std::vector<std::string> names;
+  while (dirent *entry = readdir(dir)) names.push_back(entry->d_name);
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+  for (const std::string &name : names) {
+    FILE *f = fopen((BENCH_CAPTURE_DIR "/" + name).c_str(), "r");
+    if (!f) continue;
+    std::vector<int16_t> readings;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+      const char *at = strstr(line, "Temperature: ");
+      if (!at) continue;
+      char *end;
+      double celsius = strtod(at + 13, &end);
+      if (end != at + 13 && celsius > -40 && celsius < 150) readings.push_back((int16_t)lround(celsius * 100));
+    }
+    fclose(f);
+    if (readings.size() > 1) captures.push_back(readings);
+  }
+  return captures;
+}
+
+static bool countRecord(const FlashLogRecord &record, void *context) {
+  *static_cast<uint32_t *>(context) += record.count;
+  return true;
+}
+
+static void benchCompression() {
+  std::vector<std::vector<int16_t>> captures = loadCaptures();
+  if (captures.empty()) {
+    printf("compress    no captures in " BENCH_CAPTURE_DIR " (run from the repository root)\n");
+    return;
+  }
+  size_t readings = 0;
+  for (auto &capture : captures) readings += capture.size();
+  const uint32_t periodMs = 1000;  // The captures are one reading per second, without timestamps
+
+  // Series codes: each capture as one stream, the first reading in full (6 bytes)
+  std::vector<uint8_t> packed(readings * 8 + 64);
+  size_t packedBits = 0;
+  const int rounds = 200;
+  double start = nowNs();
+  for (int round = 0; round < rounds; round++) {
+    packedBits = 0;
+    for (auto &capture : captures) {
+      BitWriter out(packed.data(), (uint16_t)std::min<size_t>(packed.size(), 8191));
+      SeriesPoint last = { 0, 0, capture[0] };
+      for (size_t i = 1; i < capture.size(); i++) seriesAppend(out, last, i * periodMs, capture[i]);
+      packedBits += out.bits() + 48;
+    }
+  }
+  double encodeNs = (nowNs() - start) / rounds / readings;
+  // Decode the last capture, still in the buffer
+  const std::vector<int16_t> &lastCapture = captures.back();
+  start = nowNs();
+  for (int round = 0; round < rounds * 4; round++) {
+    BitReader in(packed.data());
+    SeriesPoint point = { 0, 0, lastCapture[0] };
+    for (size_t i = 1; i < lastCapture.size(); i++) {
+      seriesNext(in, point);
+      if (round == 0 && (point.value != lastCapture[i] || point.time != i * periodMs)) printf("compress    DECODE MISMATCH\n");
+    }
+    sink += point.value;
+  }
+  double decodeNs = (nowNs() - start) / (rounds * 4) / (lastCapture.size() - 1);
+  double rawBytes = readings * 6.0;  // uint32_t ms + int16_t centi-degrees
+  printf("compress    %zu readings in %zu captures: %.0f -> %.0f B, %.2f bits/reading, ratio %.1fx\n", readings,
+         captures.size(), rawBytes, packedBits / 8.0, (double)packedBits / readings, rawBytes * 8 / packedBits);
+  printf("compress    series encode %8.1f ns/reading (%.0f MB/s raw), decode %.1f ns/reading (%.0f MB/s raw)\n",
+         encodeNs, 6e3 / encodeNs, decodeNs, 6e3 / decodeNs);
+
+  // In-memory history: the fewest readings held once full, against the unpacked ring
+  static PackedHistory<HISTORY_BLOCKS, HISTORY_BLOCK_BYTES> history;
+  static RingHistory<CentiC, 300> ring;
+  uint32_t time = 0;
+  uint16_t fewest = UINT16_MAX;
+  start = nowNs();
+  for (auto &capture : captures) {
+    for (int16_t value : capture) {
+      history.push(time += periodMs, CentiC::fromCenti(value));
+      if (history.totalPushed() > 2000 && history.size() < fewest) fewest = history.size();
+    }
+  }
+  double pushNs = (nowNs() - start) / readings;
+  start = nowNs();
+  for (auto &capture : captures) {
+    for (int16_t value : capture) ring.push(time += periodMs, CentiC::fromCenti(value));
+  }
+  double ringNs = (nowNs() - start) / readings;
+  start = nowNs();
+  int32_t sum = 0;
+  for (auto sample : history) sum += sample.value.raw;
+  sink += sum;
+  double iterateNs = (nowNs() - start) / history.size();
+  printf("compress    history %u B (%u blocks of %u): %u..%u readings held (ring of 300: %u B), push %.1f ns "
+         "(ring %.1f), iterate %.1f ns\n",
+         (unsigned)sizeof(history), HISTORY_BLOCKS, HISTORY_BLOCK_BYTES, fewest, history.size(), (unsigned)sizeof(ring),
+         pushNs, ringNs, iterateNs);
+
+  // Flash log: the captures folded into minute records, as updateChartData() does
+  LittleFS.format();
+  static FlashLog log;
+  log.begin(LittleFS);
+  uint32_t minutes = 0, minuteTime = 0;
+  for (auto &capture : captures) {
+    for (size_t i = 0; i < capture.size(); i += 60) {
+      RollupBucket minute = {};
+      for (size_t k = i; k < i + 60 && k < capture.size(); k++) minute.add(CentiC::fromCenti(capture[k]));
+      log.append({ minuteTime += 60, minute.min, minute.max, minute.mean(), minute.count, 0 });
+      minutes++;
+    }
+  }
+  log.flush();
+  uint32_t counted = 0;
+  start = nowNs();
+  for (int round = 0; round < 100; round++) {
+    counted = 0;
+    log.query(0, UINT32_MAX, countRecord, &counted);
+  }
+  double queryNs = (nowNs() - start) / 100 / minutes;
+  printf("compress    flash log %u minute records: %u B unpacked, %lu blocks = %lu B, %.1f records/block, "
+         "query %.1f ns/record%s\n",
+         minutes, minutes * (unsigned)sizeof(FlashLogRecord), (unsigned long)log.storedBlocks(),
+         (unsigned long)(log.storedBlocks() * FLASH_LOG_BLOCK_BYTES), (double)minutes / log.storedBlocks(), queryNs,
+         counted == readings ? "" : " (COUNT MISMATCH)");
+}
+
+static void benchAlerts() {
+  std::vector<std::vector<int16_t>> captures = loadCaptures();
+  if (captures.empty()) return;  // Reported by benchCompression()
+  for (uint8_t count = 1; count <= ALERT_MAX_RULES; count *= 2) {
+    // Thresholds spread over the range of the captures, both directions, some debounced
+    AlertRule rules[ALERT_MAX_RULES];
+    for (uint8_t i = 0; i < count; i++) {
+      rules[i] = { "bench", i % 2 ? ALERT_BELOW : ALERT_ABOVE, CentiC::fromCenti(2550 + 25 * i), CentiC::fromCenti(20),
+                   (uint16_t)(i % 3 * 5), ALERT_WARNING };
+    }
+    AlertEngine engine;
+    engine.begin(rules, count);
+    const int rounds = 200;
+    uint32_t time = 0, readings = 0;
+    double start = nowNs();
+    for (int round = 0; round < rounds; round++) {
+      for (auto &capture : captures) {
+        for (int16_t value : capture) sink += engine.update(time += 1000, CentiC::fromCenti(value));
+        readings += capture.size();
+      }
+    }
+    printf("alerts      %u rules %8.1f ns/reading, %.2f events/reading\n", count, (nowNs() - start) / readings,
+           (double)engine.eventsLogged() / readings);
+  }
+}
+
+// Nearest ADC code for a temperature, the table rises with the code
+static uint16_t codeForCentiC(int16_t centi) {
+  uint16_t lo = 1, hi = ADC_MAX_CODE - 1;
+  while (lo < hi) {
+    uint16_t mid = (lo + hi) / 2;
+    if (thermistorCentiC(mid).raw < centi) lo = mid + 1;
+    else hi = mid;
+  }
+  if (lo > 1 && centi - thermistorCentiC(lo - 1).raw < thermistorCentiC(lo).raw - centi) lo--;
+  return lo;
+}
+
+// Readings until a step of the input has gone through the filter to the given percentage
+static int stepDelay(uint8_t shift, int percent) {
+  AdcFilter filter(shift);
+  uint16_t code = 500;
+  filter.update(&code, 1);
+  const int step = 20 * ADC_FILTER_Q4_ONE;
+  for (int n = 1; n < 10000; n++) {
+    code = 520;
+    if ((filter.update(&code, 1) - 500 * ADC_FILTER_Q4_ONE) * 100 >= step * percent) return n;
+  }
+  return -1;
+}
+
+static void benchFilter() {
+  std::vector<std::vector<int16_t>> captures = loadCaptures();
+  if (captures.empty()) return;  // Reported by benchCompression()
+  // The captures hold one reading per second, each goes in as a burst of one code
+  printf("filter      shift  RMS change before -> after   step delay 50%% / 90%%\n");
+  for (uint8_t shift = 0; shift <= 4; shift++) {
+    double before = 0, after = 0;
+    size_t steps = 0;
+    for (auto &capture : captures) {
+      AdcFilter filter(shift);
+      int16_t lastIn = 0, lastOut = 0;
+      for (size_t i = 0; i < capture.size(); i++) {
+        uint16_t code = codeForCentiC(capture[i]);
+        int16_t in = thermistorCentiC(code).raw;
+        int16_t out = thermistorCentiCFromQ4(filter.update(&code, 1)).raw;
+        if (i > 0) {
+          before += (double)(in - lastIn) * (in - lastIn);
+          after += (double)(out - lastOut) * (out - lastOut);
+          steps++;
+        }
+        lastIn = in;
+        lastOut = out;
+      }
+    }
+    printf("filter      %u%s     %8.2f C -> %.2f C          %d / %d readings\n", shift,
+           shift == ADC_EMA_SHIFT ? "*" : " ", sqrt(before / steps) / 100, sqrt(after / steps) / 100,
+           stepDelay(shift, 50), stepDelay(shift, 90));
+  }
+}
+
+int native_bench() {
+  native_set_serial_sink(nullptr);
+  native_runner_begin();
+  bool ok = benchConversion();
+  benchLoop();
+  benchRender();
+  benchCompression();
+  benchAlerts();
+  benchFilter();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,172 @@
+/*
+ * Native HAL shim: file system
+ * Files live in a map from path to contents. The whole table can be saved to and loaded
+ * from an image file, so a run can pick up the flash contents of an earlier one (--flash).
+ */
+#include <map>
+#include <string>
+#include <vector>
+#include "LittleFS.h"
+#include "native_hal.h"
+
+FS LittleFS;
+
+static std::map<std::string, std::vector<uint8_t>> files;
+static uint64_t flashWrites = 0, flashBytes = 0;
+
+size_t File::write(const uint8_t *buffer, size_t size) {
+  if (!valid || !writable) return 0;
+  std::vector<uint8_t> &data = files[path];
+  if (append) pos = data.size();
+  if (pos + size > data.size()) data.resize(pos + size);
+  std::copy(buffer, buffer + size, data.begin() + pos);
+  pos += size;
+  flashWrites++;
+  flashBytes += size;
+  return size;
+}
+
+size_t File::read(uint8_t *buffer, size_t size) {
+  if (!valid || !readable) return 0;
+  const std::vector<uint8_t> &data = files[path];
+  if (pos >= data.size()) return 0;
+  size_t n = std::min(size, data.size() - pos);
+  std::copy(data.begin() + pos, data.begin() + pos + n, buffer);
+  pos += n;
+  return n;
+}
+
+int File::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+bool File::seek(uint32_t offset, SeekMode mode) {
+  if (!valid) return false;
+  size_t base = mode == SeekCur ? pos : mode == SeekEnd ? size() : 0;
+  if (base + offset > size()) return false;
+  pos = base + offset;
+  return true;
+}
+
+size_t File::size() const {
+  auto it = files.find(path);
+  return valid && it != files.end() ? it->second.size() : 0;
+}
+
+bool File::truncate(uint32_t size) {
+  if (!valid || !writable) return false;
+  files[path].resize(size);
+  if (pos > size) pos = size;
+  flashWrites++;
+  return true;
+}
+
+const char *File::name() const {
+  size_t slash = path.rfind('/');
+  return path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+}
+
+bool Dir::next() {
+  std::string prefix = path + (path.empty() || path.back() != '/' ? "/" : "");
+  for (auto it = files.upper_bound(prefix + current); it != files.end(); ++it) {
+    if (it->first.compare(0, prefix.size(), prefix) != 0) break;
+    std::string rest = it->first.substr(prefix.size());
+    if (rest.find('/') != std::string::npos) continue;  // In a subdirectory
+    current = rest;
+    return true;
+  }
+  return false;
+}
+
+size_t Dir::fileSize() const {
+  auto it = files.find(path + "/" + current);
+  return it == files.end() ? 0 : it->second.size();
+}
+
+File Dir::openFile(const char *mode) { return LittleFS.open((path + "/" + current).c_str(), mode); }
+
+bool FS::format() {
+  files.clear();
+  return true;
+}
+
+File FS::open(const char *path, const char *mode) {
+  std::string m = mode;
+  bool plus = m.find('+') != std::string::npos;
+  auto it = files.find(path);
+  if (m[0] == 'r') {
+    if (it == files.end()) return File();
+    return File(path, true, plus, false);
+  }
+  if (m[0] == 'w') {
+    files[path].clear();
+    flashWrites++;
+    return File(path, plus, true, false);
+  }
+  if (m[0] == 'a') {
+    files[path];  // Create
+    File f(path, plus, true, true);
+    f.seek(0, SeekEnd);
+    return f;
+  }
+  return File();
+}
+
+bool FS::exists(const char *path) { return files.count(path) > 0; }
+
+bool FS::remove(const char *path) {
+  flashWrites++;
+  return files.erase(path) > 0;
+}
+
+bool FS::rename(const char *from, const char *to) {
+  auto it = files.find(from);
+  if (it == files.end()) return false;
+  files[to] = it->second;
+  files.erase(from);
+  flashWrites++;
+  return true;
+}
+
+bool FS::info(FSInfo &info) {
+  size_t used = 0;
+  for (auto &f : files) used += (f.second.size() + 4095) / 4096 * 4096;
+  info = { NATIVE_FLASH_FS_BYTES, used, 4096, 256, 5, 32 };
+  return true;
+}
+
+uint64_t native_flash_writes() { return flashWrites; }
+uint64_t native_flash_bytes_written() { return flashBytes; }
+
+// Image: per file a 16-bit name length, the name, a 32-bit size and the contents
+bool native_flash_load(const char *path) {
+  FILE *f = fopen(path, "rb");
+  if (!f) return false;
+  files.clear();
+  uint16_t nameLength;
+  while (fread(&nameLength, sizeof(nameLength), 1, f) == 1) {
+    std::string name(nameLength, 0);
+    uint32_t size;
+    if (fread(&name[0], 1, nameLength, f) != nameLength || fread(&size, sizeof(size), 1, f) != 1) break;
+    std::vector<uint8_t> &data = files[name];
+    data.resize(size);
+    if (size && fread(data.data(), 1, size, f) != size) break;
+  }
+  fclose(f);
+  return true;
+}
+
+bool native_flash_save(const char *path) {
+  FILE *f = fopen(path, "wb");
+  if (!f) return false;
+  for (auto &file : files) {
+    uint16_t nameLength = (uint16_t)file.first.size();
+    uint32_t size = (uint32_t)file.second.size();
+    fwrite(&nameLength, sizeof(nameLength), 1, f);
+    fwrite(file.first.data(), 1, nameLength, f);
+    fwrite(&size, sizeof(size), 1, f);
+    fwrite(file.second.data(), 1, size, f);
+  }
+  return fclose(f) == 0;
+}
@@ -0,0 +1,406 @@
+/*
+ * Native HAL shim: Adafruit_GFX and ST7735
+ * The GFX layer follows the library's structure (which primitives call which), the ST7735
+ * layer emulates the controller: address window, MADCTL rotation, column/row offsets and
+ * vertical scroll, counting every byte that would go over SPI.
+ */
+#include <Adafruit_GFX.h>
+#include <Adafruit_ST7735.h>
+#include <Fonts/TomThumb.h>
+#include <Fonts/FreeSansBold12pt7b.h>
+
+#include "native_hal.h"
+
+#define MADCTL_MY 0x80
+#define MADCTL_MX 0x40
+#define MADCTL_MV 0x20
+
+// ---- Fonts (metrics only) ----
+
+static GFXglyph tomThumbGlyphs[0x7E - 0x20 + 1];
+static GFXglyph freeSansGlyphs[0x7E - 0x20 + 1];
+
+static bool initFontGlyphs() {
+  for (int i = 0; i <= 0x7E - 0x20; i++) {
+    bool space = (i == 0);
+    tomThumbGlyphs[i] = { 0, (uint8_t)(space ? 0 : 3), (uint8_t)(space ? 0 : 5), 4, 0, -5 };
+    freeSansGlyphs[i] = { 0, (uint8_t)(space ? 0 : 12), (uint8_t)(space ? 0 : 17), 14, 1, -17 };
+  }
+  return true;
+}
+static bool fontGlyphsReady = initFontGlyphs();
+
+const GFXfont TomThumb = { nullptr, tomThumbGlyphs, 0x20, 0x7E, 6 };
+const GFXfont FreeSansBold12pt7b = { nullptr, freeSansGlyphs, 0x20, 0x7E, 29 };
+
+// Stand-in for the glyph bitmaps: roughly half of the cells are set, like real text
+static bool glyphBit(unsigned char c, int col, int row) {
+  return ((c * 31 + col * 7 + row * 3) & 1) != 0;
+}
+
+// ---- Adafruit_GFX ----
+
+Adafruit_GFX::Adafruit_GFX(int16_t w, int16_t h) : WIDTH(w), HEIGHT(h) {
+  (void)fontGlyphsReady;
+  _width = WIDTH;
+  _height = HEIGHT;
+  rotation = 0;
+  cursor_y = cursor_x = 0;
+  textsize_x = textsize_y = 1;
+  textcolor = textbgcolor = 0xFFFF;
+  wrap = true;
+  _cp437 = false;
+  gfxFont = NULL;
+}
+
+void Adafruit_GFX::writeLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+  bool steep = abs(y1 - y0) > abs(x1 - x0);
+  if (steep) { std::swap(x0, y0); std::swap(x1, y1); }
+  if (x0 > x1) { std::swap(x0, x1); std::swap(y0, y1); }
+  int16_t dx = x1 - x0, dy = abs(y1 - y0);
+  int16_t err = dx / 2;
+  int16_t ystep = y0 < y1 ? 1 : -1;
+  for (; x0 <= x1; x0++) {
+    if (steep) writePixel(y0, x0, color);
+    else writePixel(x0, y0, color);
+    err -= dy;
+    if (err < 0) { y0 += ystep; err += dx; }
+  }
+}
+
+void Adafruit_GFX::setRotation(uint8_t x) {
+  rotation = (x & 3);
+  _width = (rotation & 1) ? HEIGHT : WIDTH;
+  _height = (rotation & 1) ? WIDTH : HEIGHT;
+}
+
+void Adafruit_GFX::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  startWrite();
+  writeLine(x, y, x, y + h - 1, color);
+  endWrite();
+}
+
+void Adafruit_GFX::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  startWrite();
+  writeLine(x, y, x + w - 1, y, color);
+  endWrite();
+}
+
+void Adafruit_GFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  startWrite();
+  for (int16_t i = x; i < x + w; i++) writeFastVLine(i, y, h, color);
+  endWrite();
+}
+
+void Adafruit_GFX::fillScreen(uint16_t color) { fillRect(0, 0, _width, _height, color); }
+
+void Adafruit_GFX::drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color) {
+  if (x0 == x1) {
+    if (y0 > y1) std::swap(y0, y1);
+    drawFastVLine(x0, y0, y1 - y0 + 1, color);
+  } else if (y0 == y1) {
+    if (x0 > x1) std::swap(x0, x1);
+    drawFastHLine(x0, y0, x1 - x0 + 1, color);
+  } else {
+    startWrite();
+    writeLine(x0, y0, x1, y1, color);
+    endWrite();
+  }
+}
+
+void Adafruit_GFX::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  startWrite();
+  writeFastHLine(x, y, w, color);
+  writeFastHLine(x, y + h - 1, w, color);
+  writeFastVLine(x, y, h, color);
+  writeFastVLine(x + w - 1, y, h, color);
+  endWrite();
+}
+
+void Adafruit_GFX::drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size_x, uint8_t size_y) {
+  startWrite();
+  if (!gfxFont) {
+    // Classic 5x7 font in a 6x8 cell
+    if (x >= _width || y >= _height || (x + 6 * size_x - 1) < 0 || (y + 8 * size_y - 1) < 0) { endWrite(); return; }
+    for (int8_t i = 0; i < 5; i++) {
+      for (int8_t j = 0; j < 8; j++) {
+        bool on = j < 7 && c != ' ' && glyphBit(c, i, j);
+        if (on || bg != color) {
+          uint16_t col = on ? color : bg;
+          if (size_x == 1 && size_y == 1) writePixel(x + i, y + j, col);
+          else writeFillRect(x + i * size_x, y + j * size_y, size_x, size_y, col);
+        }
+      }
+    }
+    if (bg != color) {
+      if (size_x == 1 && size_y == 1) writeFastVLine(x + 5, y, 8, bg);
+      else writeFillRect(x + 5 * size_x, y, size_x, 8 * size_y, bg);
+    }
+  } else {
+    // Custom font, transparent background
+    if (c < gfxFont->first || c > gfxFont->last) { endWrite(); return; }
+    const GFXglyph &g = gfxFont->glyph[c - gfxFont->first];
+    for (int yy = 0; yy < g.height; yy++) {
+      for (int xx = 0; xx < g.width; xx++) {
+        if (!glyphBit(c, xx, yy)) continue;
+        if (size_x == 1 && size_y == 1) writePixel(x + g.xOffset + xx, y + g.yOffset + yy, color);
+        else writeFillRect(x + (g.xOffset + xx) * size_x, y + (g.yOffset + yy) * size_y, size_x, size_y, color);
+      }
+    }
+  }
+  endWrite();
+}
+
+size_t Adafruit_GFX::write(uint8_t c) {
+  if (!gfxFont) {
+    if (c == '\n') {
+      cursor_x = 0;
+      cursor_y += textsize_y * 8;
+    } else if (c != '\r') {
+      if (wrap && ((cursor_x + textsize_x * 6) > _width)) {
+        cursor_x = 0;
+        cursor_y += textsize_y * 8;
+      }
+      drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize_x, textsize_y);
+      cursor_x += textsize_x * 6;
+    }
+  } else {
+    if (c == '\n') {
+      cursor_x = 0;
+      cursor_y += (int16_t)textsize_y * gfxFont->yAdvance;
+    } else if (c != '\r' && c >= gfxFont->first && c <= gfxFont->last) {
+      const GFXglyph &g = gfxFont->glyph[c - gfxFont->first];
+      if (g.width > 0 && g.height > 0) {
+        if (wrap && ((cursor_x + textsize_x * (g.xOffset + g.width)) > _width)) {
+          cursor_x = 0;
+          cursor_y += (int16_t)textsize_y * gfxFont->yAdvance;
+        }
+        drawChar(cursor_x, cursor_y, c, textcolor, textbgcolor, textsize_x, textsize_y);
+      }
+      cursor_x += g.xAdvance * (int16_t)textsize_x;
+    }
+  }
+  return 1;
+}
+
+void Adafruit_GFX::setFont(const GFXfont *f) {
+  if (f && !gfxFont) cursor_y += 6;        // Same baseline adjustment as the library
+  else if (!f && gfxFont) cursor_y -= 6;
+  gfxFont = (GFXfont *)f;
+}
+
+void Adafruit_GFX::charBounds(unsigned char c, int16_t *x, int16_t *y, int16_t *minx, int16_t *miny, int16_t *maxx, int16_t *maxy) {
+  if (gfxFont) {
+    if (c == '\n') {
+      *x = 0;
+      *y += textsize_y * gfxFont->yAdvance;
+    } else if (c != '\r' && c >= gfxFont->first && c <= gfxFont->last) {
+      const GFXglyph &g = gfxFont->glyph[c - gfxFont->first];
+      int16_t x1 = *x + g.xOffset * textsize_x, y1 = *y + g.yOffset * textsize_y;
+      int16_t x2 = x1 + g.width * textsize_x - 1, y2 = y1 + g.height * textsize_y - 1;
+      if (x1 < *minx) *minx = x1;
+      if (y1 < *miny) *miny = y1;
+      if (x2 > *maxx) *maxx = x2;
+      if (y2 > *maxy) *maxy = y2;
+      *x += g.xAdvance * textsize_x;
+    }
+  } else {
+    if (c == '\n') {
+      *x = 0;
+      *y += textsize_y * 8;
+    } else if (c != '\r') {
+      int16_t x2 = *x + textsize_x * 6 - 1, y2 = *y + textsize_y * 8 - 1;
+      if (x2 > *maxx) *maxx = x2;
+      if (y2 > *maxy) *maxy = y2;
+      if (*x < *minx) *minx = *x;
+      if (*y < *miny) *miny = *y;
+      *x += textsize_x * 6;
+    }
+  }
+}
+
+void Adafruit_GFX::getTextBounds(const char *str, int16_t x, int16_t y, int16_t *x1, int16_t *y1, uint16_t *w, uint16_t *h) {
+  int16_t minx = 0x7FFF, miny = 0x7FFF, maxx = -1, maxy = -1;
+  *x1 = x;
+  *y1 = y;
+  *w = *h = 0;
+  while (*str) charBounds(*str++, &x, &y, &minx, &miny, &maxx, &maxy);
+  if (maxx >= minx) { *x1 = minx; *w = maxx - minx + 1; }
+  if (maxy >= miny) { *y1 = miny; *h = maxy - miny + 1; }
+}
+
+// ---- GFXcanvas16 ----
+
+GFXcanvas16::GFXcanvas16(uint16_t w, uint16_t h) : Adafruit_GFX(w, h) {
+  buffer = (uint16_t *)calloc((size_t)w * h, sizeof(uint16_t));
+}
+
+GFXcanvas16::~GFXcanvas16(void) { free(buffer); }
+
+void GFXcanvas16::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  if (!buffer || x < 0 || y < 0 || x >= _width || y >= _height) return;
+  int16_t t;
+  switch (rotation) {
+    case 1: t = x; x = WIDTH - 1 - y; y = t; break;
+    case 2: x = WIDTH - 1 - x; y = HEIGHT - 1 - y; break;
+    case 3: t = x; x = y; y = HEIGHT - 1 - t; break;
+  }
+  buffer[x + y * WIDTH] = color;
+}
+
+void GFXcanvas16::fillScreen(uint16_t color) {
+  if (!buffer) return;
+  for (uint32_t i = 0, n = (uint32_t)WIDTH * HEIGHT; i < n; i++) buffer[i] = color;
+}
+
+void GFXcanvas16::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  for (int16_t i = 0; i < h; i++) drawPixel(x, y + i, color);
+}
+
+void GFXcanvas16::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  for (int16_t i = 0; i < w; i++) drawPixel(x + i, y, color);
+}
+
+// ---- Adafruit_SPITFT (controller emulation) ----
+
+void Adafruit_SPITFT::ramWrite(uint16_t color) {
+  // MCU address -> physical RAM: mirror (MX/MY) on the MCU axes, then exchange (MV)
+  bool mv = madctl & MADCTL_MV;
+  int x = winX, y = winY;
+  if (madctl & MADCTL_MX) x = (mv ? NATIVE_TFT_RAM_ROWS : NATIVE_TFT_RAM_COLS) - 1 - x;
+  if (madctl & MADCTL_MY) y = (mv ? NATIVE_TFT_RAM_COLS : NATIVE_TFT_RAM_ROWS) - 1 - y;
+  int row = mv ? x : y, col = mv ? y : x;
+  if (row >= 0 && row < NATIVE_TFT_RAM_ROWS && col >= 0 && col < NATIVE_TFT_RAM_COLS) ram[row][col] = color;
+
+  // Advance the address counter through the window
+  if (++winX > winX1) {
+    winX = winX0;
+    if (++winY > winY1) winY = winY0;
+  }
+}
+
+uint16_t Adafruit_SPITFT::screenPixel(int16_t x, int16_t y) const {
+  // Same address mapping as ramWrite(), then the vertical scroll: inside the scroll area
+  // panel line r shows RAM line tfa + (vscrsadd - tfa + r - tfa) mod vsa
+  bool mv = madctl & MADCTL_MV;
+  int ax = x + _xstart, ay = y + _ystart;
+  if (madctl & MADCTL_MX) ax = (mv ? NATIVE_TFT_RAM_ROWS : NATIVE_TFT_RAM_COLS) - 1 - ax;
+  if (madctl & MADCTL_MY) ay = (mv ? NATIVE_TFT_RAM_COLS : NATIVE_TFT_RAM_ROWS) - 1 - ay;
+  int row = mv ? ax : ay, col = mv ? ay : ax;
+  if (vscrVsa > 0 && row >= vscrTfa && row < vscrTfa + vscrVsa) {
+    row = vscrTfa + ((int)vscrsadd - vscrTfa + row - vscrTfa + vscrVsa) % vscrVsa;
+  }
+  if (row < 0 || row >= NATIVE_TFT_RAM_ROWS || col < 0 || col >= NATIVE_TFT_RAM_COLS) return 0;
+  return ram[row][col];
+}
+
+void Adafruit_SPITFT::writePixels(uint16_t *colors, uint32_t len, bool block, bool bigEndian) {
+  (void)block;
+  (void)bigEndian;
+  spiBytes += len * 2;
+  native_count_spi(len * 2);
+  while (len--) ramWrite(*colors++);
+}
+
+void Adafruit_SPITFT::writeColor(uint16_t color, uint32_t len) {
+  spiBytes += len * 2;
+  native_count_spi(len * 2);
+  while (len--) ramWrite(color);
+}
+
+void Adafruit_SPITFT::sendCommand(uint8_t commandByte, const uint8_t *dataBytes, uint8_t numDataBytes) {
+  spiBytes += 1 + numDataBytes;
+  native_count_spi(1 + numDataBytes);
+  switch (commandByte) {
+    case ST77XX_MADCTL:
+      if (numDataBytes >= 1) madctl = dataBytes[0];
+      break;
+    case ST77XX_VSCRDEF:
+      if (numDataBytes >= 6) {
+        vscrTfa = (dataBytes[0] << 8) | dataBytes[1];
+        vscrVsa = (dataBytes[2] << 8) | dataBytes[3];
+        vscrBfa = (dataBytes[4] << 8) | dataBytes[5];
+      }
+      break;
+    case ST77XX_VSCRSADD:
+      if (numDataBytes >= 2) vscrsadd = (dataBytes[0] << 8) | dataBytes[1];
+      break;
+  }
+}
+
+void Adafruit_SPITFT::writeFillRectPreclipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  setAddrWindow(x, y, w, h);
+  writeColor(color, (uint32_t)w * h);
+}
+
+void Adafruit_SPITFT::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  writePixelPreclipped(x, y, color);
+}
+
+void Adafruit_SPITFT::writePixel(int16_t x, int16_t y, uint16_t color) {
+  writePixelPreclipped(x, y, color);
+}
+
+void Adafruit_SPITFT::writePixelPreclipped(int16_t x, int16_t y, uint16_t color) {
+  if (x < 0 || y < 0 || x >= _width || y >= _height) return;
+  setAddrWindow(x, y, 1, 1);
+  spiBytes += 2;
+  native_count_spi(2);
+  ramWrite(color);
+}
+
+// Like the library, every rectangle primitive clips and fills directly (no virtual calls)
+void Adafruit_SPITFT::fillRectClipped(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  if (w < 0) { x += w + 1; w = -w; }
+  if (h < 0) { y += h + 1; h = -h; }
+  int16_t x2 = x + w - 1, y2 = y + h - 1;
+  if (w == 0 || h == 0 || x >= _width || y >= _height || x2 < 0 || y2 < 0) return;
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x2 >= _width) x2 = _width - 1;
+  if (y2 >= _height) y2 = _height - 1;
+  writeFillRectPreclipped(x, y, x2 - x + 1, y2 - y + 1, color);
+}
+
+void Adafruit_SPITFT::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { fillRectClipped(x, y, w, h, color); }
+void Adafruit_SPITFT::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) { fillRectClipped(x, y, w, h, color); }
+void Adafruit_SPITFT::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { fillRectClipped(x, y, w, 1, color); }
+void Adafruit_SPITFT::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { fillRectClipped(x, y, 1, h, color); }
+void Adafruit_SPITFT::writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) { fillRectClipped(x, y, w, 1, color); }
+void Adafruit_SPITFT::writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) { fillRectClipped(x, y, 1, h, color); }
+
+// ---- Adafruit_ST77xx / Adafruit_ST7735 ----
+
+void Adafruit_ST77xx::setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+  x += _xstart;
+  y += _ystart;
+  spiBytes += 11;  // CASET + 4, RASET + 4, RAMWR
+  native_count_spi(11);
+  winX0 = winX = x;
+  winX1 = x + w - 1;
+  winY0 = winY = y;
+  winY1 = y + h - 1;
+}
+
+void Adafruit_ST77xx::setRotation(uint8_t m) { Adafruit_GFX::setRotation(m); }
+
+void Adafruit_ST7735::initR(uint8_t options) {
+  (void)options;
+  _colstart = 2;
+  _rowstart = 1;
+  setRotation(0);
+}
+
+void Adafruit_ST7735::setRotation(uint8_t m) {
+  uint8_t cmd;
+  rotation = m & 3;
+  switch (rotation) {
+    case 0: cmd = MADCTL_MX | MADCTL_MY; _xstart = _colstart; _ystart = _rowstart; break;
+    case 1: cmd = MADCTL_MY | MADCTL_MV; _ystart = _colstart; _xstart = _rowstart; break;
+    case 2: cmd = 0; _xstart = _colstart; _ystart = _rowstart; break;
+    default: cmd = MADCTL_MX | MADCTL_MV; _ystart = _colstart; _xstart = _rowstart; break;
+  }
+  _width = (rotation & 1) ? ST7735_TFTHEIGHT_160 : ST7735_TFTWIDTH_128;
+  _height = (rotation & 1) ? ST7735_TFTWIDTH_128 : ST7735_TFTHEIGHT_160;
+  sendCommand(ST77XX_MADCTL, &cmd, 1);
+}
@@ -0,0 +1,286 @@
+/*
+ * Native HAL shim: Arduino core
+ * Virtual time, scripted pins and a captured Serial port. The runner (native_main.cpp)
+ * drives the scripts; the firmware only sees the Arduino API.
+ */
+#include <Arduino.h>
+#include <Ticker.h>
+#include <SPI.h>
+#include <ESP8266WiFi.h>
+#include <ArduinoOTA.h>
+#include <WiFiUdp.h>
+#include <stdarg.h>
+#include <chrono>
+#include <string>
+#include "native_hal.h"
+
+HardwareSerial Serial;
+EspClass ESP;
+SPIClass SPI;
+ESP8266WiFiClass WiFi;
+ArduinoOTAClass ArduinoOTA;
+
+static uint64_t virtualUs = 0;                   // Virtual time since boot
+static int pinLevel[NATIVE_PIN_COUNT];           // Scripted digital inputs
+static int pinOutput[NATIVE_PIN_COUNT];          // Last value written to each pin
+static NativeAdcSource adcSource = nullptr;      // Scripted analog input
+static void (*pinIsr[NATIVE_PIN_COUNT])(void);   // attachInterrupt() handlers
+static int pinIsrMode[NATIVE_PIN_COUNT];
+static FILE *serialSink = nullptr;               // Where Serial output goes (nullptr = discard)
+static uint64_t serialBytes = 0;
+static uint64_t serialIdleUs = 0;                // Virtual time when the UART FIFO is empty again
+static uint64_t serialBlockedUs = 0;             // Time write() spent waiting for FIFO room
+static std::string serialRx;                     // Scripted bytes waiting for Serial.read()
+#define NATIVE_UART_FIFO 128                     // ESP8266 TX FIFO bytes
+#define NATIVE_UART_US_PER_BYTE 87               // 10 bits at 115200 baud
+static uint32_t ntpEpoch = 0;                    // 0 = NTP does not answer
+static uint64_t spiBytes = 0;                    // Bytes sent to the display by all instances
+
+// ---- Runner interface ----
+
+void native_reset() {
+  virtualUs = 0;
+  serialIdleUs = 0;
+  serialBlockedUs = 0;
+  serialRx.clear();
+  for (int i = 0; i < NATIVE_PIN_COUNT; i++) {
+    pinLevel[i] = HIGH;  // Buttons idle high (INPUT_PULLUP)
+    pinOutput[i] = 0;
+    pinIsr[i] = nullptr;
+  }
+}
+
+void native_advance_us(uint64_t us) {
+  virtualUs += us;
+  Ticker::serviceAll();
+}
+
+uint64_t native_time_us() { return virtualUs; }
+
+void native_set_pin(uint8_t pin, int level) {
+  if (pin >= NATIVE_PIN_COUNT) return;
+  int old = pinLevel[pin];
+  pinLevel[pin] = level;
+  if (pinIsr[pin] != nullptr && old != level) {
+    int mode = pinIsrMode[pin];
+    if (mode == CHANGE || (mode == FALLING && level == LOW) || (mode == RISING && level == HIGH)) {
+      pinIsr[pin]();
+    }
+  }
+}
+
+int native_get_output(uint8_t pin) { return pin < NATIVE_PIN_COUNT ? pinOutput[pin] : 0; }
+void native_set_adc_source(NativeAdcSource source) { adcSource = source; }
+void native_set_serial_sink(FILE *sink) { serialSink = sink; }
+void native_serial_input(const char *text) { serialRx += text; }
+uint64_t native_serial_bytes() { return serialBytes; }
+void native_set_ntp_epoch(uint32_t epoch) { ntpEpoch = epoch; }
+void native_count_spi(uint32_t bytes) { spiBytes += bytes; }
+uint64_t native_spi_bytes() { return spiBytes; }
+
+// ---- Arduino API ----
+
+unsigned long millis() { return (unsigned long)(virtualUs / 1000); }
+unsigned long micros() { return (unsigned long)virtualUs; }
+void delay(unsigned long ms) { native_advance_us((uint64_t)ms * 1000); }
+void delayMicroseconds(unsigned int us) { native_advance_us(us); }
+void yield() {}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  if (in_max == in_min) return out_min;  // The AVR core divides by zero here
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+int analogRead(uint8_t pin) {
+  (void)pin;
+  return adcSource ? adcSource(virtualUs) : 512;
+}
+
+int digitalRead(uint8_t pin) { return pin < NATIVE_PIN_COUNT ? pinLevel[pin] : LOW; }
+void digitalWrite(uint8_t pin, uint8_t val) { if (pin < NATIVE_PIN_COUNT) pinOutput[pin] = val; }
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+void analogWrite(uint8_t pin, int val) { if (pin < NATIVE_PIN_COUNT) pinOutput[pin] = val; }
+void analogWriteRange(uint32_t range) { (void)range; }
+void analogWriteFreq(uint32_t freq) { (void)freq; }
+void tone(uint8_t pin, unsigned int frequency, unsigned long duration) { (void)pin; (void)frequency; (void)duration; }
+void noTone(uint8_t pin) { (void)pin; }
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {
+  if (pin >= NATIVE_PIN_COUNT) return;
+  pinIsr[pin] = isr;
+  pinIsrMode[pin] = mode;
+}
+
+void detachInterrupt(uint8_t pin) { if (pin < NATIVE_PIN_COUNT) pinIsr[pin] = nullptr; }
+void noInterrupts() {}
+void interrupts() {}
+
+uint32_t EspClass::getCycleCount() {
+  // 80 MHz worth of cycles of real host time, so profiling zones measure host cost
+  static const auto start = std::chrono::steady_clock::now();
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+  return (uint32_t)(ns * 80 / 1000);
+}
+
+// ---- String / Print / Serial ----
+
+void String::trim() {
+  size_t b = find_first_not_of(" \t\r\n");
+  size_t e = find_last_not_of(" \t\r\n");
+  if (b == npos) { clear(); return; }
+  *this = String(substr(b, e - b + 1));
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--) n += write(*buffer++);
+  return n;
+}
+
+size_t Print::print(long n, int base) {
+  char buf[34];
+  if (base == 10) snprintf(buf, sizeof(buf), "%ld", n);
+  else if (base == 16) snprintf(buf, sizeof(buf), "%lx", n);
+  else snprintf(buf, sizeof(buf), "%ld", n);
+  return write(buf);
+}
+
+size_t Print::print(unsigned long n, int base) {
+  char buf[34];
+  if (base == 16) snprintf(buf, sizeof(buf), "%lx", n);
+  else snprintf(buf, sizeof(buf), "%lu", n);
+  return write(buf);
+}
+
+size_t Print::print(double n, int digits) {
+  char buf[48];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
+
+size_t Print::printf(const char *format, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, format);
+  int len = vsnprintf(buf, sizeof(buf), format, args);
+  va_end(args);
+  if (len < 0) return 0;
+  return write((const uint8_t *)buf, (size_t)len < sizeof(buf) ? (size_t)len : sizeof(buf) - 1);
+}
+
+int HardwareSerial::available() { return (int)serialRx.size(); }
+
+int HardwareSerial::read() {
+  if (serialRx.empty()) return -1;
+  int c = (uint8_t)serialRx[0];
+  serialRx.erase(0, 1);
+  return c;
+}
+// Bytes still in the TX FIFO, it drains at the line rate in virtual time
+static int serialFifoLevel() {
+  if (serialIdleUs <= virtualUs) return 0;
+  return (int)((serialIdleUs - virtualUs + NATIVE_UART_US_PER_BYTE - 1) / NATIVE_UART_US_PER_BYTE);
+}
+
+int HardwareSerial::availableForWrite() { return NATIVE_UART_FIFO - serialFifoLevel(); }
+
+size_t HardwareSerial::write(uint8_t c) {
+  // Like the core: busy-wait (here: advance virtual time) while the FIFO is full
+  if (serialFifoLevel() >= NATIVE_UART_FIFO) {
+    uint64_t wait = serialIdleUs - (uint64_t)(NATIVE_UART_FIFO - 1) * NATIVE_UART_US_PER_BYTE - virtualUs;
+    virtualUs += wait;
+    serialBlockedUs += wait;
+  }
+  serialIdleUs = (serialIdleUs > virtualUs ? serialIdleUs : virtualUs) + NATIVE_UART_US_PER_BYTE;
+  serialBytes++;
+  if (serialSink) fputc(c, serialSink);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  for (size_t i = 0; i < size; i++) write(buffer[i]);
+  return size;
+}
+
+uint64_t native_serial_blocked_us() { return serialBlockedUs; }
+
+// ---- Ticker ----
+
+static Ticker *tickerList = nullptr;
+
+Ticker::Ticker() {}
+
+Ticker::~Ticker() { detach(); }
+
+void Ticker::attach_ms(uint32_t milliseconds, callback_t callback) {
+  detach();
+  cb = callback;
+  periodMs = milliseconds;
+  nextMs = millis() + milliseconds;
+  next = tickerList;
+  tickerList = this;
+}
+
+void Ticker::detach() {
+  for (Ticker **p = &tickerList; *p; p = &(*p)->next) {
+    if (*p == this) {
+      *p = next;
+      break;
+    }
+  }
+  cb = nullptr;
+}
+
+void Ticker::serviceAll() {
+  unsigned long now = millis();
+  for (Ticker *t = tickerList; t; t = t->next) {
+    while (t->cb && (long)(now - t->nextMs) >= 0) {
+      t->nextMs += t->periodMs;
+      t->cb();
+    }
+  }
+}
+
+// ---- WiFi and NTP over UDP ----
+
+wl_status_t ESP8266WiFiClass::status() { return ntpEpoch != 0 ? WL_CONNECTED : WL_DISCONNECTED; }
+
+int WiFiUDP::beginPacket(const char *host, uint16_t port) {
+  (void)host;
+  destPort = port;
+  sent = 0;
+  return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t *buffer, size_t size) {
+  (void)buffer;
+  sent += size;
+  return size;
+}
+
+int WiFiUDP::endPacket() {
+  if (destPort == 123 && sent >= sizeof(answer)) answerAtMs = millis() + NATIVE_NTP_DELAY_MS;
+  return 1;
+}
+
+int WiFiUDP::parsePacket() {
+  if (answerAtMs != 0 && millis() >= answerAtMs) {
+    answerAtMs = 0;
+    if (ntpEpoch != 0) {
+      // Transmit timestamp in NTP seconds (since 1900), the epoch given is the one at boot
+      uint32_t seconds = ntpEpoch + (uint32_t)(millis() / 1000) + 2208988800UL;
+      memset(answer, 0, sizeof(answer));
+      answer[0] = 0x24;  // Version 4, server
+      for (int i = 0; i < 4; i++) answer[40 + i] = (uint8_t)(seconds >> (24 - 8 * i));
+      available = sizeof(answer);
+    }
+  }
+  return (int)available;
+}
+
+int WiFiUDP::read(uint8_t *buffer, size_t size) {
+  size_t n = size < available ? size : available;
+  memcpy(buffer, answer, n);
+  available = 0;
+  return (int)n;
+}
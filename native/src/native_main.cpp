@@ -0,0 +1,477 @@
+/*
+ * Native runner
+ * Runs the firmware's setup() and loop() on the host against the HAL shim. Time is virtual:
+ * each loop() call is followed by 1 ms, delay() advances it too, so a minute of firmware
+ * time takes a fraction of a second. Inputs are scripted from the command line or a file.
+ *
+ *   native --seconds 120 --temp 27.5 --press 5000:up --press 8000:select --serial
+ *   native --script run.txt --screenshot screen.ppm
+ *   native --bench
+ *   native --plant default --seconds 86400
+ *   native --replay ../src/serial_outputs/COM8_2025_03_08.22.38.17.711.txt
+ *
+ * The sensor temperature comes from one of three sources:
+ *   script    "temp" and "ramp" below (default 27.5 C)
+ *   --plant   a thermal model of the enclosure that the firmware's fan output cools, see
+ *             thermal_plant.h for the model and the parameters ("default" or "heat=40,fan=1.5")
+ *   --replay  the "Temperature:" readings of a serial capture, one per --replay-period ms
+ *             (default 1000, the firmware's reading interval), open loop
+ * With --plant or --replay the report adds the fan duty cycle, the number of fan switches
+ * and the time spent above the high alert limit; --high C overrides the limit set in setup().
+ * A "predict" line checks the early warning (temp_predictor.h) against what happened:
+ * crossings of the limit (trend_stats.h events) that a warning came before and by how long,
+ * crossings without one, and warnings that cleared without a crossing.
+ *
+ * Script lines are "<ms> <command> <args>", '#' starts a comment:
+ *   0      temp 27.5           Sensor temperature from now on
+ *   10000  ramp 45 20000       Move linearly to 45 C over the next 20 s
+ *   20000  press up 100        Hold a button (up, select, back) for 100 ms (default)
+ *   30000  ntp 1741468800      NTP answers with this epoch from now on (0 = no answer)
+ *   40000  heat 45             Plant heat input in W (--plant only)
+ *   50000  ambient 32          Plant mean ambient temperature (--plant only)
+ *   60000  serial p            Send text to the firmware's serial port ('p' dumps the profiler)
+ *
+ * --profile prints the firmware's profiling zones at the end of the run. Zones time with
+ * ESP.getCycleCount(), which the shim backs with a steady clock, so they show host time.
+ *
+ * --flash IMAGE loads the LittleFS contents from IMAGE (when it exists) before the run and
+ * saves them after it, so consecutive runs see each other's flash log like restarts do.
+ * The report then adds the file system writes of the run.
+ *
+ * Build with "pio run -e native" or plain g++, see README.md.
+ */
+#include <Arduino.h>
+#include <vector>
+#include <string>
+#include "native_hal.h"
+#include "native_runner.h"
+#include "thermistor.h"
+#include "my_st7735.h"
+#include "thermal_plant.h"
+#include "fan_control.h"
+#include "temp_predictor.h"
+#include "trend_stats.h"
+#include "profile.h"
+
+void setup();
+void loop();
+extern MyST7735 display;
+extern CentiC highTempAlert;
+extern TempPredictor tempPredictor;
+extern TrendStats trendStats;
+
+struct ScriptEvent {
+  uint64_t ms;
+  enum { TEMP, RAMP, PRESS, NTP, HEAT, AMBIENT, SERIAL_INPUT } kind;
+  double value;       // Temperature, epoch for NTP, watts for HEAT
+  uint64_t duration;  // Ramp length or hold time in ms
+  uint8_t pin;
+  std::string text;   // SERIAL_INPUT bytes
+};
+
+static std::vector<ScriptEvent> script;
+static size_t scriptNext = 0;
+static double tempFrom = 27.5, tempTo = 27.5;  // Current ramp (from == to when steady)
+static uint64_t rampStartMs = 0, rampEndMs = 0;
+static int16_t codeCentiC[1024];               // thermistorCentiC() for every ADC code
+static ThermalPlant *plant = nullptr;          // --plant
+static std::vector<float> replay;              // --replay readings
+static uint64_t replayPeriodMs = 1000;
+
+// Fan and alert figures of a --plant or --replay run
+struct ControlStats {
+  uint64_t lastMs = 0;
+  double lastC = NAN;
+  double duty = 0;  // Fan PWM duty, 0..1
+  double dutyMs = 0, energyMs = 0;  // Fan power goes with speed cubed, energy is relative to full speed
+  uint64_t fanOnMs = 0, overMs = 0, switches = 0;
+  double maxC = -INFINITY;
+
+  // The temperature is taken as constant since the previous call
+  void account(uint64_t ms, double celsius) {
+    uint64_t elapsed = ms - lastMs;
+    if (duty > 0) fanOnMs += elapsed;
+    dutyMs += duty * elapsed;
+    energyMs += duty * duty * duty * elapsed;
+    if (lastC * 100 > highTempAlert.raw) overMs += elapsed;
+    lastMs = ms;
+    lastC = celsius;
+    if (celsius > maxC) maxC = celsius;
+  }
+};
+static ControlStats control;
+
+// Early warnings against the crossings that followed them
+struct PredictStats {
+  bool warning = false, crossing = false;
+  uint64_t warnedAtMs = 0;
+  bool pending = false;  // A warning without its crossing yet
+  uint64_t warned = 0, unwarned = 0, falseAlarms = 0;
+  double leadMs = 0;
+
+  void step(uint64_t ms) {
+    bool crossingNow = trendStats.crossing(), warningNow = tempPredictor.warning();
+    if (crossingNow && !crossing) {  // Checked before the warning, which clears on the same reading
+      if (pending) {
+        warned++;
+        leadMs += ms - warnedAtMs;
+      } else {
+        unwarned++;
+      }
+      pending = false;
+    }
+    if (warningNow && !warning && !pending) {
+      pending = true;
+      warnedAtMs = ms;
+    } else if (!warningNow && warning && pending && !crossingNow) {
+      falseAlarms++;
+      pending = false;
+    }
+    crossing = crossingNow;
+    warning = warningNow;
+  }
+};
+static PredictStats predict;
+
+// ---- Scripted inputs ----
+
+// Closest ADC code, the table is monotonic over the usable codes 1..1022
+static int adcForTemperature(double celsius) {
+  int32_t target = (int32_t)lround(celsius * 100);
+  bool rising = codeCentiC[1022] > codeCentiC[1];
+  int low = 1, high = 1022;
+  while (low < high) {
+    int mid = (low + high) / 2;
+    if (rising ? codeCentiC[mid] < target : codeCentiC[mid] > target) low = mid + 1;
+    else high = mid;
+  }
+  if (low > 1 && abs(codeCentiC[low - 1] - target) <= abs(codeCentiC[low] - target)) low--;
+  return low;
+}
+
+double native_script_temperature(uint64_t ms) {
+  if (ms >= rampEndMs || rampEndMs == rampStartMs) return tempTo;
+  if (ms <= rampStartMs) return tempFrom;
+  return tempFrom + (tempTo - tempFrom) * (double)(ms - rampStartMs) / (double)(rampEndMs - rampStartMs);
+}
+
+static double sensorTemperature(uint64_t ms) {
+  if (plant) {
+    plant->advance(ms);
+    return plant->temperature();
+  }
+  if (!replay.empty()) return replay[std::min<uint64_t>(ms / replayPeriodMs, replay.size() - 1)];
+  return native_script_temperature(ms);
+}
+
+static int scriptedAdc(uint64_t timeUs) {
+  static double lastCelsius = NAN;
+  static int lastCode = 0;
+  double celsius = sensorTemperature(timeUs / 1000);
+  control.account(timeUs / 1000, celsius);
+  if (celsius != lastCelsius) {  // The search is slow next to the firmware code being measured
+    lastCelsius = celsius;
+    lastCode = adcForTemperature(celsius);
+  }
+  return lastCode;
+}
+
+static bool addPress(uint64_t ms, const std::string &button, uint64_t holdMs) {
+  uint8_t pin = button == "up" ? D1 : button == "select" ? D2 : button == "back" ? D3 : 0xFF;
+  if (pin == 0xFF) return false;
+  // Keep the pending part of the script in time order, presses may be added while running
+  auto at = std::upper_bound(script.begin() + scriptNext, script.end(), ms,
+                             [](uint64_t t, const ScriptEvent &e) { return t < e.ms; });
+  script.insert(at, { ms, ScriptEvent::PRESS, 0, holdMs, pin, "" });
+  return true;
+}
+
+#ifndef PIO_UNIT_TESTING
+static bool loadScript(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+  char line[256];
+  int lineNo = 0;
+  while (fgets(line, sizeof(line), f)) {
+    lineNo++;
+    char *hash = strchr(line, '#');
+    if (hash) *hash = 0;
+    unsigned long long ms, duration = 0;
+    char command[16], arg[32] = "";
+    double value = 0;
+    int n = sscanf(line, "%llu %15s %31s %llu", &ms, command, arg, &duration);
+    if (n <= 0) continue;
+    std::string c = command;
+    bool ok = n >= 3;
+    value = atof(arg);
+    if (ok && c == "temp") script.push_back({ ms, ScriptEvent::TEMP, value, 0, 0, "" });
+    else if (ok && c == "ramp" && n == 4) script.push_back({ ms, ScriptEvent::RAMP, value, duration, 0, "" });
+    else if (ok && c == "press") ok = addPress(ms, arg, n == 4 ? duration : 100);
+    else if (ok && c == "ntp") script.push_back({ ms, ScriptEvent::NTP, value, 0, 0, "" });
+    else if (ok && c == "heat") script.push_back({ ms, ScriptEvent::HEAT, value, 0, 0, "" });
+    else if (ok && c == "ambient") script.push_back({ ms, ScriptEvent::AMBIENT, value, 0, 0, "" });
+    else if (ok && c == "serial") script.push_back({ ms, ScriptEvent::SERIAL_INPUT, 0, 0, 0, arg });
+    else ok = false;
+    if (!ok) {
+      fprintf(stderr, "%s:%d: cannot parse script line\n", path, lineNo);
+      fclose(f);
+      return false;
+    }
+  }
+  fclose(f);
+  return true;
+}
+#endif
+
+struct Release {
+  uint64_t ms;
+  uint8_t pin;
+};
+static std::vector<Release> releases;
+
+// Apply script events that are due, release buttons whose hold time is over
+static void runScript(uint64_t ms) {
+  for (size_t i = 0; i < releases.size();) {
+    if (releases[i].ms <= ms) {
+      native_set_pin(releases[i].pin, HIGH);
+      releases.erase(releases.begin() + i);
+    } else {
+      i++;
+    }
+  }
+  while (scriptNext < script.size() && script[scriptNext].ms <= ms) {
+    const ScriptEvent &e = script[scriptNext++];
+    switch (e.kind) {
+      case ScriptEvent::TEMP:
+        tempFrom = tempTo = e.value;
+        rampStartMs = rampEndMs = e.ms;
+        break;
+      case ScriptEvent::RAMP:
+        tempFrom = native_script_temperature(ms);
+        tempTo = e.value;
+        rampStartMs = ms;
+        rampEndMs = ms + e.duration;
+        break;
+      case ScriptEvent::PRESS:
+        native_set_pin(e.pin, LOW);
+        releases.push_back({ ms + e.duration, e.pin });
+        break;
+      case ScriptEvent::NTP:
+        native_set_ntp_epoch((uint32_t)e.value);
+        break;
+      case ScriptEvent::HEAT:
+        if (plant) plant->setHeat(ms, e.value);
+        break;
+      case ScriptEvent::AMBIENT:
+        if (plant) plant->setAmbient(ms, e.value);
+        break;
+      case ScriptEvent::SERIAL_INPUT:
+        native_serial_input(e.text.c_str());
+        break;
+    }
+  }
+}
+
+void native_runner_begin() {
+  for (int code = 0; code < 1024; code++) codeCentiC[code] = thermistorCentiC(code).raw;
+  native_reset();
+  native_set_adc_source(scriptedAdc);
+  std::stable_sort(script.begin(), script.end(), [](const ScriptEvent &a, const ScriptEvent &b) { return a.ms < b.ms; });
+  runScript(0);
+  setup();
+}
+
+void native_runner_step() {
+  runScript(native_time_us() / 1000);
+  loop();
+  predict.step(native_time_us() / 1000);
+  double duty = (double)native_get_output(FAN_PWM_PIN) / FAN_PWM_RANGE;
+  if (duty != control.duty) {
+    uint64_t ms = native_time_us() / 1000;
+    control.account(ms, sensorTemperature(ms));
+    if ((duty > 0) != (control.duty > 0)) control.switches++;
+    control.duty = duty;
+    if (plant) plant->setFanDuty(ms, duty);
+  }
+  native_advance_us(1000);
+}
+
+void native_press(uint64_t atMs, const char *button) { addPress(atMs, button, 100); }
+
+void native_run_until(uint64_t ms) {
+  while (native_time_us() < ms * 1000) native_runner_step();
+}
+
+#ifndef PIO_UNIT_TESTING  // The tests under test/ bring their own main()
+// Every "Temperature: <value>" in a capture, old unprefixed or "[ms I] " lines alike
+static bool loadReplay(const char *path) {
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    const char *at = strstr(line, "Temperature: ");
+    if (!at) continue;
+    char *end;
+    double celsius = strtod(at + 13, &end);
+    if (end != at + 13 && celsius > -40 && celsius < 150) replay.push_back((float)celsius);
+  }
+  fclose(f);
+  if (replay.empty()) fprintf(stderr, "%s: no temperature readings\n", path);
+  return !replay.empty();
+}
+
+// ---- Output ----
+
+static bool writeScreenshot(const char *path) {
+  FILE *f = fopen(path, "wb");
+  if (!f) {
+    perror(path);
+    return false;
+  }
+  fprintf(f, "P6 %d %d 255\n", display.width(), display.height());
+  for (int y = 0; y < display.height(); y++) {
+    for (int x = 0; x < display.width(); x++) {
+      uint16_t c = display.screenPixel(x, y);
+      uint8_t rgb[3] = { (uint8_t)((c >> 11) << 3), (uint8_t)(((c >> 5) & 0x3F) << 2), (uint8_t)((c & 0x1F) << 3) };
+      fwrite(rgb, 1, 3, f);
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+static int usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [--seconds S] [--temp C] [--press MS:BUTTON]... [--script FILE]\n"
+          "          [--serial] [--screenshot FILE.ppm] [--window MS:MS]\n"
+          "          [--plant SPEC | --replay FILE [--replay-period MS]] [--high C] [--profile]\n"
+          "          [--flash IMAGE]\n"
+          "       %s --bench\n",
+          argv0, argv0);
+  return 2;
+}
+
+int main(int argc, char **argv) {
+  double seconds = -1;  // Default 10 s, or the length of a replay
+  ThermalPlantParams plantParams;
+  bool usePlant = false;
+  double highLimit = NAN;
+  bool echoSerial = false, showProfile = false;
+  const char *screenshot = nullptr, *flashImage = nullptr;
+  uint64_t windowStartMs = 0, windowEndMs = 0;
+
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (a == "--bench") {
+      return native_bench();
+    } else if (a == "--seconds" && hasValue) {
+      seconds = atof(argv[++i]);
+    } else if (a == "--temp" && hasValue) {
+      script.push_back({ 0, ScriptEvent::TEMP, atof(argv[++i]), 0, 0, "" });
+    } else if (a == "--press" && hasValue) {
+      std::string v = argv[++i];
+      size_t colon = v.find(':');
+      if (colon == std::string::npos || !addPress(strtoull(v.c_str(), nullptr, 10), v.substr(colon + 1), 100)) return usage(argv[0]);
+    } else if (a == "--script" && hasValue) {
+      if (!loadScript(argv[++i])) return 1;
+    } else if (a == "--plant" && hasValue) {
+      if (!parseThermalPlantParams(argv[++i], plantParams)) return usage(argv[0]);
+      usePlant = true;
+    } else if (a == "--replay" && hasValue) {
+      if (!loadReplay(argv[++i])) return 1;
+    } else if (a == "--replay-period" && hasValue) {
+      replayPeriodMs = strtoull(argv[++i], nullptr, 10);
+      if (!replayPeriodMs) return usage(argv[0]);
+    } else if (a == "--high" && hasValue) {
+      highLimit = atof(argv[++i]);
+    } else if (a == "--serial") {
+      echoSerial = true;
+    } else if (a == "--profile") {
+      showProfile = true;
+    } else if (a == "--flash" && hasValue) {
+      flashImage = argv[++i];
+    } else if (a == "--screenshot" && hasValue) {
+      screenshot = argv[++i];
+    } else if (a == "--window" && hasValue) {
+      std::string v = argv[++i];
+      size_t colon = v.find(':');
+      if (colon == std::string::npos) return usage(argv[0]);
+      windowStartMs = strtoull(v.c_str(), nullptr, 10);
+      windowEndMs = strtoull(v.c_str() + colon + 1, nullptr, 10);
+    } else {
+      return usage(argv[0]);
+    }
+  }
+
+  if (usePlant && !replay.empty()) return usage(argv[0]);
+  if (seconds < 0) seconds = replay.empty() ? 10 : replay.size() * replayPeriodMs / 1000.0;
+  ThermalPlant thermalPlant(plantParams);
+  if (usePlant) plant = &thermalPlant;
+
+  native_set_serial_sink(echoSerial ? stdout : nullptr);
+  if (flashImage) native_flash_load(flashImage);  // A missing image is an empty flash
+  native_runner_begin();
+  if (!std::isnan(highLimit)) highTempAlert = CentiC::fromCenti(lround(highLimit * 100));
+  uint64_t endUs = (uint64_t)(seconds * 1e6), iterations = 0, windowStartSpi = 0, windowEndSpi = 0;
+  while (native_time_us() < endUs) {
+    uint64_t ms = native_time_us() / 1000;
+    if (windowEndMs && ms >= windowStartMs && !windowStartSpi) windowStartSpi = native_spi_bytes();
+    if (windowEndMs && ms >= windowEndMs && !windowEndSpi) windowEndSpi = native_spi_bytes();
+    native_runner_step();
+    iterations++;
+  }
+
+  uint64_t endMs = native_time_us() / 1000;
+  control.account(endMs, sensorTemperature(endMs));
+  plant = nullptr;
+
+  if (screenshot && !writeScreenshot(screenshot)) return 1;
+  if (flashImage && !native_flash_save(flashImage)) {
+    fprintf(stderr, "cannot write %s\n", flashImage);
+    return 1;
+  }
+  FILE *report = echoSerial ? stderr : stdout;  // Keep the serial capture clean
+  fprintf(report, "iterations %llu serial %llu spi %llu blocked %llu us\n", (unsigned long long)iterations,
+          (unsigned long long)native_serial_bytes(), (unsigned long long)native_spi_bytes(),
+          (unsigned long long)native_serial_blocked_us());
+  if (windowEndMs) {
+    fprintf(report, "window %llu..%llu ms: %llu spi bytes\n", (unsigned long long)windowStartMs,
+            (unsigned long long)windowEndMs, (unsigned long long)(windowEndSpi - windowStartSpi));
+  }
+  if (flashImage) {
+    fprintf(report, "flash %llu writes, %llu bytes\n", (unsigned long long)native_flash_writes(),
+            (unsigned long long)native_flash_bytes_written());
+  }
+  if (usePlant || !replay.empty()) {
+    double hours = endMs / 3600000.0;
+    fprintf(report,
+            "control %.2f h: fan duty %.1f %% (on %.1f %%, energy %.1f %%), %llu switches (%.1f/h), above %.2f C for %.0f s (%.2f %%), "
+            "max %.2f C\n",
+            hours, 100.0 * control.dutyMs / endMs, 100.0 * control.fanOnMs / endMs, 100.0 * control.energyMs / endMs,
+            (unsigned long long)control.switches,
+            control.switches / hours, highTempAlert.raw / 100.0, control.overMs / 1000.0, 100.0 * control.overMs / endMs, control.maxC);
+    fprintf(report,
+            "predict %u min ahead: %llu crossings warned (lead %.0f s), %llu unwarned, %llu false warnings, %lu raised\n",
+            tempPredictor.settings.horizonMin, (unsigned long long)predict.warned,
+            predict.warned ? predict.leadMs / 1000.0 / predict.warned : 0.0, (unsigned long long)predict.unwarned,
+            (unsigned long long)predict.falseAlarms, (unsigned long)tempPredictor.warnings());
+  }
+#if PROFILE_ENABLE
+  if (showProfile) {
+    char line[160];
+    profiler.startDump();
+    while (profiler.dumpLine(line, sizeof(line))) fprintf(report, "%s\n", line);
+  }
+#else
+  (void)showProfile;
+#endif
+  return 0;
+}
+#endif
@@ -0,0 +1,67 @@
+/*
+ * Thermal plant model
+ * See thermal_plant.h.
+ */
+#include "thermal_plant.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PLANT_STEP_MS 1000  // Longest integration step
+
+bool parseThermalPlantParams(const char *spec, ThermalPlantParams &params) {
+  if (!strcmp(spec, "default")) return true;
+  const char *p = spec;
+  while (*p) {
+    const char *eq = strchr(p, '=');
+    if (!eq) return false;
+    char *end;
+    double value = strtod(eq + 1, &end);
+    if (end == eq + 1 || (*end && *end != ',')) return false;
+    size_t keyLength = eq - p;
+    auto is = [&](const char *key) { return strlen(key) == keyLength && !strncmp(p, key, keyLength); };
+    if (is("heat")) params.heatW = value;
+    else if (is("loss")) params.lossWPerK = value;
+    else if (is("fan")) params.fanWPerK = value;
+    else if (is("cap")) params.capacityJPerK = value;
+    else if (is("ambient")) params.ambientC = value;
+    else if (is("drift")) params.driftC = value;
+    else if (is("start")) params.startC = value;
+    else return false;
+    p = *end ? end + 1 : end;
+  }
+  return params.capacityJPerK > 0 && params.lossWPerK > 0 && params.fanWPerK >= 0;
+}
+
+ThermalPlant::ThermalPlant(const ThermalPlantParams &params) : params(params) {
+  tempC = params.startC < -273.0 ? ambient(0) : params.startC;
+}
+
+double ThermalPlant::ambient(uint64_t ms) const {
+  return params.ambientC + params.driftC * sin(2 * M_PI * (double)(ms % 86400000) / 86400000.0);
+}
+
+void ThermalPlant::advance(uint64_t ms) {
+  double conductance = params.lossWPerK + params.fanWPerK * duty;
+  while (nowMs < ms) {
+    uint64_t step = ms - nowMs < PLANT_STEP_MS ? ms - nowMs : PLANT_STEP_MS;
+    double equilibrium = ambient(nowMs + step / 2) + params.heatW / conductance;
+    tempC = equilibrium + (tempC - equilibrium) * exp(-conductance * (step / 1000.0) / params.capacityJPerK);
+    nowMs += step;
+  }
+}
+
+void ThermalPlant::setFanDuty(uint64_t ms, double newDuty) {
+  advance(ms);
+  duty = newDuty < 0 ? 0 : newDuty > 1 ? 1 : newDuty;
+}
+
+void ThermalPlant::setHeat(uint64_t ms, double watts) {
+  advance(ms);
+  params.heatW = watts;
+}
+
+void ThermalPlant::setAmbient(uint64_t ms, double celsius) {
+  advance(ms);
+  params.ambientC = celsius;
+}
@@ -0,0 +1,143 @@
+/*
+ * Rule-based alerts
+ * See alert_rules.h.
+ */
+#include "alert_rules.h"
+
+void AlertEngine::begin(const AlertRule* table, uint8_t ruleCount) {
+  count = ruleCount > ALERT_MAX_RULES ? ALERT_MAX_RULES : ruleCount;
+  for (uint8_t i = 0; i < count; i++) {
+    rules[i] = table[i];
+    state[i] = IDLE;
+  }
+  activeRules = 0;
+  pendingFirst = pendingLast = NONE;
+  haveLast = false;
+  sort();
+}
+
+void AlertEngine::setThreshold(uint8_t rule, CentiC threshold) {
+  if (rule >= count || rules[rule].threshold == threshold) return;
+  rules[rule].threshold = threshold;
+  sort();
+  if (!haveLast) return;
+
+  // Judge every rule on the last reading again, then put the cursors where it falls
+  for (uint8_t i = 0; i < count; i++) {
+    int32_t k = key(i, lastValue);
+    if (k > raiseAt[i]) enter(i, lastMs, lastValue);
+    else leave(i);
+    if (state[i] == ACTIVE && k < clearAt[i]) clear(i, lastMs, lastValue);
+  }
+  for (Side& side : sides) {
+    if (side.count == 0) continue;
+    int32_t k = key(side.byRaise[0], lastValue);
+    while (side.raised < side.count && raiseAt[side.byRaise[side.raised]] < k) side.raised++;
+    while (side.cleared < side.count && clearAt[side.byClear[side.cleared]] <= k) side.cleared++;
+  }
+}
+
+// Sorted lists of both directions, with the cursors below every point (no reading yet)
+void AlertEngine::sort() {
+  for (Side& side : sides) side.count = side.raised = side.cleared = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    const AlertRule& r = rules[i];
+    raiseAt[i] = r.direction == ALERT_ABOVE ? r.threshold.raw : -(int32_t)r.threshold.raw;
+    clearAt[i] = raiseAt[i] - r.hysteresis.raw;
+    Side& side = sides[r.direction];
+    // Insertion sort, the table is small and only sorted when a threshold moves
+    uint8_t at = side.count++;
+    while (at > 0 && raiseAt[side.byRaise[at - 1]] > raiseAt[i]) {
+      side.byRaise[at] = side.byRaise[at - 1];
+      at--;
+    }
+    side.byRaise[at] = i;
+    at = side.count - 1;
+    while (at > 0 && clearAt[side.byClear[at - 1]] > clearAt[i]) {
+      side.byClear[at] = side.byClear[at - 1];
+      at--;
+    }
+    side.byClear[at] = i;
+  }
+}
+
+bool AlertEngine::update(uint32_t timestampMs, CentiC value) {
+  uint32_t before = eventsTotal;
+  updateSide(sides[ALERT_ABOVE], value.raw, timestampMs, value);
+  updateSide(sides[ALERT_BELOW], -(int32_t)value.raw, timestampMs, value);
+
+  // Debounced rules whose minimum duration has passed, earliest deadline first
+  while (pendingFirst != NONE && (int32_t)(timestampMs - deadline[pendingFirst]) >= 0) {
+    uint8_t rule = pendingFirst;
+    leave(rule);
+    raise(rule, timestampMs, value);
+  }
+
+  haveLast = true;
+  lastMs = timestampMs;
+  lastValue = value;
+  return eventsTotal != before;
+}
+
+void AlertEngine::updateSide(Side& side, int32_t k, uint32_t timestampMs, CentiC value) {
+  // Raise points the reading went above, then the ones it fell back below
+  while (side.raised < side.count && raiseAt[side.byRaise[side.raised]] < k) {
+    enter(side.byRaise[side.raised++], timestampMs, value);
+  }
+  while (side.raised > 0 && raiseAt[side.byRaise[side.raised - 1]] >= k) leave(side.byRaise[--side.raised]);
+  // Clear points the reading fell below, then the ones it went back above
+  while (side.cleared > 0 && clearAt[side.byClear[side.cleared - 1]] > k) {
+    uint8_t rule = side.byClear[--side.cleared];
+    if (state[rule] == ACTIVE) clear(rule, timestampMs, value);
+  }
+  while (side.cleared < side.count && clearAt[side.byClear[side.cleared]] <= k) side.cleared++;
+}
+
+// The reading is past the rule's threshold: raise it, or start its minimum duration
+void AlertEngine::enter(uint8_t rule, uint32_t timestampMs, CentiC value) {
+  if (state[rule] != IDLE) return;
+  if (rules[rule].minDurationS == 0) {
+    raise(rule, timestampMs, value);
+    return;
+  }
+  state[rule] = PENDING;
+  deadline[rule] = timestampMs + rules[rule].minDurationS * 1000UL;
+  // Deadlines mostly come in order, so the place is found from the end
+  uint8_t after = pendingLast;
+  while (after != NONE && (int32_t)(deadline[after] - deadline[rule]) > 0) after = pendingPrev[after];
+  pendingPrev[rule] = after;
+  pendingNext[rule] = after == NONE ? pendingFirst : pendingNext[after];
+  if (after == NONE) pendingFirst = rule;
+  else pendingNext[after] = rule;
+  if (pendingNext[rule] == NONE) pendingLast = rule;
+  else pendingPrev[pendingNext[rule]] = rule;
+}
+
+// The reading is back before the threshold: a pending rule is dropped (debounce)
+void AlertEngine::leave(uint8_t rule) {
+  if (state[rule] != PENDING) return;
+  state[rule] = IDLE;
+  if (pendingPrev[rule] == NONE) pendingFirst = pendingNext[rule];
+  else pendingNext[pendingPrev[rule]] = pendingNext[rule];
+  if (pendingNext[rule] == NONE) pendingLast = pendingPrev[rule];
+  else pendingPrev[pendingNext[rule]] = pendingPrev[rule];
+}
+
+void AlertEngine::raise(uint8_t rule, uint32_t timestampMs, CentiC value) {
+  state[rule] = ACTIVE;
+  activeRules++;
+  log(rule, true, timestampMs, value);
+}
+
+void AlertEngine::clear(uint8_t rule, uint32_t timestampMs, CentiC value) {
+  state[rule] = IDLE;
+  activeRules--;
+  log(rule, false, timestampMs, value);
+}
+
+void AlertEngine::log(uint8_t rule, bool raised, uint32_t timestampMs, CentiC value) {
+  events[eventHead] = { timestampMs, value, rule, raised };
+  eventHead = (eventHead + 1) % ALERT_EVENT_CAPACITY;
+  if (eventsStored < ALERT_EVENT_CAPACITY) eventsStored++;
+  eventsTotal++;
+}
@@ -0,0 +1,78 @@
+/*
+ * Button input
+ * See buttons.h for the events and the debounce rule.
+ */
+#include "buttons.h"
+
+void ButtonInput::poll(uint32_t nowMs, ButtonHandler handler) {
+  // Edges in the order they happened, a change inside the lockout is bounce
+  ButtonEdge e;
+  while (edges.pop(e)) {
+    if (e.button >= count) continue;
+    State& s = state[e.button];
+    s.raw = e.pressed;
+    s.rawMs = e.ms;
+    if (s.raw != s.stable && e.ms - s.stableMs >= BUTTON_DEBOUNCE_MS) accept(e.button, e.ms, nowMs, handler);
+  }
+
+  bool combo = comboDown();
+  for (uint8_t i = 0; i < count; i++) {
+    State& s = state[i];
+    // Bounce settled on the other level: take it once the lockout is over
+    if (s.raw != s.stable && nowMs - s.stableMs >= BUTTON_DEBOUNCE_MS) {
+      uint32_t lockoutEnd = s.stableMs + BUTTON_DEBOUNCE_MS;
+      accept(i, (int32_t)(s.rawMs - lockoutEnd) > 0 ? s.rawMs : lockoutEnd, nowMs, handler);
+    }
+    if (combo && (comboMask & (1 << i))) continue;  // Waiting for the combo, no holds
+    if (s.phase == DOWN && nowMs - s.stableMs >= BUTTON_LONG_MS) {
+      s.phase = HELD;
+      s.nextRepeatMs = s.stableMs + BUTTON_LONG_MS + BUTTON_REPEAT_MS;
+      handler({ i, BUTTON_LONG, s.stableMs + BUTTON_LONG_MS });
+    } else if (s.phase == HELD && (int32_t)(nowMs - s.nextRepeatMs) >= 0) {
+      handler({ i, BUTTON_REPEAT, s.nextRepeatMs });
+      s.nextRepeatMs += BUTTON_REPEAT_MS;
+      if ((int32_t)(nowMs - s.nextRepeatMs) >= 0) s.nextRepeatMs = nowMs + BUTTON_REPEAT_MS;  // Late task, no burst
+    }
+  }
+
+  // The combo counts from the last of its buttons going down
+  combo = comboDown();
+  if (!combo) {
+    comboFired = false;
+  } else if (!comboFired) {
+    uint32_t since = 0;
+    for (uint8_t i = 0; i < count; i++) {
+      if ((comboMask & (1 << i)) && (since == 0 || (int32_t)(state[i].stableMs - since) > 0)) since = state[i].stableMs;
+    }
+    if (nowMs - since >= BUTTON_COMBO_MS) {
+      comboFired = true;
+      for (uint8_t i = 0; i < count; i++) {
+        if (comboMask & (1 << i)) state[i].phase = IN_COMBO;
+      }
+      handler({ BUTTON_ID_COMBO, BUTTON_COMBO, since + BUTTON_COMBO_MS });
+    }
+  }
+}
+
+void ButtonInput::accept(uint8_t button, uint32_t ms, uint32_t nowMs, ButtonHandler handler) {
+  State& s = state[button];
+  s.stable = s.raw;
+  s.stableMs = ms;
+  if (s.stable) {
+    s.phase = DOWN;
+    lastLatency = nowMs - ms;
+    if (lastLatency > maxLatency) maxLatency = lastLatency;
+    handler({ button, BUTTON_PRESS, ms });
+  } else {
+    if (s.phase == DOWN) handler({ button, BUTTON_SHORT, ms });
+    s.phase = RELEASED;
+  }
+}
+
+bool ButtonInput::comboDown() const {
+  if (comboMask == 0) return false;
+  for (uint8_t i = 0; i < count; i++) {
+    if ((comboMask & (1 << i)) && !state[i].stable) return false;
+  }
+  return true;
+}
@@ -0,0 +1,153 @@
+/*
+ * Fan speed controller
+ * See fan_control.h for the control law and the units of the tuning values.
+ */
+#include "fan_control.h"
+
+#define FAN_MAX_DT_MS 10000  // Longer gaps (e.g. a stalled sensor) count as this
+#define FAN_SETTLE_MS 120000 // Autotune: the response has settled when it moved less than
+#define FAN_SETTLE_CENTI_C 5 //   this over FAN_SETTLE_MS
+#define FAN_MIN_TUNE_MS 300000
+
+static int32_t clampInt(int64_t v, int32_t low, int32_t high) {
+  return v < low ? low : v > high ? high : (int32_t)v;
+}
+
+uint16_t FanController::update(CentiC temperature, uint32_t timestampMs) {
+  int32_t centiC = temperature.raw;  // The control law works on wider ints
+  uint32_t dtMs = primed ? timestampMs - lastMs : 0;
+  if (dtMs > FAN_MAX_DT_MS) dtMs = FAN_MAX_DT_MS;
+
+  if (tuneRequested) {
+    tuneRequested = false;
+    if (output == 0) startCount++;
+    tuneState = TUNE_RUNNING;
+    tuneStartMs = tuneLastMs = tuneMinuteMs = timestampMs;
+    tuneStartCentiC = tuneMinuteCentiC = centiC;
+    tuneCount = 0;
+    tuneShift = 0;
+  }
+
+  if (tuneState == TUNE_RUNNING) {
+    autotuneStep(centiC, timestampMs);
+    if (tuneState == TUNE_RUNNING) {
+      output = FAN_DUTY_MAX;
+    } else {
+      on = false;  // Tuned (or gave up), the normal start/stop rule takes over again
+      integralQ16 = 0;
+    }
+  }
+
+  if (tuneState != TUNE_RUNNING) {
+    int32_t setpoint = (int32_t)tuning.setpointC * 100;
+    if (!on && (centiC > setpoint || prestart)) {
+      on = true;
+      startCount++;
+      integralQ16 = (int32_t)tuning.minDutyPct * 10 << 16;  // Start from the minimum duty, no bump
+    } else if (on && !prestart && centiC < setpoint - (int32_t)tuning.hysteresisDeciC * 10) {
+      on = false;
+      integralQ16 = 0;
+    }
+    output = on ? runPid(centiC, dtMs) : 0;
+  }
+
+  lastCentiC = centiC;
+  lastMs = timestampMs;
+  primed = true;
+  return output;
+}
+
+uint16_t FanController::runPid(int32_t centiC, uint32_t dtMs) {
+  int32_t error = centiC - (int32_t)tuning.setpointC * 100;
+  int32_t p = (int32_t)tuning.kp * error / 10;  // % per C on centi-C -> permille
+  int32_t d = 0;
+  if (dtMs > 0) d = (int32_t)((int64_t)tuning.kd * (centiC - lastCentiC) * 6000 / dtMs);
+  int64_t step = ((int64_t)tuning.ki * error * dtMs << 16) / 36000000;  // % per C per hour -> permille, Q16
+  int32_t integral = clampInt((int64_t)integralQ16 + step, 0, (int32_t)FAN_DUTY_MAX << 16);
+
+  // Conditional integration: keep the old integral when the output is already saturated
+  int32_t out = p + (integral >> 16) + d;
+  if (!((out > FAN_DUTY_MAX && error > 0) || (out < 0 && error < 0))) integralQ16 = integral;
+  out = p + (integralQ16 >> 16) + d;
+  return (uint16_t)clampInt(out, (int32_t)tuning.minDutyPct * 10, FAN_DUTY_MAX);
+}
+
+void FanController::startAutotune() { tuneRequested = true; }
+
+void FanController::cancelAutotune() {
+  tuneRequested = false;
+  if (tuneState == TUNE_RUNNING) {
+    tuneState = TUNE_IDLE;
+    on = false;
+    integralQ16 = 0;
+  }
+}
+
+void FanController::autotuneStep(int32_t centiC, uint32_t timestampMs) {
+  tuneLastMs = timestampMs;
+  uint32_t elapsedMs = timestampMs - tuneStartMs;
+
+  // One point every 2^tuneShift s, when the buffer is full every other point is dropped
+  uint32_t elapsedS = elapsedMs / 1000;
+  if (elapsedS >= ((uint32_t)tuneCount << tuneShift)) {
+    if (tuneCount == FAN_AUTOTUNE_POINTS) {
+      for (uint8_t i = 0; i < FAN_AUTOTUNE_POINTS / 2; i++) tunePoints[i] = tunePoints[2 * i];
+      tuneCount = FAN_AUTOTUNE_POINTS / 2;
+      tuneShift++;
+    }
+    if (elapsedS >= ((uint32_t)tuneCount << tuneShift)) {
+      tunePoints[tuneCount++] = (int16_t)clampInt(centiC - tuneStartCentiC, INT16_MIN, INT16_MAX);
+    }
+  }
+
+  if (timestampMs - tuneMinuteMs >= FAN_SETTLE_MS) {
+    int32_t moved = centiC - tuneMinuteCentiC;
+    tuneMinuteMs = timestampMs;
+    tuneMinuteCentiC = centiC;
+    if (elapsedMs >= FAN_MIN_TUNE_MS && moved < FAN_SETTLE_CENTI_C && moved > -FAN_SETTLE_CENTI_C) {
+      finishAutotune();
+      return;
+    }
+  }
+  if (elapsedMs >= FAN_AUTOTUNE_MAX_MS) tuneState = TUNE_FAILED;
+}
+
+void FanController::finishAutotune() {
+  int32_t total = lastCentiC - tuneStartCentiC;  // Negative, the fan cools
+  if (total > -FAN_AUTOTUNE_MIN_CENTI_C) {
+    tuneState = TUNE_FAILED;
+    return;
+  }
+
+  // Times at which the response reached 28.3 % and 63.2 % of its total change, interpolated
+  int32_t crossMs[2] = { -1, -1 };
+  const int32_t fractions[2] = { 283, 632 };
+  for (int k = 0; k < 2; k++) {
+    int32_t target = total * fractions[k] / 1000;
+    for (uint8_t i = 1; i < tuneCount; i++) {
+      if (tunePoints[i] > target) continue;
+      int32_t y0 = tunePoints[i - 1], y1 = tunePoints[i];
+      int32_t t0 = ((int32_t)(i - 1) << tuneShift) * 1000, span = (1 << tuneShift) * 1000;
+      crossMs[k] = y1 == y0 ? t0 : t0 + (int32_t)((int64_t)span * (y0 - target) / (y0 - y1));
+      break;
+    }
+  }
+  if (crossMs[0] < 0 || crossMs[1] <= crossMs[0]) {
+    tuneState = TUNE_FAILED;
+    return;
+  }
+
+  // First order plus dead time: time constant and dead time in ms
+  int32_t tau = 3 * (crossMs[1] - crossMs[0]) / 2;
+  int32_t dead = crossMs[1] - tau;
+  if (dead < 0) dead = 0;
+  // SIMC with a closed-loop time constant of max(dead time, tau / 2): calm, fan-friendly
+  int32_t closedLoop = dead > tau / 2 ? dead : tau / 2;
+  int64_t kp = (int64_t)10000 * tau / ((int64_t)-total * (closedLoop + dead));  // % per C
+  int32_t integralTime = 4 * (closedLoop + dead) < tau ? 4 * (closedLoop + dead) : tau;
+  int64_t ki = kp * 3600000 / (integralTime > 0 ? integralTime : 1);            // % per C per hour
+  tuning.kp = (uint8_t)clampInt(kp, 1, 255);
+  tuning.ki = (uint16_t)clampInt(ki, 0, 999);
+  tuning.kd = 0;
+  tuneState = TUNE_DONE;
+}
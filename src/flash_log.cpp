@@ -0,0 +1,329 @@
+/*
+ * Persistent history log in LittleFS
+ * See flash_log.h for the file layout and the recovery rules.
+ */
+#include "flash_log.h"
+#include <stddef.h>
+#include "series_codec.h"
+
+#define FLASH_LOG_HEADER_SIZE sizeof(FlashLogHeader)
+#define FLASH_LOG_BLOCK_SIZE sizeof(FlashLogBlock)
+
+// CRC-32 a nibble at a time: a 64-byte table instead of 1 KB, blocks are only checked on I/O
+static const uint32_t crcNibbles[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint32_t flashLogCrc32(const uint8_t* data, size_t length) {
+  uint32_t crc = 0xFFFFFFFF;
+  while (length--) {
+    crc ^= *data++;
+    crc = (crc >> 4) ^ crcNibbles[crc & 15];
+    crc = (crc >> 4) ^ crcNibbles[crc & 15];
+  }
+  return ~crc;
+}
+
+static uint32_t headerCrc(const FlashLogHeader& header) {
+  return flashLogCrc32((const uint8_t*)&header, offsetof(FlashLogHeader, crc));
+}
+
+static uint32_t blockCrc(const FlashLogBlock& block) {
+  return flashLogCrc32((const uint8_t*)&block, offsetof(FlashLogBlock, crc));
+}
+
+static bool readHeader(File& file, FlashLogHeader& header) {
+  return file && file.read((uint8_t*)&header, sizeof(header)) == sizeof(header) && header.magic == FLASH_LOG_MAGIC &&
+         header.version == FLASH_LOG_VERSION && header.blockBytes == FLASH_LOG_BLOCK_BYTES &&
+         header.crc == headerCrc(header);
+}
+
+// A record after the first of a block: time step change, then the changes of min, max,
+// mean, count and crossings from the record before
+static bool packRecord(BitWriter& out, FlashLogRecord& last, int32_t& step, const FlashLogRecord& record) {
+  int32_t nextStep = (int32_t)(record.time - last.time);
+  int32_t changes[5] = {
+    seriesChange(record.min.raw, last.min.raw), seriesChange(record.max.raw, last.max.raw),
+    seriesChange(record.mean.raw, last.mean.raw), seriesChange(record.count, last.count),
+    seriesChange((int32_t)record.crossings, (int32_t)last.crossings),
+  };
+  uint32_t bits = timeCodeLength(seriesChange(nextStep, step));
+  for (int i = 0; i < 5; i++) bits += valueCodeLength(changes[i]);
+  if (!out.fits(bits)) return false;
+  putTimeCode(out, seriesChange(nextStep, step));
+  for (int i = 0; i < 5; i++) putValueCode(out, changes[i]);
+  last = record;
+  step = nextStep;
+  return true;
+}
+
+static void unpackRecord(BitReader& in, FlashLogRecord& last, int32_t& step) {
+  step = seriesApply(step, getTimeCode(in));
+  last.time += (uint32_t)step;
+  last.min = CentiC::fromCenti(seriesApply(last.min.raw, getValueCode(in)));
+  last.max = CentiC::fromCenti(seriesApply(last.max.raw, getValueCode(in)));
+  last.mean = CentiC::fromCenti(seriesApply(last.mean.raw, getValueCode(in)));
+  last.count = (uint16_t)seriesApply(last.count, getValueCode(in));
+  last.crossings = (uint32_t)seriesApply((int32_t)last.crossings, getValueCode(in));
+}
+
+// Visit the records of block with from <= time < to, false once the visitor or the range ends
+static bool visitBlock(const FlashLogBlock& block, uint32_t from, uint32_t to, FlashLogVisitor visit, void* context,
+                       uint32_t& visited) {
+  FlashLogRecord record = block.first;
+  int32_t step = 0;
+  BitReader in(block.data);
+  for (uint16_t r = 0; r < block.count; r++) {
+    if (r > 0) unpackRecord(in, record, step);
+    if (record.time < from) continue;
+    if (record.time >= to) return false;
+    visited++;
+    if (!visit(record, context)) return false;
+  }
+  return true;
+}
+
+static bool keepLast(const FlashLogRecord& record, void* context) {
+  *static_cast<FlashLogRecord*>(context) = record;
+  return true;
+}
+
+void FlashLog::segmentPath(uint32_t seq, char* path, size_t size) const {
+  snprintf(path, size, FLASH_LOG_DIR "/%08lx.seg", (unsigned long)seq);
+}
+
+bool FlashLog::begin(FS& fs) {
+  this->fs = nullptr;
+  segCount = 0;
+  pending = {};
+  pendingStored = false;
+  unsynced = 0;
+  haveNewest = false;
+  fs.mkdir(FLASH_LOG_DIR);
+
+  // Headers only: keep the newest FLASH_LOG_SEGMENTS valid segments, sorted by seq
+  uint16_t strays = 0;  // Files with a bad header or beyond the segment limit
+  Dir dir = fs.openDir(FLASH_LOG_DIR);
+  while (dir.next()) {
+    File file = dir.openFile("r");
+    FlashLogHeader header;
+    bool valid = readHeader(file, header);
+    size_t size = file ? file.size() : 0;
+    file.close();
+    if (!valid) {
+      strays++;
+      continue;
+    }
+    size_t blocks = (size - FLASH_LOG_HEADER_SIZE) / FLASH_LOG_BLOCK_SIZE;
+    Segment segment = { header.seq, header.firstTime, (uint16_t)(blocks < FLASH_LOG_SEGMENT_BLOCKS ? blocks : FLASH_LOG_SEGMENT_BLOCKS) };
+    if (segCount == FLASH_LOG_SEGMENTS) {
+      strays++;
+      if (segment.seq < segs[0].seq) continue;
+      memmove(segs, segs + 1, sizeof(Segment) * --segCount);  // Drop the oldest
+    }
+    uint8_t at = segCount;
+    while (at > 0 && segs[at - 1].seq > segment.seq) {
+      segs[at] = segs[at - 1];
+      at--;
+    }
+    segs[at] = segment;
+    segCount++;
+  }
+
+  // Remove the strays, the directory is read again after each removal
+  char path[32];
+  while (strays > 0) {
+    bool removed = false;
+    Dir again = fs.openDir(FLASH_LOG_DIR);
+    while (!removed && again.next()) {
+      File file = again.openFile("r");
+      FlashLogHeader header;
+      bool keep = readHeader(file, header) && segCount > 0 && header.seq >= segs[0].seq;
+      file.close();
+      if (keep) continue;
+      snprintf(path, sizeof(path), FLASH_LOG_DIR "/%s", again.fileName().c_str());
+      removed = fs.remove(path);
+    }
+    if (!removed) break;
+    strays--;
+  }
+
+  this->fs = &fs;
+  recoverTail();
+  return true;
+}
+
+bool FlashLog::readBlock(File& file, uint16_t index, FlashLogBlock& block) {
+  bool ok = file.seek(FLASH_LOG_HEADER_SIZE + (uint32_t)index * FLASH_LOG_BLOCK_SIZE) &&
+            file.read((uint8_t*)&block, FLASH_LOG_BLOCK_SIZE) == FLASH_LOG_BLOCK_SIZE && block.count > 0 &&
+            block.bits <= sizeof(block.data) * 8 && block.crc == blockCrc(block);
+  if (!ok) badBlocks++;
+  return ok;
+}
+
+uint32_t FlashLog::blockFirstTime(File& file, uint16_t index) {
+  uint32_t time = 0;
+  file.seek(FLASH_LOG_HEADER_SIZE + (uint32_t)index * FLASH_LOG_BLOCK_SIZE + offsetof(FlashLogBlock, first));
+  file.read((uint8_t*)&time, sizeof(time));
+  return time;
+}
+
+// Only the newest segment can end in a torn block: cut off a partial block and any last
+// block that fails its CRC, drop the segment if nothing is left
+void FlashLog::recoverTail() {
+  char path[32];
+  while (segCount > 0) {
+    Segment& tail = segs[segCount - 1];
+    segmentPath(tail.seq, path, sizeof(path));
+    File file = fs->open(path, "r+");
+    if (file.size() > FLASH_LOG_HEADER_SIZE + (uint32_t)tail.blocks * FLASH_LOG_BLOCK_SIZE) {
+      file.truncate(FLASH_LOG_HEADER_SIZE + (uint32_t)tail.blocks * FLASH_LOG_BLOCK_SIZE);
+      cutBlocks++;
+    }
+    while (tail.blocks > 0 && !readBlock(file, tail.blocks - 1, scratch)) {
+      tail.blocks--;
+      file.truncate(FLASH_LOG_HEADER_SIZE + (uint32_t)tail.blocks * FLASH_LOG_BLOCK_SIZE);
+      cutBlocks++;
+    }
+    file.close();
+    if (tail.blocks > 0) {
+      uint32_t visited = 0;
+      visitBlock(scratch, 0, UINT32_MAX, keepLast, &newest, visited);
+      haveNewest = true;
+      return;  // New records go to a new block, this one stays as it is
+    }
+    fs->remove(path);
+    segCount--;
+  }
+}
+
+void FlashLog::append(FlashLogRecord record) {
+  if (haveNewest && record.time < newest.time) record.time = newest.time;  // Keep the log sorted
+  BitWriter out(pending.data, sizeof(pending.data), pending.bits);
+  if (pending.count > 0 && packRecord(out, pendingLast, pendingStep, record)) {
+    pending.bits = out.bits();
+    pending.count++;
+  } else {
+    if (pending.count > 0) {
+      writeBlock();  // Full, the record starts the next block
+      pendingStored = false;
+    }
+    pending = {};
+    pending.count = 1;
+    pending.first = pendingLast = record;
+    pendingStep = 0;
+  }
+  newest = record;
+  haveNewest = true;
+  appendCount++;
+  if (++unsynced >= FLASH_LOG_SYNC_RECORDS) writeBlock();
+}
+
+bool FlashLog::flush() {
+  return writeBlock();
+}
+
+bool FlashLog::startSegment(uint32_t firstTime) {
+  char path[32];
+  uint32_t seq = segCount ? segs[segCount - 1].seq + 1 : 1;
+  if (segCount == FLASH_LOG_SEGMENTS) {
+    segmentPath(segs[0].seq, path, sizeof(path));
+    fs->remove(path);
+    memmove(segs, segs + 1, sizeof(Segment) * --segCount);
+  }
+
+  FlashLogHeader header = { FLASH_LOG_MAGIC, FLASH_LOG_VERSION, FLASH_LOG_BLOCK_BYTES, seq, firstTime, 0 };
+  header.crc = headerCrc(header);
+  segmentPath(seq, path, sizeof(path));
+  File file = fs->open(path, "w");
+  bool ok = file && file.write((const uint8_t*)&header, sizeof(header)) == sizeof(header);
+  file.close();
+  if (!ok) {
+    fs->remove(path);
+    return false;
+  }
+  segs[segCount++] = { seq, firstTime, 0 };
+  return true;
+}
+
+// Write the open block: over its earlier copy once it is on flash, else appended as the
+// newest block of the newest segment
+bool FlashLog::writeBlock() {
+  unsynced = 0;
+  if (pending.count == 0 || !fs) return pending.count == 0;
+  if (!pendingStored && (segCount == 0 || segs[segCount - 1].blocks >= FLASH_LOG_SEGMENT_BLOCKS) &&
+      !startSegment(pending.first.time)) {
+    return false;
+  }
+  Segment& tail = segs[segCount - 1];
+  uint16_t index = pendingStored ? tail.blocks - 1 : tail.blocks;
+  char path[32];
+  segmentPath(tail.seq, path, sizeof(path));
+  pending.crc = blockCrc(pending);
+  File file = fs->open(path, "r+");
+  bool ok = file && file.seek(FLASH_LOG_HEADER_SIZE + (uint32_t)index * FLASH_LOG_BLOCK_SIZE) &&
+            file.write((const uint8_t*)&pending, FLASH_LOG_BLOCK_SIZE) == FLASH_LOG_BLOCK_SIZE;
+  if (!ok && file && !pendingStored) file.truncate(FLASH_LOG_HEADER_SIZE + (uint32_t)tail.blocks * FLASH_LOG_BLOCK_SIZE);
+  file.close();
+  if (ok) {
+    if (!pendingStored) tail.blocks++;
+    pendingStored = true;
+    writeCount++;
+  }
+  return ok;
+}
+
+uint32_t FlashLog::query(uint32_t from, uint32_t to, FlashLogVisitor visit, void* context) {
+  uint32_t visited = 0;
+  if (from >= to) return 0;
+  char path[32];
+  for (uint8_t i = 0; i < segCount && fs; i++) {
+    const Segment& segment = segs[i];
+    uint16_t blocks = segment.blocks;
+    if (pendingStored && i + 1 == segCount) blocks--;  // The open block is read from RAM below
+    if (segment.firstTime >= to) return visited;  // Later segments start later still
+    if (blocks == 0 || (i + 1 < segCount && segs[i + 1].firstTime < from)) continue;
+
+    segmentPath(segment.seq, path, sizeof(path));
+    File file = fs->open(path, "r");
+    if (!file) continue;
+    // Start at the last block that begins before from
+    uint16_t low = 0, high = blocks - 1;
+    while (low < high) {
+      uint16_t mid = (low + high + 1) / 2;
+      if (blockFirstTime(file, mid) < from) low = mid;
+      else high = mid - 1;
+    }
+    for (uint16_t b = low; b < blocks; b++) {
+      if (readBlock(file, b, scratch) && !visitBlock(scratch, from, to, visit, context, visited)) {
+        file.close();
+        return visited;
+      }
+    }
+    file.close();
+  }
+
+  if (pending.count > 0) visitBlock(pending, from, to, visit, context, visited);
+  return visited;
+}
+
+RollupBucket flashLogBucket(const FlashLogRecord& record) {
+  return { 0, record.min, record.max, (int32_t)record.mean.raw * record.count, record.count };
+}
+
+bool flashLogFoldSummary(const FlashLogRecord& record, void* context) {
+  static_cast<RollupSummary*>(context)->merge(flashLogBucket(record));
+  return true;
+}
+
+bool FlashLog::last(FlashLogRecord& record) const {
+  if (haveNewest) record = newest;
+  return haveNewest;
+}
+
+uint32_t FlashLog::storedBlocks() const {
+  uint32_t blocks = 0;
+  for (uint8_t i = 0; i < segCount; i++) blocks += segs[i].blocks;
+  return blocks;
+}
@@ -0,0 +1,100 @@
+/*
+ * Local wall clock
+ * See local_clock.h.
+ */
+#include "local_clock.h"
+
+void LocalClock::begin(ClockSyncSource source) {
+  syncSource = source;
+  nextSyncMs = monotonicMs();  // First sync on the first update()
+  lastSlewMs = nextSyncMs;
+  refreshTimeOfDay(nextSyncMs);
+}
+
+uint64_t LocalClock::monotonicMs() {
+  uint32_t now = millis();
+  if (now < lastMillis) {
+    millisHigh++;  // millis() wrapped (every ~49.7 days)
+  }
+  lastMillis = now;
+  return ((uint64_t)millisHigh << 32) | now;
+}
+
+void LocalClock::update() {
+  uint64_t now = monotonicMs();
+
+  // Slew the pending correction in at CLOCK_SLEW_MS_PER_S
+  if (slewRemainingMs != 0) {
+    int64_t step = (int64_t)((now - lastSlewMs) * CLOCK_SLEW_MS_PER_S / 1000);
+    if (step > 0) {
+      if (step > (slewRemainingMs < 0 ? -slewRemainingMs : slewRemainingMs)) {
+        step = slewRemainingMs < 0 ? -slewRemainingMs : slewRemainingMs;
+      }
+      if (slewRemainingMs < 0) step = -step;
+      offsetMs += step;
+      slewRemainingMs -= step;
+      lastSlewMs = now;
+    }
+  } else {
+    lastSlewMs = now;
+  }
+
+  // Resync when due, or look for the answer to the request out, backing off after failures
+  if (syncSource != nullptr && (syncPending || (int64_t)(now - nextSyncMs) >= 0)) {
+    uint32_t epochSeconds = 0;
+    ClockSyncResult result = syncSource(!syncPending, epochSeconds);
+    syncPending = result == CLOCK_SYNC_PENDING;
+    if (result == CLOCK_SYNC_OK) {
+      applySync((uint64_t)epochSeconds * 1000, monotonicMs());
+      backoffExp = 0;
+      nextSyncMs = now + CLOCK_SYNC_INTERVAL_MS;
+    } else if (result == CLOCK_SYNC_FAILED) {
+      failureCount++;
+      uint64_t retryMs = (uint64_t)CLOCK_RETRY_MIN_MS << backoffExp;
+      if (retryMs >= CLOCK_SYNC_INTERVAL_MS) {
+        retryMs = CLOCK_SYNC_INTERVAL_MS;
+      } else {
+        backoffExp++;
+      }
+      nextSyncMs = now + retryMs;
+    }
+  }
+
+  refreshTimeOfDay(now);
+}
+
+void LocalClock::setTimeOfDay(int h, int m, int s) {
+  uint64_t now = monotonicMs();
+  int64_t wall = (int64_t)(now + offsetMs);
+  int64_t dayStart = wall - (wall % 86400000LL);
+  offsetMs = dayStart + ((int64_t)h * 3600 + m * 60 + s) * 1000 - (int64_t)now;
+  slewRemainingMs = 0;
+  manuallySet = true;
+  refreshTimeOfDay(now);
+}
+
+void LocalClock::applySync(uint64_t sourceMs, uint64_t now) {
+  // The source only has whole seconds, so the clock is right if it is in the same second
+  int64_t wall = (int64_t)(now + offsetMs);
+  int64_t errorMs = wall - (int64_t)sourceMs;
+  lastSyncErrorMs = (int32_t)constrain(errorMs, (int64_t)INT32_MIN, (int64_t)INT32_MAX);
+
+  if (syncCount == 0 || manuallySet || errorMs > CLOCK_STEP_THRESHOLD_MS || errorMs < -CLOCK_STEP_THRESHOLD_MS) {
+    offsetMs = (int64_t)sourceMs - (int64_t)now;  // Step
+    slewRemainingMs = 0;
+  } else if (errorMs < 0 || errorMs >= 1000) {
+    // Aim for the middle of the source's second
+    slewRemainingMs = 500 - errorMs;
+    lastSlewMs = now;
+  }
+  manuallySet = false;
+  syncCount++;
+}
+
+void LocalClock::refreshTimeOfDay(uint64_t now) {
+  int64_t wall = (int64_t)(now + offsetMs);
+  uint32_t secondOfDay = (uint32_t)(((wall / 1000) % 86400 + 86400) % 86400);
+  cachedHours = secondOfDay / 3600;
+  cachedMinutes = (secondOfDay / 60) % 60;
+  cachedSeconds = secondOfDay % 60;
+}
@@ -0,0 +1,103 @@
+/*
+ * Leveled, buffered logging
+ * See log.h. write() runs in loop() context (Ticker callbacks on the ESP8266 do not
+ * preempt it), drain() is the log task. Lines look like "[12345 I] Temperature: 25.00",
+ * with " x12" appended when identical messages were folded together.
+ */
+#include "log.h"
+#include <stdarg.h>
+
+Logger logger;
+
+static const char levelLetters[] = "-EWID";
+
+void Logger::write(uint8_t level, const char* format, ...) {
+  LogRecord record;
+  va_list args;
+  va_start(args, format);
+  vsnprintf_P(record.text, sizeof(record.text), format, args);
+  va_end(args);
+  record.timestampMs = millis();
+  record.level = level;
+  record.repeats = 0;
+
+  // FNV-1a over level and text, identical messages are only counted
+  uint32_t hash = 2166136261u ^ level;
+  for (const char* c = record.text; *c; c++) hash = (hash ^ (uint8_t)*c) * 16777619u;
+  if (hash == lastHash && strcmp(record.text, last.text) == 0 && level == last.level) {
+    repeatsTotal++;
+    if (repeatCount == 0) repeatStartMs = record.timestampMs;
+    repeatCount++;
+    if (repeatCount == 0xFFFF || record.timestampMs - repeatStartMs >= LOG_REPEAT_FLUSH_MS) endRepeatRun();
+    return;
+  }
+
+  endRepeatRun();
+  last = record;
+  lastHash = hash;
+  queue.push(record);  // Counted as dropped when the queue is full
+}
+
+void Logger::writeFrame(const uint8_t* data, uint8_t length) {
+  LogRecord record;
+  if (length > sizeof(record.text)) return;
+  record.timestampMs = millis();
+  record.level = LOG_LEVEL_NONE;
+  record.repeats = length;
+  memcpy(record.text, data, length);
+  queue.push(record);  // Not part of repeat folding, a pending "xN" run stays open
+}
+
+void Logger::endRepeatRun() {
+  if (repeatCount == 0) return;
+  LogRecord record = last;
+  record.timestampMs = repeatStartMs;
+  record.repeats = repeatCount;
+  repeatCount = 0;
+  queue.push(record);
+}
+
+void Logger::drain(HardwareSerial& out) {
+  // A run of repeats that has gone quiet is printed after the flush interval too
+  if (repeatCount > 0 && millis() - repeatStartMs >= LOG_REPEAT_FLUSH_MS) endRepeatRun();
+
+  for (;;) {
+    if (lineSent == lineLength && !nextLine()) return;
+
+    // Only what fits in the TX FIFO, the rest goes on the next call
+    int room = out.availableForWrite();
+    if (room <= 0) return;
+    int chunk = lineLength - lineSent;
+    if (chunk > room) chunk = room;
+    out.write((const uint8_t*)line + lineSent, chunk);
+    lineSent += chunk;
+  }
+}
+
+void Logger::flush(HardwareSerial& out) {
+  endRepeatRun();
+  for (;;) {
+    if (lineSent == lineLength && !nextLine()) return;
+    out.write((const uint8_t*)line + lineSent, lineLength - lineSent);  // Waits for the UART
+    lineSent = lineLength;
+  }
+}
+
+bool Logger::nextLine() {
+  LogRecord record;
+  if (!queue.pop(record)) return false;
+  int n;
+  if (record.level == LOG_LEVEL_NONE) {
+    memcpy(line, record.text, record.repeats);
+    n = record.repeats;
+  } else if (record.repeats) {
+    n = snprintf(line, sizeof(line), "[%lu %c] %s x%u\r\n", (unsigned long)record.timestampMs,
+                 levelLetters[record.level], record.text, record.repeats);
+  } else {
+    n = snprintf(line, sizeof(line), "[%lu %c] %s\r\n", (unsigned long)record.timestampMs,
+                 levelLetters[record.level], record.text);
+  }
+  lineLength = n < (int)sizeof(line) ? n : sizeof(line) - 1;
+  lineSent = 0;
+  return true;
+}
@@ -14,14 +14,41 @@
 #include <ESP8266WiFi.h>  // Include the ESP8266 WiFi library
 #include <ArduinoOTA.h>  // Include the Arduino OTA library
 #include <WiFiUdp.h>  
-#include <NTPClient.h>
 #include <time.h>
 #include <Fonts/FreeSansBold12pt7b.h>  // Include the custom font header file
 #include <Fonts/TomThumb.h>  // Include the custom font header file
-
-// Define NTP Client to get time
+#include "scheduler.h"  // Cooperative task scheduler
+#include "event_queue.h"  // Lock-free Ticker -> loop() event queue
+#include "centi_temp.h"  // Fixed-point temperature type used from the ADC to the screen
+#include "thermistor.h"  // Compile-time ADC-to-temperature table
+#include "adc_filter.h"  // Burst, median-of-k and EMA filtering of A0
+#include "local_clock.h"  // Wall clock with scheduled NTP resync
+#include "my_st7735.h"  // ST7735 subclass with SPI byte accounting
+#include "text_field.h"  // Text that repaints only changed glyphs
+#include "strip_chart.h"  // Hardware-scrolled strip chart
+#include "packed_history.h"  // Bit-packed ring of timestamped readings with O(1) min/max
+#include "rollup.h"  // Per-minute and per-hour min/max/mean buckets
+#include "trend_stats.h"  // Streaming 1h/24h statistics and crossing events for the Trends screen
+#include "temp_predictor.h"  // Rate of change and time to the high alert, early warning
+#include "alert_rules.h"  // Alert rule table and the timestamped event log
+#include "log.h"  // Buffered, leveled logging to the UART
+#include "telemetry.h"  // COBS-framed delta/varint telemetry records
+#include "fan_control.h"  // Fixed-point PID fan speed control with hysteresis and autotune
+#include "buttons.h"  // Interrupt edge capture, debounce, long press, repeat and combo events
+#include "screen.h"  // Table-driven menu and screens, drawn only when something changed
+#include "profile.h"  // Cycle-counter profiling zones, shown on the Diagnostics screen
+#include <LittleFS.h>  // Flash file system for the history log
+#include "flash_log.h"  // Minute records kept in flash across restarts
+
+// NTP over a plain UDP socket, the answer is polled from the clock task
 WiFiUDP ntpUDP;
-NTPClient timeClient(ntpUDP, "pool.ntp.org", 19800, 60000); // Offset for India (UTC+5:30)
+#define NTP_SERVER "pool.ntp.org"
+#define NTP_PORT 123
+#define NTP_LOCAL_PORT 1337
+#define NTP_PACKET_SIZE 48
+#define NTP_TIMEOUT_MS 1000           // No answer by then counts as a failed sync
+#define NTP_TIME_OFFSET_S 19800       // Offset for India (UTC+5:30)
+#define NTP_UNIX_EPOCH 2208988800UL   // 1970 in NTP seconds (since 1900)
 
 
 // WiFi credentials
@@ -62,31 +89,74 @@ const char* password = "8089128014";
 #if DISABLE_LOCAL
 
 Ticker Timer1;// Create a Ticker object to manage the timer interrupt
+Scheduler scheduler; // Runs the sampling, clock, button and screen tasks from loop()
 
-unsigned long currentTime = millis() / 1000; // Convert millis to seconds
-int hours = (currentTime / 3600) % 24;  // Extract hours (mod 24 for 24-hour format)
-int minutes = (currentTime / 60) % 60;  // Extract minutes
-int seconds = currentTime % 60;         // Extract seconds
+// Events posted by the Ticker callback and handled in loop()
+typedef enum { EVENT_SAMPLE } EventType;
+struct TimerEvent {
+  uint32_t timestampMs; // millis() when the Ticker fired
+  uint8_t type;         // EventType
+};
+EventQueue<TimerEvent, 8> timerEvents; // Ticker is the only producer, the sample task the only consumer
+unsigned long lastSampleMillis = 0;    // Timestamp of the sample being processed
+
+// Task periods
+#define SAMPLE_PERIOD_MS 10    // Drain the Ticker event queue
+#define CLOCK_PERIOD_MS 250    // Time update (local, no network)
+#define BUTTON_PERIOD_MS 5     // Button events (edges arrive by interrupt, this sets the latency)
+#define SCREEN_PERIOD_MS 100   // Screen refresh
+#define LOG_PERIOD_MS 5        // Log drain (the UART sends ~58 bytes in 5 ms)
+
+int hours = 0;    // Hours (24-hour format)
+int minutes = 0;  // Minutes
+int seconds = 0;  // Seconds
+
+LocalClock localClock; // Keeps the time between NTP resyncs
+
+// Clock sync source: start sends one NTP request, the following clock task runs look for the
+// answer without waiting, so a slow or lost answer never holds up the loop
+ClockSyncResult ntpSync(bool start, uint32_t& epochSeconds) {
+  static uint32_t sentMs = 0;
+  uint8_t packet[NTP_PACKET_SIZE];
+  if (start) {
+    if (WiFi.status() != WL_CONNECTED) {
+      LOG_WARN("NTP sync failed: no WiFi");
+      return CLOCK_SYNC_FAILED;
+    }
+    while (ntpUDP.parsePacket() > 0) ntpUDP.flush();  // A late answer to an earlier request
+    memset(packet, 0, sizeof(packet));
+    packet[0] = 0b11100011;  // LI unknown, version 4, client
+    packet[2] = 6;           // Polling interval
+    packet[3] = 0xEC;        // Clock precision
+    ntpUDP.beginPacket(NTP_SERVER, NTP_PORT);
+    ntpUDP.write(packet, sizeof(packet));
+    ntpUDP.endPacket();
+    sentMs = millis();
+    return CLOCK_SYNC_PENDING;
+  }
+  if (ntpUDP.parsePacket() < NTP_PACKET_SIZE) {
+    if (millis() - sentMs < NTP_TIMEOUT_MS) return CLOCK_SYNC_PENDING;
+    LOG_WARN("NTP sync failed: no answer");
+    return CLOCK_SYNC_FAILED;
+  }
+  ntpUDP.read(packet, sizeof(packet));
+  // Transmit timestamp, whole seconds since 1900
+  uint32_t ntpSeconds = (uint32_t)packet[40] << 24 | (uint32_t)packet[41] << 16 | (uint32_t)packet[42] << 8 | packet[43];
+  epochSeconds = ntpSeconds - NTP_UNIX_EPOCH + NTP_TIME_OFFSET_S; // Indian Standard Time (IST)
+  LOG_INFO("Indian Time: %02lu:%02lu:%02lu", (unsigned long)(epochSeconds / 3600 % 24),
+           (unsigned long)(epochSeconds / 60 % 60), (unsigned long)(epochSeconds % 60));
+  return CLOCK_SYNC_OK;
+}
 
-unsigned long startMillis = millis();  // Store the reference time
-bool isTimeManuallySet = false; // Flag to track if time has been manually set
 // Function to update time based on elapsed time
 void updateTime() {
-  // Fetch the current time from the NTP server
-  timeClient.update();
-
-  // Get the time in Indian Standard Time (IST)
-  hours = timeClient.getHours();
-  minutes = timeClient.getMinutes();
-  seconds = timeClient.getSeconds();
-
-  // Debug: Print the time
-  Serial.print("Indian Time: ");
-  Serial.print(hours);
-  Serial.print(":");
-  Serial.print(minutes);
-  Serial.print(":");
-  Serial.println(seconds);
+  PROFILE_ZONE("clock");
+  // Advance the local clock, it resyncs from NTP on its own schedule
+  localClock.update();
+
+  hours = localClock.hours();
+  minutes = localClock.minutes();
+  seconds = localClock.seconds();
 }
 
 #if LED_ENABLE
@@ -153,12 +223,6 @@ void controlLED(LEDColor ledIndex, bool enable) {
 const int buzzerPin = 9; // Buzzer connected to pin 5
 #endif
 
-// Display and character height details
-int menuScrollOffset = 0;  // Variable to control the scrolling offset
-#define MENU_ITEM_HEIGHT 20  // Height for each menu item
-#define VISIBLE_MENU_ITEMS 5 // Number of items visible on menu screen at a time
-int start_index = 0;   // Menu start position
-
 // OLED Display Setup
 #define SCREEN_WIDTH 128 // OLED display width, in pixels 
 #define SCREEN_HEIGHT 160 // OLED display height, in pixels
@@ -176,17 +240,13 @@ int start_index = 0;   // Menu start position
 
 #endif
 
-// Create a derived class to access protected members
-class MyST7735 : public Adafruit_ST7735 { // Create a derived class to access protected members
-public: // Public access
-  MyST7735(int8_t cs, int8_t dc, int8_t rst) : Adafruit_ST7735(cs, dc, rst) {}// Constructor
-
-  void setColRowStartOffset(int8_t col, int8_t row) {// Set the column and row start offset
-    setColRowStart(col, row); // Call the protected function
-  }  
-};
-
 MyST7735 display = MyST7735(display_CS, display_DC, display_RST);
+StripChart stripChart(display); // Live chart, scrolled by the controller
+#if BUTTON_ENABLE
+extern const ScreenDef screenTable[];  // Menu entries, defined after the screens
+extern const uint8_t screenCount;
+ScreenManager screens(display, screenTable, screenCount, &TomThumb, ST7735_WHITE, ST77XX_ORANGE);
+#endif
 
 #if BUTTON_ENABLE
 // Button Pins
@@ -196,17 +256,25 @@ MyST7735 display = MyST7735(display_CS, display_DC, display_RST);
 #define BTN_UP D1 // Digital pin for joystick down
 #define BTN_SELECT D2 // Digital pin for joystick press
 #define BTN_BACK D3 // Digital pin for joystick left
+// Buttons in screen.h key order, all three held together is the OTA combo
+ButtonInput buttons(3, (1 << SCREEN_KEY_UP) | (1 << SCREEN_KEY_SELECT) | (1 << SCREEN_KEY_BACK));
 #endif
 // Fan Status
-volatile int FAN_STATUS = 0;
+int FAN_STATUS = 0; // Only written from loop() context
 // SET ,RESET and FAN control macros 
 #define SET 1 
 #define RESET 0
 #define FAN_ON SET // Fan ON
 #define FAN_OFF RESET // Fan OFF
-// Menu States
-typedef enum { HOME, SETTINGS, CHART, TRENDS, ALERTS, DIAGNOSTICS, ABOUT, SETTINGS_EDIT } Menu;
-Menu currentMenu = HOME;
+// Chart views, UP on the Chart screen steps through them
+typedef enum {
+  CHART_VIEW_20S, CHART_VIEW_1H, CHART_VIEW_24H,
+#if FLASH_LOG_ENABLE
+  CHART_VIEW_7D,  // From the flash log
+#endif
+  CHART_VIEW_LIVE, CHART_VIEW_COUNT
+} ChartView;
+ChartView chartView = CHART_VIEW_20S;
 
 // Logos
 #define FRAME_DELAY (42)  // Delay between frames
@@ -214,37 +282,77 @@ Menu currentMenu = HOME;
 #define FRAME_HEIGHT (48) // Height of each frame
 #define FRAME_COUNT_HOME (sizeof(frames_home) / sizeof(frames_home[0]))
 
-// Settings Variables
-float highTempAlert = 40.0;  // Upper temperature limit
-float lowTempAlert = 20.0;   // Lower temperature limit
+// Settings Variables, rows of the Settings screen in order
+enum {
+  SETTING_HIGH_TEMP, SETTING_LOW_TEMP, SETTING_TIME, SETTING_FAN_SETPOINT, SETTING_FAN_KP, SETTING_FAN_KI,
+  SETTING_FAN_KD, SETTING_FAN_MIN_DUTY, SETTING_FAN_HYSTERESIS, SETTING_WARN_AHEAD, SETTING_FAN_PRESTART,
+  SETTING_FAN_AUTOTUNE, SETTINGS_COUNT
+};
+#define SETTINGS_PER_PAGE 7  // Rows shown at once, the cursor pages through the rest
+CentiC highTempAlert = CentiC::fromDegrees(40);  // Upper temperature limit
+CentiC lowTempAlert = CentiC::fromDegrees(20);   // Lower temperature limit
 String mode = "Auto";
 int editIndex = 0;           // Index for editing settings
+bool inEditMode = false;     // Flag to track if a setting is being edited
+int editValue = 0;           // Temporary variable to hold the value being edited
+int timeEditIndex = 0;       // 0 = Hours, 1 = Minutes, 2 = Seconds (for time editing)
+int local_hours = 0, local_minutes = 0, local_seconds = 0; // Time being edited
 
 // Temperature Data
-float internalTemp = 25.0;   // Simulated temperature
-float offsetTemp = 40.0;      // Offset temperature
-float tempHistory[20] = { 25.0 };  // Last 20 temperature readings
-int peakCrossCount = 0;      // Count of times temperature crossed peak
-float peakTemp = 0.0;        // Peak temperature
-float lowerTemp = 100.0;     // Lower temperature
+CentiC internalTemp = CentiC::fromDegrees(25);  // Latest reading
+CentiC peakTemp = CentiC::fromDegrees(0);       // Highest reading since boot
+CentiC lowerTemp = CentiC::fromDegrees(100);    // Lowest reading since boot
+AdcFilter adcFilter;         // Filters the A0 readings before conversion
+PackedHistory<HISTORY_BLOCKS, HISTORY_BLOCK_BYTES> tempHistory;  // Readings with timestamps, read by the chart, trends and alerts
+RollupTier<60> tempMinutes(ROLLUP_MINUTE_MS);      // Last hour, one bucket per minute
+RollupTier<24> tempHours(ROLLUP_HOUR_MS);          // Last day, one bucket per hour
+#if TELEMETRY_BINARY
+TelemetryEncoder telemetry;  // One binary frame per reading instead of the temperature log line
+#endif
+TrendStats trendStats;       // Moments, percentiles, crossing events and time above, per reading
+#if FLASH_LOG_ENABLE
+FlashLog flashLog;           // One record per closed minute, read back by the 7d chart and trends
+uint32_t flashLogBase = 0;   // Newest record time at boot, record times continue from it until NTP syncs
+#define FLASH_CHART_SLOT_S (6 * 3600UL)  // 7d chart: one point per 6 hours
+#define FLASH_CHART_POINTS 28
+uint32_t flashLogTime();     // Time stamp of a new record
+RollupSummary weekSummary = {};  // Last 7 days from the flash log, for the Trends screen
+void updateWeekSummary();    // Query the flash log for weekSummary
+#endif
+FanController fanController; // Fan PWM duty from the filtered reading
+TempPredictor tempPredictor; // Fitted rate of change, early warning before the high alert
+// Alert rules, evaluated once per reading. The thresholds of the first two follow highTempAlert
+// and lowTempAlert (Settings screen)
+enum { ALERT_RULE_HIGH, ALERT_RULE_LOW };
+const AlertRule alertRules[] = {
+  // name       direction    threshold                 hysteresis              min s  severity
+  { "High temp", ALERT_ABOVE, CentiC::fromDegrees(40), CentiC::fromCenti(50), 3, ALERT_CRITICAL },
+  { "Low temp", ALERT_BELOW, CentiC::fromDegrees(20), CentiC::fromCenti(50), 30, ALERT_WARNING },
+};
+AlertEngine alertEngine;     // Rule states and the event log shown on the Alerts screen
 
  
 // Function Prototypes
-void drawMenu();  // Draw the main menu
 #if BUTTON_ENABLE==1
-void drawHome();  // Draw the home screen
-void drawSettings();    // Draw the settings screen
-void drawSettingsEdit(); // Draw the settings edit screen
-void drawChart();  // Draw the chart screen
-void drawTrends();  // Draw the trends screen
-void drawAlerts();  // Draw the alerts screen
-void drawDiagnostics();  // Draw the diagnostics screen
-void drawAbout();  // Draw the about screen
-void updateChartData(); // Update temperature history and peak/lower temperatures
+// Screens: enter draws the static content, draw the parts that change (see screen.h)
+void enterHome(); void drawHome();  // Home screen
+void enterSettingsEdit(); void drawSettingsEdit(); // Settings edit screen
+void enterChart(); void drawChart(); void leaveChart(); // Chart screen
+void enterStripChart(); void drawStripChart();  // Chart screen in strip-chart mode
+void enterTrends(); void drawTrends();  // Trends screen
+void enterAlerts(); void drawAlerts();  // Alerts screen
+void enterDiagnostics(); void drawDiagnostics(); bool updateDiagnostics(); // Diagnostics screen
+bool diagnosticsInput(const ButtonEvent& event); // Diagnostics screen buttons
+bool alertsInput(const ButtonEvent& event); // Alerts screen buttons
+void drawProfileZones(); // Diagnostics screen, profile page
+void enterAbout();  // About screen
+bool settingsInput(const ButtonEvent& event); // Settings screen buttons
+bool chartInput(const ButtonEvent& event); // Chart screen buttons
+void settingsEditUp(); // Settings screen UP button
+bool settingsEditBack(); // Settings screen BACK button, returns false to leave the screen
+void settingsEditSelect(); // Settings screen SELECT button
+void updateChartData(); // Add the latest reading to the temperature history and track peak/lower
 void readTemperature(); // Read temperature from the thermistor
-void handleUp(); // Handle the up button press
-void handleSelect(); // Handle the select button press
-void handleBack(); // Handle the back button press
 #if ENABLE_BUZZER
 void buzzer_alarm(); // Buzzer alarm sound
 void playerPaddleTone(); // Buzzer sound for player paddle
@@ -252,13 +360,18 @@ void playerPaddleTone(); // Buzzer sound for player paddle
 #if LED_ENABLE
 void controlLED(LEDColor ledIndex, bool enable); // Control LED brightness
 #endif
-void Tool_bar(Menu choice);   // Tool bar for the menu
-void button_debouce_delay();  // Debounce delay for buttons
-void checkSerialForOTAUpdate(); // Check for OTA update
-
-void button_debouce_delay() { // Debounce delay for buttons
-  delay(1000);
-}
+void sampleTask(); // Scheduler task: handle queued Ticker events
+void clockTask(); // Scheduler task: time update
+void buttonTask(); // Scheduler task: button events
+void onButton(const ButtonEvent& event); // Act on one button event
+void upEdgeIsr(); // Button interrupts, queue the edge
+void selectEdgeIsr();
+void backEdgeIsr();
+void enterOTAUpdateMode(); // OTA countdown, entered with the three-button combo
+void screenTask(); // Scheduler task: screen refresh
+void logTask(); // Scheduler task: send queued log lines to the UART
+int settingValue(int index); // Value of a numeric setting as it is edited
+void setSettingValue(int index, int value); // Store an edited setting
 
 #if ENABLE_BUZZER
 void buzzer_alarm() { // Buzzer alarm sound
@@ -291,11 +404,11 @@ void buzzer_buttonClick() { // Button click sound
     noTone(buzzerPin); // Stop the buzzer
 }
 
-void buzzer_alert(float temperature) { // Buzzer alert based on temperature
+void buzzer_alert(CentiC temperature) { // Buzzer alert based on temperature
     int buzzerPin = 5; // Define the buzzer pin
 
     // Map temperature (45°C to 60°C) to rate (1 to 3)
-    int rate = 1 + ((temperature - 45) / (60 - 45)) * (3 - 1);
+    int rate = 1 + (temperature.raw - 4500) * (3 - 1) / (6000 - 4500);
     
     int duration = 200 * rate; // Scale duration
     tone(buzzerPin, 220, 200); // Fixed frequency, variable duration
@@ -328,158 +441,116 @@ void buzzer_select() {
 #endif
 
 #if BUTTON_ENABLE
-void handleUp() {
-  Serial.println("Up button pressed");
-#if ENABLE_BUZZER
-  buzzer_buttonClick();
-#endif
-  if (currentMenu == SETTINGS_EDIT) {
-    // Edit settings (upper/lower temp or time)
-    switch (editIndex) {
-      case 0:  // Upper temperature limit
-        highTempAlert += 1.0;
-        if (highTempAlert > 60.0) highTempAlert = 40.0;  // Roll over at 60°C
-        break;
-      case 1:  // Lower temperature limit
-        lowTempAlert -= 1.0;
-        if (lowTempAlert < 25.0) lowTempAlert = 35.0;    // Roll over at 25°C
-        break;
-      case 2:  // Time
-        currentTime += 1;
-        if (currentTime > 235959) currentTime = 0;       // Roll over at 23:59:59
-        break;
-    }
-    drawSettingsEdit();  // Redraw the settings edit screen
-  } else if (currentMenu == HOME || currentMenu == SETTINGS || currentMenu == CHART || 
-             currentMenu == TRENDS || currentMenu == ALERTS || currentMenu == DIAGNOSTICS || 
-             currentMenu == ABOUT) {
-    currentMenu = static_cast<Menu>((currentMenu + 1) % 7);
-    currentMenu = static_cast<Menu>(currentMenu % 7);
-    drawMenu();  // Redraw the menu after scrolling
+// Settings screen: UP/BACK step the cursor or the value (also on repeat), SELECT edits and saves
+bool settingsInput(const ButtonEvent& event) {
+  bool repeat = event.type == BUTTON_REPEAT;
+  if (event.button == SCREEN_KEY_UP && (event.type == BUTTON_PRESS || repeat)) {
+    settingsEditUp();
+    return true;
+  }
+  if (event.button == SCREEN_KEY_BACK && (event.type == BUTTON_PRESS || (repeat && inEditMode))) {
+    return settingsEditBack();  // False leaves the screen
+  }
+  if (event.button == SCREEN_KEY_SELECT && event.type == BUTTON_PRESS) {
+    settingsEditSelect();
+    return true;
   }
+  return repeat;  // A held BACK outside edit mode does nothing
 }
 
-void handleSelect() {
-  Serial.println("Select button pressed");
-#if ENABLE_BUZZER
-  buzzer_select();
-#endif
-  button_debouce_delay();
-  // Transition to the selected menu item
-  switch (currentMenu) {
-    case HOME:
-      drawHome();
-      break;
-    case SETTINGS:
-      currentMenu = SETTINGS_EDIT;
-      drawSettingsEdit();
-      break;
-    case CHART:
-      drawChart();
-      break;
-    case TRENDS:
-      drawTrends();
-      break;
-    case ALERTS:
-      drawAlerts();
-      break;
-    case DIAGNOSTICS:
-      drawDiagnostics();
-      break;
-    case ABOUT:
-      drawAbout();
-      break;
-    default:
-      drawMenu();
-      break;
-  } 
+// Chart screen: UP steps through the views (20s, 1h, 24h, 7d, live), each has its own layout
+bool chartInput(const ButtonEvent& event) {
+  if (event.button != SCREEN_KEY_UP || event.type != BUTTON_PRESS) return false;
+  stripChart.end();
+  chartView = static_cast<ChartView>((chartView + 1) % CHART_VIEW_COUNT);
+  screens.restart();
+  return true;
 }
 
-void handleBack() {
-  Serial.println("Back button pressed");
-#if ENABLE_BUZZER
-  buzzer_back();
-#endif
-  if (currentMenu != HOME) {
-    // Return to home menu
-    currentMenu = HOME;
-    start_index = 0;
-    drawMenu();
-  }
-}
 #endif
 
 #if DISABLE_LOCAL
+// Ticker callback: only timestamps the tick and queues it, the sample task does the work
 void interrupt_Handler() {
-  // Update time
-  //updateTime();
-  // Read Temperature
-  readTemperature();
-  // Read Chart buffer
-  //updateChartData();
-  #if LED_ENABLE
-  // Update LED's
-  updateLEDs();
-  #endif 
+  TimerEvent event = { (uint32_t)millis(), EVENT_SAMPLE };
+  timerEvents.push(event); // Dropped (and counted) if loop() has fallen 8 ticks behind
 }
 
 void readTemperature() {
-  const float BETA = 3950; // BETA coefficient of the thermistor
-  const float R0 = 10000;  // Resistance of the thermistor at 25°C (10k ohms)
-  const float T0 = 298.15; // Reference temperature in Kelvin (25°C)
-
-  int sensorValue = analogRead(A0);  // Read from analog pin A0
-  if (sensorValue == 0) {
-    Serial.println("Error: Sensor value is 0, check the sensor connection.");
-    return; // Avoid division by zero
+  PROFILE_ZONE("read");
+  uint16_t burst[ADC_BURST_SAMPLES];  // Back-to-back readings of A0
+  for (int i = 0; i < ADC_BURST_SAMPLES; i++) {
+    burst[i] = analogRead(A0);  // Read from analog pin A0
+  }
+  if (AdcFilter::medianOfK(burst, ADC_BURST_SAMPLES) == 0) {
+    LOG_ERROR("Sensor value is 0, check the sensor connection.");
+    return; // Open divider, no valid reading (and keep it out of the filter)
   }
 
-  float voltage = sensorValue * (3.3 / 1023.0); // Convert ADC value to voltage
-  float R = R0 * (3.3 / voltage - 1); // Calculate the resistance of the thermistor
-
-  // Calculate temperature in Kelvin using the Steinhart-Hart equation
-  float temperatureK = 1 / (1 / T0 + log(R / R0) / BETA);
-  // Convert temperature from Kelvin to Celsius
-  internalTemp = temperatureK - 273.15;
-  // Temperature offset correction
-  internalTemp += offsetTemp;
-
-  Serial.print("Temperature: "); // Print temperature to serial monitor
-  Serial.println(internalTemp);  // Print temperature to serial monitor
+  // Outlier rejection and EMA, then the precomputed Beta equation (see thermistor.h)
+  uint16_t filteredQ4 = adcFilter.update(burst, ADC_BURST_SAMPLES);
+  internalTemp = thermistorCentiCFromQ4(filteredQ4);
+  updateChartData();
+
+  // Predicted crossing of the high alert: warn, and start the fan early if allowed
+  bool earlyWarning = tempPredictor.update(lastSampleMillis, internalTemp, highTempAlert);
+  static bool earlyLogged = false;
+  if (earlyWarning && !earlyLogged) {
+    LOG_WARN("High temp predicted in %lds (%s C/min)", (long)tempPredictor.etaSeconds(highTempAlert),
+             CentiText(tempPredictor.ratePerMin(), 2).str);
+  }
+  earlyLogged = earlyWarning;
+  fanController.setPrestart(earlyWarning && tempPredictor.settings.fanPrestart);
 
-  if (internalTemp >= peakTemp) {
-    peakTemp = internalTemp;
-  } 
+#if !TELEMETRY_BINARY
+  LOG_INFO("Temperature: %s", CentiText(internalTemp).str); // Print temperature to serial monitor
+#endif
 
-  if (internalTemp < lowerTemp) {
-    lowerTemp = internalTemp; 
+  // Fan speed follows the PID, FAN_STATUS only says whether it is running
+  analogWrite(FAN_PWM_PIN, fanController.update(internalTemp, tempHistory.newest().timestampMs));
+  FAN_STATUS = fanController.running() ? FAN_ON : FAN_OFF;
+  static FanController::AutotuneState tuneState = FanController::TUNE_IDLE;
+  if (fanController.autotuneState() != tuneState) {
+    tuneState = fanController.autotuneState();
+    if (tuneState == FanController::TUNE_RUNNING) LOG_INFO("Fan autotune started");
+    if (tuneState == FanController::TUNE_DONE) {
+      LOG_INFO("Fan autotune done: Kp %u Ki %u", fanController.tuning.kp, fanController.tuning.ki);
+    }
+    if (tuneState == FanController::TUNE_FAILED) LOG_WARN("Fan autotune failed, tuning unchanged");
   }
+#if BUTTON_ENABLE
+  screens.markDirty();  // New reading, the open screen draws on its next tick
+#endif
 
-  if (internalTemp > highTempAlert) {
-    peakCrossCount++;
+  // Alert rules work on the reading just stored, with the thresholds from the Settings
+  CentiC latestTemp = tempHistory.newest().value;
+  alertEngine.setThreshold(ALERT_RULE_HIGH, highTempAlert);
+  alertEngine.setThreshold(ALERT_RULE_LOW, lowTempAlert);
+  uint32_t logged = alertEngine.eventsLogged();
+  if (alertEngine.update(lastSampleMillis, latestTemp)) {
+    for (uint32_t i = alertEngine.eventsLogged() - logged; i-- > 0;) {
+      const AlertEvent& event = alertEngine.event(i);
+      LOG_WARN("%s %s at %s", alertEngine.rule(event.rule).name, event.raised ? "raised" : "cleared",
+               CentiText(event.value).str);
+    }
+  }
+  if (alertEngine.active(ALERT_RULE_HIGH)) {
 #if LED_ENABLE
     // Turn on over temperature status led
     digitalWrite(LED_PIN_RED, HIGH);
 #endif
-    // Update Fan status
-    FAN_STATUS = FAN_ON;
-    // Calculate rate dynamically based on temperature deviation
-    int rate = 1 + (internalTemp - highTempAlert) / 5; // Adjust scaling factor as needed
-    rate = constrain(rate, 1, 5); // Keep within a reasonable range
     // Send buzzer alert
 #if ENABLE_BUZZER
-    buzzer_alert(internalTemp);
+    buzzer_alert(latestTemp);
 #endif
   } else {
 #if LED_ENABLE
     // Turn off over temperature status led
     digitalWrite(LED_PIN_RED, LOW);
 #endif
-    // Update Fan status
-    FAN_STATUS = FAN_OFF;
   }
 
-  if (internalTemp < highTempAlert && internalTemp > lowTempAlert) {
+  if (latestTemp < highTempAlert && latestTemp > lowTempAlert) {
 #if LED_ENABLE
     // Turn on fan status led
     digitalWrite(LED_PIN_YELLOW, HIGH);
@@ -490,9 +561,24 @@ void readTemperature() {
     digitalWrite(LED_PIN_YELLOW, LOW);
 #endif
   }
+
+#if TELEMETRY_BINARY
+  // Sent through the logger so a frame never lands inside a text line
+  TelemetrySample sample;
+  sample.timestampMs = tempHistory.newest().timestampMs;
+  sample.adcQ4 = adcFilter.lastBurstQ4();
+  sample.centiC = internalTemp.raw;
+  sample.flags = (FAN_STATUS == FAN_ON ? TELEMETRY_FLAG_FAN : 0) |
+                 (latestTemp > highTempAlert ? TELEMETRY_FLAG_HIGH : 0) |
+                 (latestTemp < lowTempAlert ? TELEMETRY_FLAG_LOW : 0) |
+                 (earlyWarning ? TELEMETRY_FLAG_EARLY : 0);
+  uint8_t frame[TELEMETRY_FRAME_MAX];
+  logger.writeFrame(frame, telemetry.encode(sample, frame));
+#endif
 }
 
 void setTheme() {
+  PROFILE_ZONE("theme");
   // Set background color (e.g., orange)
   uint16_t backgroundColor = ST77XX_ORANGE; // Orange color
   display.fillScreen(backgroundColor);      // Fill the entire screen with the background color
@@ -507,470 +593,871 @@ void setTheme() {
   display.setTextSize(20);
 }
 
-// Update temperature history and track peak/lower temperatures
+// Add the latest reading to the temperature history and track peak/lower since boot
+// and fold it into the minute and hour rollups
 void updateChartData() {
-  for (int i = 0; i < 19; i++) {
-    tempHistory[i] = tempHistory[i + 1];
-  }
-  tempHistory[19] = internalTemp;
-
-  // Track peak and lower temperatures
+  tempHistory.push(lastSampleMillis, internalTemp);
   if (internalTemp > peakTemp) peakTemp = internalTemp;
   if (internalTemp < lowerTemp) lowerTemp = internalTemp;
+  trendStats.add(lastSampleMillis, internalTemp, highTempAlert);
+#if FLASH_LOG_ENABLE
+  // A reading in a new minute closes the open bucket, which then goes to the flash log
+  RollupBucket minute = tempMinutes.empty() ? RollupBucket{} : tempMinutes.newest();  // Copy, add() reuses the slot
+  bool closed = minute.count > 0 && lastSampleMillis / ROLLUP_MINUTE_MS != minute.period;
+#endif
+  tempMinutes.add(lastSampleMillis, internalTemp);
+  tempHours.add(lastSampleMillis, internalTemp);
+#if FLASH_LOG_ENABLE
+  if (closed) {
+    uint32_t writes = flashLog.blockWrites();
+    flashLog.append({ flashLogTime(), minute.min, minute.max, minute.mean(), minute.count, trendStats.crossings() });
+    if (flashLog.blockWrites() != writes) updateWeekSummary();  // The 7d figures only move this often
+  }
+#endif
+}
+
+#if FLASH_LOG_ENABLE
+// Record time: wall clock seconds once NTP has synced; before that the newest logged time
+// carried on by the uptime, so records stay in order across restarts
+uint32_t flashLogTime() {
+  if (localClock.isSynced()) return (uint32_t)(localClock.wallMs() / 1000);
+  return flashLogBase + (uint32_t)(localClock.monotonicMs() / 1000);
+}
+
+// Fold flash log records into the 6-hour points of the 7d chart
+struct FlashChartSlots {
+  uint32_t from;
+  RollupBucket* points;
+};
+bool foldFlashChartRecord(const FlashLogRecord& record, void* context) {
+  FlashChartSlots* slots = static_cast<FlashChartSlots*>(context);
+  uint32_t slot = (record.time - slots->from) / FLASH_CHART_SLOT_S;
+  if (slot < FLASH_CHART_POINTS) slots->points[slot].merge(flashLogBucket(record));  // 6 h of readings fit a bucket
+  return true;
+}
 
-  // Count how many times temperature crossed the peak
-  if (internalTemp > highTempAlert) peakCrossCount++;
+// Min/mean/max of the last 7 days, from the flash log
+void updateWeekSummary() {
+  uint32_t end = flashLogTime() + 1, span = 7 * 86400UL;
+  weekSummary = {};
+  flashLog.query(end > span ? end - span : 0, end, flashLogFoldSummary, &weekSummary);
 }
+#endif
 
 unsigned long previousMillis = 0; // Store the last time the screen was updated
 const long interval = 1000;        // Update interval (1 second)
 
 unsigned long currentMillis; // Variable to store current millis
 
-void drawHome() {
-  static float lastTemp = -1000.0; // Store the last temperature to detect changes
-  static int lastHours = -1, lastMinutes = -1, lastSeconds = -1; // Store the last time to detect changes
-
-  // Initial screen setup
+// Screen text fields, each one repaints only the glyphs that changed since its last draw
+TextField homeTempField(10, 40, &TomThumb);      // "Temperature: 25.00"
+TextField homeTimeField(10, 60, &TomThumb);      // "Time: 12:00:00"
+TextField settingsRowFields[SETTINGS_PER_PAGE] = {  // One field per setting line, cursor included
+  TextField(10, 22, &TomThumb), TextField(10, 32, &TomThumb), TextField(10, 42, &TomThumb),
+  TextField(10, 52, &TomThumb), TextField(10, 62, &TomThumb), TextField(10, 72, &TomThumb),
+  TextField(10, 82, &TomThumb)
+};
+TextField settingsMarkFields[3] = {              // `_` under the hours/minutes/seconds being edited
+  TextField(56, 45, &TomThumb), TextField(75, 45, &TomThumb), TextField(95, 45, &TomThumb)
+};
+TextField settingsHelpField(10, 100, &TomThumb); // Button hints
+TextField chartTitleField(10, 10, &TomThumb);    // Chart view name
+TextField chartEmptyField(76, 70, &TomThumb);    // "No data" in the plot area, when a view has none
+TextField chartAxisFields[3] = {                 // Y-axis labels (max, middle, min)
+  TextField(2, 30, &TomThumb), TextField(2, 70, &TomThumb), TextField(2, 110, &TomThumb)
+};
+TextField trendFields[9] = {                     // Peak/lower, crossings, 1h and 24h (3 lines each), 7d
+  TextField(10, 24, &TomThumb), TextField(10, 35, &TomThumb), TextField(10, 46, &TomThumb),
+  TextField(10, 57, &TomThumb), TextField(10, 68, &TomThumb), TextField(10, 79, &TomThumb),
+  TextField(10, 90, &TomThumb), TextField(10, 101, &TomThumb), TextField(10, 112, &TomThumb)
+};
+TextField alertField(0, 6, &TomThumb);           // Alert state, on the line below the title
+TextField predictFields[3] = {                   // Rate and fitted level, time to the high alert, warning setting
+  TextField(0, 20, &TomThumb), TextField(0, 30, &TomThumb), TextField(0, 40, &TomThumb)
+};
+#define ALERT_EVENT_ROWS 6                       // Events per page of the Alerts screen
+TextField alertPageField(0, 54, &TomThumb);      // "Events 1-6 of 23"
+TextField alertEventFields[ALERT_EVENT_ROWS] = { // One event per line, newest first
+  TextField(0, 66, &TomThumb), TextField(0, 76, &TomThumb), TextField(0, 86, &TomThumb),
+  TextField(0, 96, &TomThumb), TextField(0, 106, &TomThumb), TextField(0, 116, &TomThumb)
+};
+uint8_t alertPage = 0;                           // Page of the event list, 0 = newest
+uint32_t alertShownEvents = 0;                   // eventsLogged() of the list on screen
+bool alertListDrawn = false;                     // False after enter or a page change
+TextField diagFields[7];                         // Blower, over temp, events, NTP, frame, chart, log lines
+TextField diagTaskFields[SCHEDULER_MAX_TASKS];   // One line per scheduler task
+uint32_t spiFrameBytes = 0;                      // SPI bytes per screen frame, averaged over a second
+uint32_t screenFrameUs = 0;                      // Screen frame time in us, averaged over a second
+
+// Chart plot area, inside the axes. It is rendered off-screen in bands of
+// CHART_BAND_ROWS rows (123 x 16 x 2 = 3.9 KB instead of 20 KB for the whole area)
+#define CHART_X 28
+#define CHART_Y 27
+#define CHART_W 123
+#define CHART_H 83
+#define CHART_BAND_ROWS 16
+#define CHART_POINTS 20  // Newest readings plotted, 5 px apart
+#define CHART_MAX_POINTS 60  // Most points of any view (1h: one per minute, 2 px apart)
+#define CHART_BANDS ((CHART_H + CHART_BAND_ROWS - 1) / CHART_BAND_ROWS)
+#define CHART_TICK_Y 118  // Baseline of the X-axis labels
+
+// Chart views: title, points plotted (the newest at the right) and their spacing, and an
+// X-axis label every tickPoints points with the age in tickAge steps of unit
+struct ChartViewLayout {
+  const char* name;
+  uint8_t points;
+  uint8_t spacing;     // px between points
+  uint8_t tickPoints;
+  uint8_t tickAge;
+  char unit;
+};
+const ChartViewLayout chartViews[] = {
+  { "Chart 20s", CHART_POINTS, 5, 5, 5, 's' },                // Readings
+  { "Chart 1h", tempMinutes.capacity(), 2, 15, 15, 'm' },     // Minute buckets
+  { "Chart 24h", tempHours.capacity(), 5, 6, 6, 'h' },        // Hour buckets
+#if FLASH_LOG_ENABLE
+  { "Chart 7d", FLASH_CHART_POINTS, 4, 4, 1, 'd' },           // 6-hour points
+#endif
+};
+GFXcanvas16 chartBand(CHART_W, CHART_BAND_ROWS);  // Off-screen band of the plot area
+uint32_t chartBandHash[CHART_BANDS];              // Hash of each band as it is on screen
+uint32_t chartRenderUs = 0;                       // Time of the last plot redraw
+uint32_t chartRenderBytes = 0;                    // SPI bytes of the last plot redraw
+bool chartPlotDrawn = false;                      // False until the first plot after the static content
+bool chartEmptyShown = false;                     // The "No data" placeholder is up instead of a plot
+uint32_t chartStripSamples = 0;                   // Readings already in the live strip chart
+
+void enterHome() {
   setTheme();
   //display.drawRect(0, 0, display.width(), display.height(), ST7735_WHITE);
   display.setTextSize(2);  // Larger text size for the title
   display.setCursor(10, 10);
   display.println(F("Home"));
+  homeTempField.invalidate();
+  homeTimeField.invalidate();
+}
+
+void drawHome() {
+  char line[TEXT_FIELD_MAX_CHARS + 1];
+
+  // Temperature and time, unchanged glyphs are not sent again
+  snprintf(line, sizeof(line), "Temperature: %s", CentiText(internalTemp).str);
+  homeTempField.draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+  snprintf(line, sizeof(line), "Time: %d:%02d:%02d", hours, minutes, seconds);
+  homeTimeField.draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+}
+
+// Settings Screen
+void enterSettingsEdit() {
+  // Start on the first setting, not editing
+  inEditMode = false;
+  editValue = 0;
+  editIndex = 0;
+  timeEditIndex = 0;
+  local_hours = hours;
+  local_minutes = minutes;
+  local_seconds = seconds;
+
+  // Set the theme
+  setTheme();
+
   display.setTextSize(1);
-  display.setCursor(10, 40);  // Move down a bit for temperature info
-  display.print(F("Temperature: "));
-  display.println(internalTemp);
-
-  while (digitalRead(BTN_BACK) == HIGH) {
-    // Update time
-    updateTime();
-    // Read Temperature
-    readTemperature();
-    bool updateDisplay = false;
-
-    // Check if temperature has changed
-    if (internalTemp != lastTemp) {
-      // Set text color to orange
-      display.setTextColor(ST7735_ORANGE);
-      display.print(F("Temperature: "));
-      display.println(lastTemp); // Clear any remaining characters
-      lastTemp = internalTemp;
-      updateDisplay = true;
-    }
+  display.setTextColor(ST7735_WHITE);
+  display.setCursor(10, 10);
+  display.println(F("Edit Settings"));
+  for (int i = 0; i < SETTINGS_PER_PAGE; i++) settingsRowFields[i].invalidate();
+  for (int i = 0; i < 3; i++) settingsMarkFields[i].invalidate();
+  settingsHelpField.invalidate();
+}
 
-    // Check if time has changed
-    if (hours != lastHours || minutes != lastMinutes || seconds != lastSeconds) {
-      
-      // Clear previous time value
-      display.setCursor(10, 60);
-      // Set text color to orange
-      display.setTextColor(ST7735_ORANGE);
-      // Write OLD time value to erase time
-      display.setCursor(10, 60);  // Adjust the position
-      display.print(F("Time: "));
-      display.print(lastHours);
-      display.print(F(":"));
-      if (minutes < 10) display.print(F("0"));
-      display.print(lastMinutes);
-      display.print(F(":"));
-      if (seconds < 10) display.print(F("0"));
-      display.print(lastSeconds);
-
-      lastHours = hours;
-      lastMinutes = minutes;
-      lastSeconds = seconds;
-      updateDisplay = true;
+void drawSettingsEdit() {
+  char line[TEXT_FIELD_MAX_CHARS + 1];
+  char value[12];
+
+  // Display the page of settings the cursor is on
+  int first = editIndex / SETTINGS_PER_PAGE * SETTINGS_PER_PAGE;
+  for (int row = 0; row < SETTINGS_PER_PAGE; row++) {
+    int i = first + row;
+    bool editing = i == editIndex && inEditMode;
+    // Highlight selected option
+    const char* cursor = (i == editIndex && !inEditMode) ? "> " : "  ";
+    int v = editing ? editValue : settingValue(i);
+
+    // Display setting name and value
+    switch (i) {
+      case SETTING_HIGH_TEMP:
+        if (editing) snprintf(value, sizeof(value), "%d", editValue);
+        else formatCentiC(value, sizeof(value), highTempAlert);
+        snprintf(line, sizeof(line), "%sHigh Temp: %s", cursor, value);
+        break;
+      case SETTING_LOW_TEMP:
+        if (editing) snprintf(value, sizeof(value), "%d", editValue);
+        else formatCentiC(value, sizeof(value), lowTempAlert);
+        snprintf(line, sizeof(line), "%sLow Temp: %s", cursor, value);
+        break;
+      case SETTING_TIME:
+        if (!inEditMode) {
+          snprintf(line, sizeof(line), "%sTime: %d:%02d:%02d", cursor, hours, minutes, seconds);
+        } else {
+          snprintf(line, sizeof(line), "%sTime: %d:%02d:%02d", cursor, local_hours, local_minutes, local_seconds);
+        }
+        break;
+      case SETTING_FAN_SETPOINT: snprintf(line, sizeof(line), "%sFan Set: %d C", cursor, v); break;
+      case SETTING_FAN_KP: snprintf(line, sizeof(line), "%sFan Kp: %d %%/C", cursor, v); break;
+      case SETTING_FAN_KI: snprintf(line, sizeof(line), "%sFan Ki: %d %%/C/h", cursor, v); break;
+      case SETTING_FAN_KD: snprintf(line, sizeof(line), "%sFan Kd: %d %%/(C/min)", cursor, v); break;
+      case SETTING_FAN_MIN_DUTY: snprintf(line, sizeof(line), "%sFan Min: %d %%", cursor, v); break;
+      case SETTING_FAN_HYSTERESIS: snprintf(line, sizeof(line), "%sFan Hyst: %d.%d C", cursor, v / 10, v % 10); break;
+      case SETTING_WARN_AHEAD:
+        if (v == 0) snprintf(line, sizeof(line), "%sWarn Ahead: off", cursor);
+        else snprintf(line, sizeof(line), "%sWarn Ahead: %d min", cursor, v);
+        break;
+      case SETTING_FAN_PRESTART: snprintf(line, sizeof(line), "%sFan Prestart: %s", cursor, v ? "on" : "off"); break;
+      case SETTING_FAN_AUTOTUNE:
+        switch (fanController.autotuneState()) {
+          case FanController::TUNE_RUNNING:
+            snprintf(value, sizeof(value), "%lus", (unsigned long)(fanController.autotuneElapsedMs() / 1000));
+            break;
+          case FanController::TUNE_DONE: snprintf(value, sizeof(value), "done"); break;
+          case FanController::TUNE_FAILED: snprintf(value, sizeof(value), "failed"); break;
+          default: snprintf(value, sizeof(value), "off"); break;
+        }
+        snprintf(line, sizeof(line), "%sAutotune: %s", cursor, value);
+        break;
+      default:
+        line[0] = 0;  // Past the last setting on the last page
+        break;
     }
+    settingsRowFields[row].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+  }
 
-    if (updateDisplay) {
-      // Write new temperature value
-      display.setCursor(10, 40);
-      // Set text color to white
-      display.setTextColor(ST7735_WHITE);
-      display.print(F("Temperature: "));
-      display.print(internalTemp);
+  // Display `_` indicator under the currently edited time field
+  for (int i = 0; i < 3; i++) {
+    bool marked = inEditMode && editIndex == SETTING_TIME && timeEditIndex == i;
+    settingsMarkFields[i].draw(display, marked ? "_" : "", ST7735_WHITE, ST77XX_ORANGE);
+  }
 
-      // Write new time value
-      display.setCursor(10, 60);  // Adjust the position
-      // Set text color to white
-      display.setTextColor(ST7735_WHITE);
-      display.print(F("Time: "));
-      display.print(hours);
-      display.print(F(":"));
-      if (minutes < 10) display.print(F("0"));
-      display.print(minutes);
-      display.print(F(":"));
-      if (seconds < 10) display.print(F("0"));
-      display.print(seconds);
-    }
-    delay(100); // Small delay to reduce CPU usage
+  // Position instructions below the menu
+  settingsHelpField.draw(display, inEditMode ? "<DOWN>  <SET>   <UP>" : "<BACK> <SELECT> <UP>",
+                         ST7735_WHITE, ST77XX_ORANGE);
+}
+
+// Value of a numeric setting in the units it is edited in
+int settingValue(int index) {
+  const FanTuning& t = fanController.tuning;
+  switch (index) {
+    case SETTING_HIGH_TEMP: return highTempAlert.degrees();
+    case SETTING_LOW_TEMP: return lowTempAlert.degrees();
+    case SETTING_FAN_SETPOINT: return t.setpointC;
+    case SETTING_FAN_KP: return t.kp;
+    case SETTING_FAN_KI: return t.ki;
+    case SETTING_FAN_KD: return t.kd;
+    case SETTING_FAN_MIN_DUTY: return t.minDutyPct;
+    case SETTING_FAN_HYSTERESIS: return t.hysteresisDeciC;
+    case SETTING_WARN_AHEAD: return tempPredictor.settings.horizonMin;
+    case SETTING_FAN_PRESTART: return tempPredictor.settings.fanPrestart;
   }
-  drawMenu();
+  return 0;
 }
 
-// Draw Settings Screen
-void drawSettingsEdit() {
-  bool inEditMode = false;  // Flag to track if we're in edit mode
-  int editValue = 0;        // Temporary variable to hold the value being edited
-  int editIndex = 0;        // Tracks the selected setting (0: High Temp, 1: Low Temp, 2: Time)
-  int timeEditIndex = 0;    // 0 = Hours, 1 = Minutes, 2 = Seconds (for time editing)
-  // Update time values
-  updateTime();
-  int local_hours = hours;
-  int local_minutes = minutes;
-  int local_seconds = seconds;
-
-  while (true) {
-    // Set the theme
-    setTheme();
-
-    display.setTextSize(1);
-    display.setTextColor(ST7735_WHITE);
-    display.setCursor(10, 10);
-    display.println(F("Edit Settings"));
-
-    // Display the settings options
-    int i = 0;
-    for (; i < 3; i++) {
-      display.setCursor(10, 30 + (i * MENU_ITEM_HEIGHT));
-
-      // Highlight selected option
-      if (i == editIndex && !inEditMode) {
-        display.print(F("> "));
-      } else {
-        display.print(F("  "));
-      }
+// Store an edited setting, fan values are kept within what the controller can use
+void setSettingValue(int index, int v) {
+  FanTuning& t = fanController.tuning;
+  switch (index) {
+    case SETTING_HIGH_TEMP: highTempAlert = CentiC::fromDegrees(v); break;
+    case SETTING_LOW_TEMP: lowTempAlert = CentiC::fromDegrees(v); break;
+    case SETTING_FAN_SETPOINT: t.setpointC = constrain(v, 0, 99); break;
+    case SETTING_FAN_KP: t.kp = constrain(v, 0, 255); break;
+    case SETTING_FAN_KI: t.ki = constrain(v, 0, 999); break;
+    case SETTING_FAN_KD: t.kd = constrain(v, 0, 255); break;
+    case SETTING_FAN_MIN_DUTY: t.minDutyPct = constrain(v, 0, 100); break;
+    case SETTING_FAN_HYSTERESIS: t.hysteresisDeciC = constrain(v, 0, 100); break;
+    case SETTING_WARN_AHEAD: tempPredictor.settings.horizonMin = constrain(v, 0, 60); break;
+    case SETTING_FAN_PRESTART: tempPredictor.settings.fanPrestart = constrain(v, 0, 1); break;
+  }
+}
 
-      // Display setting name and value
-      switch (i) {
-        case 0:
-          display.print(F("High Temp: "));
-          display.print(i == editIndex && inEditMode ? editValue : highTempAlert);
-          break;
-        case 1:
-          display.print(F("Low Temp: "));
-          display.print(i == editIndex && inEditMode ? editValue : lowTempAlert);
-          break;
-        case 2: {
-          if (!inEditMode) {
-            display.print(F("Time: "));
-            display.print(hours);
-            display.print(F(":"));
-            if (minutes < 10) display.print(F("0"));
-            display.print(minutes);
-            display.print(F(":"));
-            if (seconds < 10) display.print(F("0"));
-            display.println(seconds);
-          } else {
-            display.print(F("Time: "));
-            display.print(local_hours);
-            display.print(F(":"));
-            if (local_minutes < 10) display.print(F("0"));
-            display.print(local_minutes);
-            display.print(F(":"));
-            if (local_seconds < 10) display.print(F("0"));
-            display.println(local_seconds);
-
-            // Display `_` indicator under the currently edited time field
-            if (inEditMode && editIndex == 2) {
-              int xOffset = (timeEditIndex == 0) ? 56 : (timeEditIndex == 1) ? 75 : 95;
-              display.setCursor(xOffset, 53);
-              display.print(F("_"));
-            }
-          }
-          break;
-        }
-      }
+// Settings screen UP button
+void settingsEditUp() {
+  if (inEditMode) {
+    if (editIndex == SETTING_TIME) {
+      // Editing time fields
+      if (timeEditIndex == 0) local_hours = (local_hours + 1) % 24;  // Hours (0-23)
+      else if (timeEditIndex == 1) local_minutes = (local_minutes + 1) % 60;  // Minutes (0-59)
+      else local_seconds = (local_seconds + 1) % 60;  // Seconds (0-59)
+    } else {
+      editValue++;  // Increment other values
     }
+  } else {
+    editIndex = (editIndex - 1 + SETTINGS_COUNT) % SETTINGS_COUNT;  // Move up in menu
+  }
+}
 
-    display.setCursor(10, 100);  // Position instructions below the menu
-    display.print(inEditMode ? F("<DOWN>  <SET>   <UP>") : F("<BACK> <SELECT> <UP>"));
-
-    // Button handling
-    if (digitalRead(BTN_UP) == LOW) {
-      if (inEditMode) {
-        if (editIndex == 2) {
-          // Editing time fields
-          if (timeEditIndex == 0) local_hours = (local_hours + 1) % 24;  // Hours (0-23)
-          else if (timeEditIndex == 1) local_minutes = (local_minutes + 1) % 60;  // Minutes (0-59)
-          else local_seconds = (local_seconds + 1) % 60;  // Seconds (0-59)
-        } else {
-          editValue++;  // Increment other values
-        }
-      } else {
-        editIndex = (editIndex - 1 + 3) % 3;  // Move up in menu
-      }
-      delay(200);
-    }
+// Settings screen BACK button, returns false when the screen should be left
+bool settingsEditBack() {
+  if (!inEditMode) {
+    return false;  // Exit to the main menu
+  }
+  if (editIndex == SETTING_TIME) {
+    // Editing time fields
+    if (timeEditIndex == 0) local_hours = (local_hours - 1 + 24) % 24;
+    else if (timeEditIndex == 1) local_minutes = (local_minutes - 1 + 60) % 60;
+    else local_seconds = (local_seconds - 1 + 60) % 60;
+  } else {
+    editValue--;  // Decrement other values
+  }
+  return true;
+}
 
-    if (digitalRead(BTN_BACK) == LOW) {
-      if (inEditMode) {
-        if (editIndex == 2) {
-          // Editing time fields
-          if (timeEditIndex == 0) local_hours = (local_hours - 1 + 24) % 24;
-          else if (timeEditIndex == 1) local_minutes = (local_minutes - 1 + 60) % 60;
-          else local_seconds = (local_seconds - 1 + 60) % 60;
-        } else {
-          editValue--;  // Decrement other values
-        }
-      } else {
-        break;  // Exit the loop and return to the main menu
+// Settings screen SELECT button
+void settingsEditSelect() {
+  if (inEditMode) {
+    if (editIndex == SETTING_TIME) {
+      // Cycle between HH, MM, and SS when editing time
+      timeEditIndex++;
+      if (timeEditIndex > 2) { // End editing time after setting seconds
+        inEditMode = false;
+        timeEditIndex = 0;
+
+        // Set the local clock, the next NTP sync takes over again
+        localClock.setTimeOfDay(local_hours, local_minutes, local_seconds);
+        updateTime();
       }
-      delay(200);
+    } else {
+      // Save edited values and exit edit mode
+      setSettingValue(editIndex, editValue);
+      inEditMode = false;
     }
-
-    if (digitalRead(BTN_SELECT) == LOW) {
-      if (inEditMode) {
-        if (editIndex == 2) {
-          // Cycle between HH, MM, and SS when editing time
-          timeEditIndex++;
-          if (timeEditIndex > 2) { // End editing time after setting seconds
-            inEditMode = false;
-            hours = local_hours;
-            minutes = local_minutes;
-            seconds = local_seconds;
-            timeEditIndex = 0;
-
-            // Update startMillis to reflect the new manually set time
-            unsigned long totalSeconds = (hours * 3600) + (minutes * 60) + (seconds * 1);
-            startMillis = millis() - (totalSeconds * 1000); // Adjust startMillis
-            isTimeManuallySet = true; // Set the flag to indicate time has been manually set
-          }
-        } else {
-          // Save edited values and exit edit mode
-          if (editIndex == 0) highTempAlert = editValue;
-          if (editIndex == 1) lowTempAlert = editValue;
-          inEditMode = false;
-        }
-      } else {
-        // Enter edit mode for selected setting
-        inEditMode = true;
-        if (editIndex == 0) editValue = highTempAlert;
-        else if (editIndex == 1) editValue = lowTempAlert;
-        else {
-          // Initialize time editing
-          timeEditIndex = 0;
-          editValue = currentTime / 10000;
-        }
-      }
-      delay(200);
+  } else if (editIndex == SETTING_FAN_AUTOTUNE) {
+    // Start or cancel the step test, there is nothing to edit
+    if (fanController.autotuneState() == FanController::TUNE_RUNNING) fanController.cancelAutotune();
+    else fanController.startAutotune();
+  } else {
+    // Enter edit mode for selected setting
+    inEditMode = true;
+    if (editIndex != SETTING_TIME) editValue = settingValue(editIndex);
+    else {
+      // Initialize time editing
+      timeEditIndex = 0;
+      local_hours = hours;
+      local_minutes = minutes;
+      local_seconds = seconds;
     }
+  }
+}
 
-    // Exit if BACK is pressed and not in edit mode
-    if (digitalRead(BTN_BACK) == LOW && !inEditMode) {
-      break;
-    }
+// Chart Screen
+void enterChart() {
+  if (chartView == CHART_VIEW_LIVE) {
+    enterStripChart();
+    return;
+  }
 
-    yield(); // Allow the system to reset the watchdog timer
+  // Set the theme
+  setTheme();
+
+  display.setTextSize(1);
+  display.setTextColor(ST7735_WHITE);
+
+  // Draw X-axis (Time) labels: the age of the point under each, "0s" at the newest
+  const ChartViewLayout& view = chartViews[chartView];
+  char label[12];
+  for (int k = 0; k * view.tickPoints < view.points; k++) {
+    snprintf(label, sizeof(label), "%d%c", k * view.tickAge, view.unit);
+    int16_t bx, by;
+    uint16_t w, h;
+    display.getTextBounds(label, 0, 0, &bx, &by, &w, &h);
+    int x = CHART_X + (view.points - 1 - k * view.tickPoints) * view.spacing - w / 2;  // Centered on its point
+    display.setCursor(constrain(x, CHART_X, 160 - (int)w), CHART_TICK_Y);
+    display.print(label);
   }
 
-  currentMenu = HOME;
-  drawMenu();  // Return to main menu
+  // Draw the legend "C" at the top right corner
+  display.setCursor(160 - 10, 10);  // 10 pixels from the top and right edges
+  display.print(F("C"));
+
+  // Draw X and Y axis lines, the plot area inside them is blitted from chartBand
+  display.drawLine(27, 27, 27, 118, ST7735_WHITE);  // Y-axis line
+  display.drawLine(27, 110, 150, 110, ST7735_WHITE);  // X-axis line
+
+  chartTitleField.invalidate();
+  for (int i = 0; i < 3; i++) chartAxisFields[i].invalidate();
+  chartEmptyField.invalidate();
+  chartPlotDrawn = chartEmptyShown = false;
 }
 
-// Draw Chart Screen
 void drawChart() {
-  while (digitalRead(BTN_BACK) == HIGH) {
-    unsigned long startTime = millis();  // Record the start time for the X-axis
-    float timeStamps[20] = {0};         // Array to store timestamps for each temperature reading
-
-    while (digitalRead(BTN_BACK) == HIGH) {  // Exit when BACK button is pressed
-      // Update timestamps
-      for (int i = 0; i < 19; i++) {
-        timeStamps[i] = timeStamps[i + 1];  // Shift timestamps to the left
-      }
-      timeStamps[19] = (millis() - startTime) / 1000.0;  // Add new timestamp in seconds
+  static uint32_t plottedSamples = 0;  // Readings stored when the plot was drawn
+  char label[12];
 
-      // Calculate dynamic Y-axis limits
-      float minTemp = 100.0, maxTemp = -100.0;
-      for (int i = 0; i < 20; i++) {
-        if (tempHistory[i] < minTemp) minTemp = tempHistory[i];
-        if (tempHistory[i] > maxTemp) maxTemp = tempHistory[i];
-      }
-      // Add some padding to the Y-axis limits
-      minTemp = minTemp - 2.0;
-      maxTemp = maxTemp + 2.0;
+  if (chartView == CHART_VIEW_LIVE) {
+    drawStripChart();
+    return;
+  }
 
-      // Set the theme
-      setTheme();
+  const ChartViewLayout& view = chartViews[chartView];
+  chartTitleField.draw(display, view.name, ST7735_WHITE, ST77XX_ORANGE);
 
-      display.setTextSize(1);
-      display.setTextColor(ST7735_WHITE);
-      display.setCursor(10, 10);
-      display.println(F("Chart"));
-
-      // Draw Y-axis (Temperature) with labels and unit
-      display.setCursor(2, 30);
-      display.print(maxTemp, 1);  // Maximum temperature (1 decimal place)
-      display.setCursor(2, 70);
-      display.print((maxTemp + minTemp) / 2, 1);  // Middle temperature
-      display.setCursor(2, 110);
-      display.print(minTemp, 1);  // Minimum temperature
-
-      // Draw X-axis (Time) with steps of 5 seconds
-      for (int i = 0; i <= 20; i += 5) {
-        int x = 10 + i * 5;  // X position (time)
-        display.setCursor(x, 140);
-        display.println(i);  // Time label (0s, 5s, 10s, 15s, 20s)
-      }
+  // Redraw when a reading arrived, the rollups only change then (the 7d view when a block
+  // was written, its 6-hour points barely move per minute and each redraw reads the flash)
+  uint32_t stamp = tempHistory.totalPushed();
+#if FLASH_LOG_ENABLE
+  if (chartView == CHART_VIEW_7D) stamp = flashLog.blockWrites();
+#endif
+  if (tempHistory.empty() || ((chartPlotDrawn || chartEmptyShown) && plottedSamples == stamp)) return;
+  plottedSamples = stamp;
+  PROFILE_ZONE("chart");
+
+  // Collect the points of the view, right-aligned: raw readings or minute/hour buckets
+  static RollupBucket points[CHART_MAX_POINTS];  // Static, 1.2 KB is too much for the loop stack
+  int count = view.points, spacing = view.spacing;
+  if (chartView == CHART_VIEW_20S) {
+    int shown = min((int)tempHistory.size(), count);
+    for (int i = 0; i < count; i++) {
+      int k = i - (count - shown);  // Index among the shown readings, < 0 = none yet
+      points[i] = {};
+      if (k >= 0) points[i].add(tempHistory[tempHistory.size() - shown + k].value);
+    }
+#if FLASH_LOG_ENABLE
+  } else if (chartView == CHART_VIEW_7D) {
+    for (int i = 0; i < count; i++) points[i] = {};
+    uint32_t end = flashLogTime() + 1, span = FLASH_CHART_SLOT_S * FLASH_CHART_POINTS;
+    FlashChartSlots slots = { end > span ? end - span : 0, points };  // The last slot ends now
+    flashLog.query(slots.from, end, foldFlashChartRecord, &slots);
+#endif
+  } else {
+    int size = chartView == CHART_VIEW_1H ? tempMinutes.size() : tempHours.size();
+    for (int i = 0; i < count; i++) {
+      int k = i - (count - size);
+      points[i] = {};
+      if (k >= 0) points[i] = chartView == CHART_VIEW_1H ? tempMinutes[k] : tempHours[k];
+    }
+  }
 
-      // Draw X and Y axis lines
-      display.drawLine(27, 27, 27, 118, ST7735_WHITE);  // Y-axis line
-      display.drawLine(27, 110, 150, 110, ST7735_WHITE);  // X-axis line
-
-      // Draw the temperature graph
-      for (int i = 0; i < 19; i++) {
-        int x1 = 27 + i * 5;  // X position (time)
-        int y1 = map(tempHistory[i], minTemp, maxTemp, 118, 27);  // Y position (temperature)
-        int x2 = 27 + (i + 1) * 5;  // Next X position (time)
-        int y2 = map(tempHistory[i + 1], minTemp, maxTemp, 118, 27);  // Next Y position (temperature)
-
-        #if PLOT_STYLE_LINE
-        display.drawLine(x1, y1, x2, y2, ST7735_WHITE);  // Draw line between points
-        #else
-        display.drawPixel(x1, y1, ST7735_RED);  // Draw data point
-        #endif
-      }
+  // Y-axis limits over the points shown, the history's min/max spans far more than 20 s
+  RollupSummary range = {};  // The 24h and 7d views hold more readings than a bucket can count
+  for (int i = 0; i < count; i++) range.merge(points[i]);
+  if (range.count == 0) {
+    // Nothing in the span (the 7d view on a fresh device, or after the log was wiped):
+    // no scale to draw, a placeholder instead
+    for (int i = 0; i < 3; i++) chartAxisFields[i].draw(display, "", ST7735_WHITE, ST77XX_ORANGE);
+    if (chartPlotDrawn) display.fillRect(CHART_X, CHART_Y, CHART_W, CHART_H, ST77XX_ORANGE);
+    chartEmptyField.draw(display, "No data", ST7735_WHITE, ST77XX_ORANGE);
+    chartPlotDrawn = false;  // The next plot sends every band
+    chartEmptyShown = true;
+    return;
+  }
+  if (chartEmptyShown) {
+    chartEmptyField.invalidate();  // The plot bands cover it
+    chartEmptyShown = false;
+  }
+  // Add some padding to the Y-axis limits
+  CentiC minTemp = range.min - CentiC::fromDegrees(2);
+  CentiC maxTemp = range.max + CentiC::fromDegrees(2);
+
+  // Draw Y-axis (Temperature) labels (1 decimal place)
+  formatCentiC(label, sizeof(label), maxTemp, 1);
+  chartAxisFields[0].draw(display, label, ST7735_WHITE, ST77XX_ORANGE);  // Maximum temperature
+  formatCentiC(label, sizeof(label), centiMid(minTemp, maxTemp), 1);
+  chartAxisFields[1].draw(display, label, ST7735_WHITE, ST77XX_ORANGE);  // Middle temperature
+  formatCentiC(label, sizeof(label), minTemp, 1);
+  chartAxisFields[2].draw(display, label, ST7735_WHITE, ST77XX_ORANGE);  // Minimum temperature
+
+  // Map the points to plot rows (-1 = no data for that slot)
+  int16_t yMean[CHART_MAX_POINTS], yLow[CHART_MAX_POINTS], yHigh[CHART_MAX_POINTS];
+  for (int i = 0; i < count; i++) {
+    if (points[i].count == 0) {
+      yMean[i] = -1;
+      continue;
+    }
+    // map() is integer, on raw centi-degrees the scale keeps the readings' resolution
+    yMean[i] = map(points[i].mean().raw, minTemp.raw, maxTemp.raw, CHART_Y + CHART_H - 1, CHART_Y);  // Y position (temperature)
+    yLow[i] = map(points[i].min.raw, minTemp.raw, maxTemp.raw, CHART_Y + CHART_H - 1, CHART_Y);
+    yHigh[i] = map(points[i].max.raw, minTemp.raw, maxTemp.raw, CHART_Y + CHART_H - 1, CHART_Y);
+  }
+
+  unsigned long renderStart = micros();
+  uint32_t bytesBefore = display.spiBytes();
+
+  // Render the plot area one band at a time and blit each band in one transaction
+  for (int16_t band = 0; band < CHART_H; band += CHART_BAND_ROWS) {
+    int16_t rows = min(CHART_BAND_ROWS, CHART_H - band);
+    int16_t top = CHART_Y + band;  // Screen row of the first canvas row
+    chartBand.fillScreen(ST77XX_ORANGE);
+
+    // Draw the temperature graph
+    for (int i = 0; i < count; i++) {
+      if (yMean[i] < 0) continue;  // No data for this slot
+      int x1 = 28 + i * spacing - CHART_X;  // X position (time)
+
+      // Bucket range as a vertical bar behind the mean
+      if (yHigh[i] != yLow[i]) chartBand.drawFastVLine(x1, yHigh[i] - top, yLow[i] - yHigh[i] + 1, ST7735_WHITE);
+
+      #if PLOT_STYLE_LINE
+      int x2 = 28 + (i + 1) * spacing - CHART_X;  // Next X position (time)
+      if (i + 1 < count && yMean[i + 1] >= 0) chartBand.drawLine(x1, yMean[i] - top, x2, yMean[i + 1] - top, ST7735_WHITE);  // Draw line between points
+      #else
+      chartBand.drawPixel(x1, yMean[i] - top, ST7735_RED);  // Draw data point
+      #endif
+    }
+
+    // Skip bands that would send the same pixels again
+    uint32_t hash = 2166136261u;  // FNV-1a over the band
+    const uint16_t* pixels = chartBand.getBuffer();
+    for (int32_t p = 0; p < (int32_t)CHART_W * rows; p++) hash = (hash ^ pixels[p]) * 16777619u;
+    int index = band / CHART_BAND_ROWS;
+    if (chartPlotDrawn && hash == chartBandHash[index]) continue;
+    chartBandHash[index] = hash;
+    display.pushRect(CHART_X, top, CHART_W, rows, chartBand.getBuffer());
+  }
+  chartPlotDrawn = true;
+
+  chartRenderUs = micros() - renderStart;
+  chartRenderBytes = display.spiBytes() - bytesBefore;
+}
+
+// Chart Screen, strip-chart mode: one new column per reading, the controller scrolls the rest
+void enterStripChart() {
+  char label[12];
+
+  // Set the theme
+  setTheme();
 
-      // Draw the legend "C" at the top right corner
-      display.setCursor(160 - 10, 10);  // 10 pixels from the top and right edges
-      display.print(F("C"));
+  // Title, labels and axis live left of x = 28, outside the scroll area
+  display.setTextSize(1);
+  display.setTextColor(ST7735_WHITE);
+  display.setCursor(2, 10);
+  display.println(F("Live"));
+  display.drawLine(27, CHART_Y, 27, CHART_Y + CHART_H - 1, ST7735_WHITE);  // Y-axis line
+
+  // Fixed scale around the alert limits, scrolled-out columns cannot be rescaled
+  CentiC minTemp = lowTempAlert - CentiC::fromDegrees(5);
+  CentiC maxTemp = highTempAlert + CentiC::fromDegrees(5);
+  for (int i = 0; i < 3; i++) chartAxisFields[i].invalidate();
+  formatCentiC(label, sizeof(label), maxTemp, 1);
+  chartAxisFields[0].draw(display, label, ST7735_WHITE, ST77XX_ORANGE);  // Maximum temperature
+  formatCentiC(label, sizeof(label), centiMid(minTemp, maxTemp), 1);
+  chartAxisFields[1].draw(display, label, ST7735_WHITE, ST77XX_ORANGE);  // Middle temperature
+  formatCentiC(label, sizeof(label), minTemp, 1);
+  chartAxisFields[2].draw(display, label, ST7735_WHITE, ST77XX_ORANGE);  // Minimum temperature
+
+  stripChart.begin(CHART_X, 159, CHART_Y, CHART_Y + CHART_H - 1, minTemp, maxTemp, ST77XX_ORANGE);
+  stripChart.setJoinPoints(PLOT_STYLE_LINE);
+  stripChart.setLimits(lowTempAlert, highTempAlert, ST7735_WHITE);
+  // Start with as much history as fits, oldest first
+  uint16_t backfill = min((int)tempHistory.size(), 159 - CHART_X + 1);
+  chartStripSamples = tempHistory.totalPushed() - backfill;
+}
 
-      delay(100);  // Small delay to control update rate
-      yield(); // Allow the system to reset the watchdog timer
+void drawStripChart() {
+  // One column per new reading, a tick every 10 readings
+  while (chartStripSamples != tempHistory.totalPushed()) {
+    uint32_t behind = tempHistory.totalPushed() - chartStripSamples;  // Readings not drawn yet
+    if (behind > tempHistory.size()) {
+      chartStripSamples = tempHistory.totalPushed() - tempHistory.size();  // Overwritten before they were drawn
+      continue;
     }
+    chartStripSamples++;
+    stripChart.push(tempHistory[tempHistory.size() - behind].value, ST7735_RED, chartStripSamples % 10 == 0);
   }
-  drawMenu();
 }
 
-// Draw Trends Screen
+// Leaving the Chart screen: the menu expects normal addressing
+void leaveChart() {
+  stripChart.end();
+}
+
+// Trends Screen
+void enterTrends() {
+  // Set the theme
+  setTheme();
+
+  display.setTextSize(1);
+  display.setTextColor(ST7735_WHITE);
+  display.setCursor(10, 10);
+  display.println(F("Trends"));
+  for (TextField& field : trendFields) field.invalidate();
+}
+
 void drawTrends() {
-  while (digitalRead(BTN_BACK) == HIGH) {
-    // Set the theme
-    setTheme();
-
-    display.setTextSize(1);
-    display.setTextColor(ST7735_WHITE);
-    display.setCursor(10, 10);
-    display.println(F("Trends"));
-    display.setCursor(10, 30);
-    display.print(F("Peak Temp: "));
-    display.println(peakTemp);
-    display.setCursor(10, 50);
-    display.print(F("Lower Temp: "));
-    display.println(lowerTemp);
-    display.setCursor(10, 70);
-    display.print(F("Peak Crosses: "));
-    display.println(peakCrossCount);
+  char line[TEXT_FIELD_LINE_BUFFER];
+
+  char above[12], last[12];
+
+  // Everything here is kept up to date per reading (trendStats, peak and lower since boot),
+  // the screen only formats it
+  if (tempHistory.empty()) return;
+  snprintf(line, sizeof(line), "Peak: %s  Lower: %s", CentiText(peakTemp).str, CentiText(lowerTemp).str);
+  trendFields[0].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+  formatDuration(above, sizeof(above), trendStats.aboveMs());
+  formatDuration(last, sizeof(last), trendStats.lastCrossingMs());
+  snprintf(line, sizeof(line), "Crosses: %lu%s above %s last %s", (unsigned long)trendStats.crossings(),
+           trendStats.crossing() ? "+" : "", above, last);
+  trendFields[1].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+
+  // Last hour and day: min/mean/max and spread, percentiles, crossings
+  const TrendSummary* windows[2] = { &trendStats.hour(), &trendStats.day() };
+  static const char* const names[2] = { "1h", "24h" };
+  for (int w = 0; w < 2; w++) {
+    const TrendSummary& s = *windows[w];
+    snprintf(line, sizeof(line), "%s: %s / %s / %s sd %s", names[w], CentiText(s.min, 1).str, CentiText(s.mean, 1).str,
+             CentiText(s.max, 1).str, CentiText(s.stddev).str);
+    trendFields[2 + 3 * w].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+    snprintf(line, sizeof(line), "%s p50/95/99: %s / %s / %s", names[w], CentiText(s.p50, 1).str,
+             CentiText(s.p95, 1).str, CentiText(s.p99, 1).str);
+    trendFields[3 + 3 * w].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+    formatDuration(above, sizeof(above), s.aboveMs);
+    snprintf(line, sizeof(line), "%s: %u crosses, %s above", names[w], s.crossings, above);
+    trendFields[4 + 3 * w].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
   }
-  drawMenu();
+
+#if FLASH_LOG_ENABLE
+  snprintf(line, sizeof(line), "7d: %s / %s / %s", CentiText(weekSummary.min, 1).str,
+           CentiText(weekSummary.mean(), 1).str, CentiText(weekSummary.max, 1).str);
+  trendFields[8].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+#endif
+}
+
+// Alerts Screen
+void enterAlerts() {
+  // Set the theme
+  setTheme();
+
+  display.setTextSize(1);
+  display.setCursor(10, 0);
+  display.println(F("Alerts"));
+  alertField.invalidate();
+  for (TextField& field : predictFields) field.invalidate();
+  alertPageField.invalidate();
+  for (TextField& field : alertEventFields) field.invalidate();
+  alertPage = 0;
+  alertListDrawn = false;
+}
+
+// Alerts screen UP: next (older) page of events, back to the newest after the last
+bool alertsInput(const ButtonEvent& event) {
+  if (event.button != SCREEN_KEY_UP || event.type != BUTTON_PRESS) return false;
+  uint16_t pages = (alertEngine.eventCount() + ALERT_EVENT_ROWS - 1) / ALERT_EVENT_ROWS;
+  alertPage = pages > 1 ? (alertPage + 1) % pages : 0;
+  alertListDrawn = false;
+  return true;
 }
 
-// Draw Alerts Screen
 void drawAlerts() {
-  while (digitalRead(BTN_BACK) == HIGH) {
-    // Set the theme
-    setTheme();
-
-    display.setTextSize(1);
-    display.setCursor(10, 0);
-    display.println(F("Alerts"));
-    if (internalTemp > highTempAlert) {
-      display.println(F("High Temp Alert!"));
+  char line[TEXT_FIELD_MAX_CHARS + 1];
+  char eta[12];
+
+  if (alertEngine.activeCount() > 0) {
+    // The most severe active rule by name, and how many there are
+    uint8_t shown = 0;
+    for (uint8_t i = 0; i < alertEngine.ruleCount(); i++) {
+      if (alertEngine.active(i) && (!alertEngine.active(shown) ||
+                                    alertEngine.rule(i).severity > alertEngine.rule(shown).severity)) {
+        shown = i;
+      }
+    }
+    if (alertEngine.activeCount() > 1) {
+      snprintf(line, sizeof(line), "%s Alert! (+%u)", alertEngine.rule(shown).name, alertEngine.activeCount() - 1);
     } else {
-      display.println(F("No Alerts"));
+      snprintf(line, sizeof(line), "%s Alert!", alertEngine.rule(shown).name);
     }
+    alertField.draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+  } else if (tempPredictor.warning()) {
+    alertField.draw(display, fanController.prestarted() ? "Early Warning! Fan prestarted" : "Early Warning!",
+                    ST7735_WHITE, ST77XX_ORANGE);
+  } else {
+    alertField.draw(display, "No Alerts", ST7735_WHITE, ST77XX_ORANGE);
   }
-  drawMenu();
-}
 
-void drawDiagnostics() {
-  int fanState = 0;  // 0 = \, 1 = /, 2 = |, 3 = -
-  while (digitalRead(BTN_BACK) == HIGH) {
-    // Set the theme
-    setTheme();
-
-    display.setTextSize(1);
-    display.setTextColor(ST7735_WHITE);
-    display.setCursor(10, 10);
-    display.println(F("Diagnostics"));
-    display.println(F(" "));
-    display.println(F("-> Power: ON"));
-    display.print(F("-> Blower:"));
-    
-    // Fan rotation logic
-    if (FAN_STATUS == SET) {
-      display.print(F(" ON"));
-      switch(fanState) {
-        case 0:
-          display.print(F(" \\"));
-          break;
-        case 1:
-          display.print(F(" /"));
-          break;
-        case 2:
-          display.print(F(" |"));
-          break;
-        case 3:
-          display.print(F(" -"));
-          break;
-      }
-      fanState = (fanState + 1) % 4;  // Loop through 0, 1, 2, 3
-      display.println("");
+  // Prediction: fitted rate and level, then when the high alert would be reached
+  if (!tempPredictor.ready()) {
+    predictFields[0].draw(display, "Rate: collecting readings", ST7735_WHITE, ST77XX_ORANGE);
+    predictFields[1].draw(display, "", ST7735_WHITE, ST77XX_ORANGE);
+  } else {
+    CentiC rate = tempPredictor.ratePerMin();
+    snprintf(line, sizeof(line), "Rate: %s%s C/min  fit %s", rate.raw > 0 ? "+" : "", CentiText(rate).str,
+             CentiText(tempPredictor.level()).str);
+    predictFields[0].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+    int32_t seconds = tempPredictor.etaSeconds(highTempAlert);
+    if (seconds < 0) {
+      snprintf(line, sizeof(line), "%s C: not approaching", CentiText(highTempAlert, 1).str);
     } else {
-      display.println(F(" OFF"));
+      formatDuration(eta, sizeof(eta), (uint32_t)seconds * 1000);
+      snprintf(line, sizeof(line), "%s C in %s", CentiText(highTempAlert, 1).str, eta);
     }
-    display.print(F("-> Over Temp: "));
-    
-    // Fan rotation logic
-    if (FAN_STATUS == SET) {
-      display.print(F(" True"));
-    } else {
-      display.println(F(" False"));
+    predictFields[1].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+  }
+  if (tempPredictor.settings.horizonMin == 0) {
+    snprintf(line, sizeof(line), "Early warning off");
+  } else {
+    snprintf(line, sizeof(line), "Warn %u min ahead, %lu raised", tempPredictor.settings.horizonMin,
+             (unsigned long)tempPredictor.warnings());
+  }
+  predictFields[2].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+
+  // Event list, only formatted again when an event was logged or the page changed
+  if (alertListDrawn && alertShownEvents == alertEngine.eventsLogged()) return;
+  alertListDrawn = true;
+  alertShownEvents = alertEngine.eventsLogged();
+  uint16_t stored = alertEngine.eventCount();
+  uint16_t first = alertPage * ALERT_EVENT_ROWS;
+  if (first >= stored) first = alertPage = 0;
+  if (stored == 0) {
+    snprintf(line, sizeof(line), "No events");
+  } else {
+    snprintf(line, sizeof(line), "Events %u-%u of %u%s", first + 1, min(first + ALERT_EVENT_ROWS, (int)stored),
+             stored, stored > ALERT_EVENT_ROWS ? "  <UP> older" : "");
+  }
+  alertPageField.draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+  // Event times are the clock's time of day (uptime until it is set)
+  uint64_t now = localClock.monotonicMs();
+  int64_t wallOffset = (int64_t)(localClock.wallMs() - now);
+  for (uint8_t row = 0; row < ALERT_EVENT_ROWS; row++) {
+    if (first + row >= stored) {
+      alertEventFields[row].draw(display, "", ST7735_WHITE, ST77XX_ORANGE);
+      continue;
     }
+    const AlertEvent& event = alertEngine.event(first + row);
+    const AlertRule& rule = alertEngine.rule(event.rule);
+    uint64_t at = now - (uint32_t)((uint32_t)now - event.timestampMs);  // The 32-bit stamp, extended
+    uint32_t second = (uint32_t)((at + wallOffset) / 1000 % 86400);
+    snprintf(line, sizeof(line), "%02lu:%02lu:%02lu %c %s %s %s", (unsigned long)(second / 3600),
+             (unsigned long)(second / 60 % 60), (unsigned long)(second % 60),
+             rule.severity == ALERT_CRITICAL ? '!' : rule.severity == ALERT_WARNING ? '*' : ' ', rule.name,
+             event.raised ? "on" : "off", CentiText(event.value).str);
+    alertEventFields[row].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+  }
+}
+
+// Diagnostics Screen
+unsigned long diagDrawMillis = 0;  // Redrawn once per second for the rotation effect and the counters
+#if PROFILE_ENABLE
+bool diagProfilePage = false;      // UP switches between the status page and the profiling zones
+#endif
+
+void enterDiagnostics() {
+  // Set the theme
+  setTheme();
 
-    delay(1000);  // Delay for rotation effect
+  display.setTextSize(1);
+  display.setTextColor(ST7735_WHITE);
+  display.setCursor(10, 10);
+#if PROFILE_ENABLE
+  if (diagProfilePage) {
+    display.println(F("Profile"));
+    display.println(F(" "));
+    display.println(F("-> zone: avg/max/p95 us, calls"));
+    for (int i = 0; i < SCHEDULER_MAX_TASKS; i++) diagTaskFields[i] = TextField(0, 28 + i * 6, &TomThumb);
+    display.setCursor(0, 90);
+    display.println(F("<UP> page <SELECT> dump, hold: reset"));
+    return;
   }
-  drawMenu();
+#endif
+  display.println(F("Diagnostics"));
+  display.println(F(" "));
+  display.println(F("-> Power: ON"));
+
+  // Dynamic lines start below the power line, 6 px apart (TomThumb line height)
+  for (int i = 0; i < 7; i++) diagFields[i] = TextField(0, 28 + i * 6, &TomThumb);
+  for (int i = 0; i < SCHEDULER_MAX_TASKS; i++) diagTaskFields[i] = TextField(0, 76 + i * 6, &TomThumb);
 }
 
-void Tool_bar(Menu choice) {
-  // Set Cursor to last line of screen
-  display.setCursor(0, 10 + (((VISIBLE_MENU_ITEMS - 1)) * MENU_ITEM_HEIGHT));  
-  switch (choice) {
-    case 1:
-      // Home
-      display.print(F("<BACK>"));
-      break;
-    case 2:
-      // settings
-      display.print(F("<BACK>"));
-      break;
-    case 3:
-      // Chart
-      break;
-    case 4:
-      // trends
-      display.print(F("<BACK>"));
-      break;
-    case 5:
-      // alert
-      display.print(F("<BACK>"));
-      break;
-    case 6:
-      // diagnostics    
-      display.print(F("<BACK>          <UP>"));
-      break;
-    case 7:
-      // about
-      display.print(F("<BACK>"));
-      break;
+bool updateDiagnostics() {
+  return millis() - diagDrawMillis >= 1000;
+}
+
+void drawDiagnostics() {
+  static int fanState = 0;  // 0 = \, 1 = /, 2 = |, 3 = -
+  const char fanGlyphs[] = "\\/|-";
+  char line[TEXT_FIELD_LINE_BUFFER];
+
+  diagDrawMillis = millis();
+#if PROFILE_ENABLE
+  if (diagProfilePage) {
+    drawProfileZones();
+    return;
+  }
+#endif
+
+  // Fan rotation logic
+  if (FAN_STATUS == SET) {
+    snprintf(line, sizeof(line), "-> Blower: %u%% %c starts: %lu", (fanController.duty() + 5) / 10,
+             fanGlyphs[fanState], (unsigned long)fanController.starts());
+    fanState = (fanState + 1) % 4;  // Loop through 0, 1, 2, 3
+  } else {
+    snprintf(line, sizeof(line), "-> Blower: OFF starts: %lu", (unsigned long)fanController.starts());
+  }
+  diagFields[0].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+  bool overTemp = !tempHistory.empty() && tempHistory.newest().value > highTempAlert;
+  diagFields[1].draw(display, overTemp ? "-> Over Temp:  True" : "-> Over Temp:  False",
+                     ST7735_WHITE, ST77XX_ORANGE);
+
+#if BUTTON_ENABLE
+  snprintf(line, sizeof(line), "-> Events lost: %lu key: %lu lag: %lums", (unsigned long)timerEvents.dropped(),
+           (unsigned long)buttons.droppedEdges(), (unsigned long)buttons.maxLatencyMs());
+#else
+  snprintf(line, sizeof(line), "-> Events lost: %lu", (unsigned long)timerEvents.dropped());
+#endif
+  diagFields[2].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+  snprintf(line, sizeof(line), "-> NTP syncs: %lu fails: %lu",
+           (unsigned long)localClock.syncs(), (unsigned long)localClock.failures());
+  diagFields[3].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+  snprintf(line, sizeof(line), "-> Frame: %luus %luB", (unsigned long)screenFrameUs, (unsigned long)spiFrameBytes);
+  diagFields[4].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+  snprintf(line, sizeof(line), "-> Chart: %luus %luB", (unsigned long)chartRenderUs, (unsigned long)chartRenderBytes);
+  diagFields[5].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+  snprintf(line, sizeof(line), "-> Log drops: %lu repeats: %lu", (unsigned long)logger.dropped(), (unsigned long)logger.suppressed());
+  diagFields[6].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+
+  // Task statistics: average/max runtime in us, overruns and late starts
+  for (uint8_t i = 0; i < scheduler.taskCount(); i++) {
+    const SchedulerTask& task = scheduler.task(i);
+    snprintf(line, sizeof(line), "-> %s: %lu/%luus ovr %lu late %lu", task.name,
+             task.runCount ? (unsigned long)(task.totalRunUs / task.runCount) : 0UL,
+             (unsigned long)task.maxRunUs, (unsigned long)task.overrunCount,
+             (unsigned long)task.lateCount);
+    diagTaskFields[i].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
   }
 }
 
-// Draw About Screen
-void drawAbout() {
+#if PROFILE_ENABLE
+// Profiling zones: average, max and 95th percentile (histogram bucket bound) in us, call count
+void drawProfileZones() {
+  char line[TEXT_FIELD_LINE_BUFFER];
+  uint32_t mhz = ESP.getCpuFreqMHz();
+  for (uint8_t i = 0; i < profiler.zoneCount() && i < SCHEDULER_MAX_TASKS; i++) {
+    const ProfileZone& z = profiler.entry(i);
+    snprintf(line, sizeof(line), "-> %s: %lu/%lu/%lu us, %lu", z.name,
+             z.calls ? (unsigned long)(z.totalCycles / z.calls / mhz) : 0UL, (unsigned long)(z.maxCycles / mhz),
+             (unsigned long)(profiler.percentileCycles(i, 95) / mhz), (unsigned long)z.calls);
+    diagTaskFields[i].draw(display, line, ST7735_WHITE, ST77XX_ORANGE);
+  }
+}
+#endif
+
+// Diagnostics screen buttons: UP switches pages, on the profile page SELECT dumps the zones
+// to the serial port and holding it clears them
+bool diagnosticsInput(const ButtonEvent& event) {
+#if PROFILE_ENABLE
+  if (event.button == SCREEN_KEY_UP && event.type == BUTTON_PRESS) {
+    diagProfilePage = !diagProfilePage;
+    screens.restart();
+    return true;
+  }
+  if (diagProfilePage && event.button == SCREEN_KEY_SELECT && event.type == BUTTON_PRESS) {
+    profiler.startDump();
+    return true;
+  }
+  if (diagProfilePage && event.button == SCREEN_KEY_SELECT && event.type == BUTTON_LONG) {
+    profiler.reset();
+    return true;
+  }
+#endif
+  return false;
+}
+
+// About Screen, all static
+void enterAbout() {
   // Set the theme
   setTheme();
 
@@ -984,14 +1471,19 @@ void drawAbout() {
   display.println(F("Developer: Afsal Lais"));
   display.setCursor(10, 70);
   display.println(F("Version: 1.0.3"));
-  display.setCursor(10, 90);
-  while (digitalRead(BTN_BACK) == HIGH) 
-  {
-    Tool_bar(ABOUT);
-    delay(100);
-  }    
-  drawMenu();
 }
+
+// Menu entries in order: name, button hints, enter, render, update, input, leave
+extern const ScreenDef screenTable[] = {
+  { "Home", "<BACK>", enterHome, drawHome, nullptr, nullptr, nullptr },
+  { "Settings", nullptr, enterSettingsEdit, drawSettingsEdit, nullptr, settingsInput, nullptr },
+  { "Chart", nullptr, enterChart, drawChart, nullptr, chartInput, leaveChart },
+  { "Trends", nullptr, enterTrends, drawTrends, nullptr, nullptr, nullptr },
+  { "Alerts", nullptr, enterAlerts, drawAlerts, nullptr, alertsInput, nullptr },
+  { "Diagnostics", nullptr, enterDiagnostics, drawDiagnostics, updateDiagnostics, diagnosticsInput, nullptr },
+  { "About", "<BACK>", enterAbout, nullptr, nullptr, nullptr, nullptr },
+};
+extern const uint8_t screenCount = sizeof(screenTable) / sizeof(screenTable[0]);
 #endif
 #endif
 
@@ -999,80 +1491,78 @@ void drawAbout() {
 // Self-test function to check hardware components
 
 void selfTest() {
-  Serial.println("Starting self-test...");
+  LOG_INFO("Starting self-test...");
 
   // Test LEDs
 #if LED_ENABLE
-  Serial.println("Testing LEDs...");
+  LOG_INFO("Testing LEDs...");
   for (int i = 0; i < numLEDs; i++) {
-    Serial.print("Testing LED ");
-    Serial.println(i);
+    LOG_INFO("Testing LED %d", i);
     pinMode(leds[i].pin, OUTPUT);
-    Serial.print("Configured LED pin: ");
-    Serial.println(leds[i].pin);
+    LOG_INFO("Configured LED pin: %d", leds[i].pin);
     digitalWrite(leds[i].pin, HIGH);
     delay(500);
     digitalWrite(leds[i].pin, LOW);
     delay(500);
   }
-  Serial.println("LED test completed.");
+  LOG_INFO("LED test completed.");
+  logger.drain(Serial);
 #endif
 
   // Test Buttons
 #if BUTTON_ENABLE
-  Serial.println("Testing buttons...");
+  LOG_INFO("Testing buttons...");
   pinMode(BTN_UP, INPUT);
-  Serial.println("BTN_UP configured.");
+  LOG_INFO("BTN_UP configured.");
   delay(10);
 
   pinMode(BTN_SELECT, INPUT);
-  Serial.println("BTN_SELECT configured.");
+  LOG_INFO("BTN_SELECT configured.");
   delay(10);
 
   pinMode(BTN_BACK, INPUT);
-  Serial.println("BTN_BACK configured.");
+  LOG_INFO("BTN_BACK configured.");
   delay(10);
 
   if (digitalRead(BTN_UP) == LOW) {
-    Serial.println("BTN_UP is pressed.");
+    LOG_INFO("BTN_UP is pressed.");
   }
   if (digitalRead(BTN_SELECT) == LOW) {
-    Serial.println("BTN_SELECT is pressed.");
+    LOG_INFO("BTN_SELECT is pressed.");
   }
   if (digitalRead(BTN_BACK) == LOW) {
-    Serial.println("BTN_BACK is pressed.");
+    LOG_INFO("BTN_BACK is pressed.");
   }
-  Serial.println("Button test completed.");
+  LOG_INFO("Button test completed.");
+  logger.drain(Serial);
 #endif
 
   // Test Buzzer
 #if ENABLE_BUZZER
-  Serial.println("Testing buzzer...");
+  LOG_INFO("Testing buzzer...");
   int buzzerPin = 5; // Define the buzzer pin
   tone(buzzerPin, 1000, 500); // 1kHz tone for 500ms
   delay(500);
   noTone(buzzerPin);
-  Serial.println("Buzzer test completed.");
+  LOG_INFO("Buzzer test completed.");
   delay(10);
 #endif
 
   // Test Analog Read
-  Serial.println("Testing analog read...");
+  LOG_INFO("Testing analog read...");
   int sensorValue = analogRead(A0);
-  Serial.print("Analog read value: ");
-  Serial.println(sensorValue);
-  Serial.println("Analog read test completed.");
+  LOG_INFO("Analog read value: %d", sensorValue);
+  LOG_INFO("Analog read test completed.");
   delay(10);
-  Serial.print("Free Heap: ");  
-  Serial.println(ESP.getFreeHeap());
+  LOG_INFO("Free Heap: %lu", (unsigned long)ESP.getFreeHeap());
   // Test Display
-  Serial.println("Testing display...");
+  LOG_INFO("Testing display...");
   display.initR(INITR_BLACKTAB);      // Init ST7735S chip, black tab
   // Set the rotation of the display
   display.setRotation(3);
   display.fillScreen(ST77XX_BLACK);
   display.setColRowStartOffset(4, 2); // Use the derived class method
-  Serial.println("Display initialization completed.");
+  LOG_INFO("Display initialization completed.");
 
   display.fillScreen(0xFD20);
   delay(10);
@@ -1081,33 +1571,29 @@ void selfTest() {
   display.setCursor(10, 10);
   display.println("Display Test");
   delay(10);
-  Serial.println("Display test completed.");
+  LOG_INFO("Display test completed.");
 
-  Serial.println("Self-test completed.");
+  LOG_INFO("Self-test completed.");
+  logger.drain(Serial);
 }
 
 void connectToWiFi() {
   int attempt = 3;
  
-  Serial.println("Connecting to WiFi...");
+  LOG_INFO("Connecting to WiFi...");
   WiFi.begin(ssid, password);
 
   // Wait for the connection to establish
   while (WiFi.status() != WL_CONNECTED && attempt > 0) {
     delay(500);
-    Serial.print(".");
     attempt--;
   }
   
-  Serial.println();
   if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("WiFi connected.");
-    Serial.print("IP address: ");
-    Serial.println(WiFi.localIP());
-    // Initialize NTP Client
-    timeClient.begin();
+    LOG_INFO("WiFi connected.");
+    LOG_INFO("IP address: %s", WiFi.localIP().toString().c_str());
   } else {
-    Serial.println("Failed to connect to WiFi.");
+    LOG_WARN("Failed to connect to WiFi.");
   }
 }
 
@@ -1115,7 +1601,7 @@ void connectToWiFi() {
 void setup() {
   Serial.setDebugOutput(true);
   Serial.begin(115200);
-  Serial.println("System initialization started.");
+  LOG_INFO("System initialization started.");
   SPI.begin();  // Initialize SPI
   SPI.setFrequency(40000000);  // Set SPI speed to 80 MHz
 
@@ -1126,30 +1612,50 @@ void setup() {
   selfTest();
 
   display.setColRowStartOffset(4, 2); // Use the derived class method
-  Serial.println("Display setup completed.");
+  LOG_INFO("Display setup completed.");
 
 #if ENABLE_BUZZER
   //pinMode(buzzerPin, OUTPUT); // Set buzzer pin as out
   //Serial.println("Buzzer setup completed.");
 #endif
-  // Initialize NTP Client
-  timeClient.begin();
-  if (timeClient.update()) { // Update time if necessary
-    // Get time in IST
-    timeClient.setTimeOffset(19800); // IST is UTC+5:30 Hrs.
-    timeClient.update();
-    Serial.print("Current Time: ");
-    Serial.print(timeClient.getFormattedTime());
-    Serial.println(" (IST)");
+  // Socket for the NTP answers
+  ntpUDP.begin(NTP_LOCAL_PORT);
+  // Start the local clock, the first update() sends the initial NTP request
+  localClock.begin(ntpSync);
+  updateTime();
+
+#if FLASH_LOG_ENABLE
+  // History from earlier runs; LittleFS formats a flash it cannot mount
+  if (LittleFS.begin() && flashLog.begin(LittleFS)) {
+    FlashLogRecord last;
+    if (flashLog.last(last)) {
+      flashLogBase = last.time;
+      trendStats.restoreCrossings(last.crossings);  // The count carries on across restarts
+    }
+    updateWeekSummary();
+    LOG_INFO("Flash log: %u segments, %lu blocks, %lu torn blocks cut", flashLog.segments(),
+             (unsigned long)flashLog.storedBlocks(), (unsigned long)flashLog.recoveredBlocks());
   } else {
-    Serial.println("Failed to update time");
+    LOG_ERROR("Flash log: file system not available");
   }
+#endif
+
+  alertEngine.begin(alertRules, sizeof(alertRules) / sizeof(alertRules[0]));
+
+  // Fan PWM, off until the first reading
+  analogWriteRange(FAN_PWM_RANGE);
+  analogWriteFreq(FAN_PWM_FREQ);
+  pinMode(FAN_PWM_PIN, OUTPUT);
+  analogWrite(FAN_PWM_PIN, 0);
 
 #if BUTTON_ENABLE
   pinMode(BTN_UP, INPUT_PULLUP);
   pinMode(BTN_SELECT, INPUT_PULLUP);
   pinMode(BTN_BACK, INPUT_PULLUP);
-  Serial.println("Button pins configured.");
+  attachInterrupt(digitalPinToInterrupt(BTN_UP), upEdgeIsr, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(BTN_SELECT), selectEdgeIsr, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(BTN_BACK), backEdgeIsr, CHANGE);
+  LOG_INFO("Button pins configured.");
 #endif
 
 #if LED_ENABLE
@@ -1157,17 +1663,27 @@ void setup() {
   for (int i = 0; i < numLEDs; i++) {
     pinMode(leds[i].pin, OUTPUT);
   }
-  Serial.println("LED pins configured.");
+  LOG_INFO("LED pins configured.");
 #endif
 
 #if ENABLE_BUZZER
   buzzer_sciFiStartup();
-  Serial.println("System startup sound played.");
+  LOG_INFO("System startup sound played.");
 #endif
 
   // Attach the timerISR function to run every 1000 milliseconds
   Timer1.attach_ms(1000, interrupt_Handler);
-  Serial.println("Timer interrupt attached.");
+  LOG_INFO("Timer interrupt attached.");
+
+  // Register the loop tasks (name, callback, period, runtime budget)
+  scheduler.addTask("sample", sampleTask, SAMPLE_PERIOD_MS, 5000);
+  scheduler.addTask("clock", clockTask, CLOCK_PERIOD_MS, 5000);
+  scheduler.addTask("log", logTask, LOG_PERIOD_MS, 1000);
+#if BUTTON_ENABLE
+  scheduler.addTask("button", buttonTask, BUTTON_PERIOD_MS, 2000);
+  scheduler.addTask("screen", screenTask, SCREEN_PERIOD_MS, 50000);
+#endif
+  LOG_INFO("Scheduler tasks registered.");
 
 #if LED_ENABLE
   // Turn on power status led
@@ -1181,86 +1697,126 @@ void setup() {
   setTheme();
 
   // Draw menu
-  drawMenu();
-  Serial.println("System initialization completed.");
+#if BUTTON_ENABLE
+  screens.begin();
+#endif
+  LOG_INFO("System initialization completed.");
+  logger.drain(Serial);
 }
 
-void drawMenu() {
-    int visibleMenuItems = VISIBLE_MENU_ITEMS; // Number of items visible at a time
-    const char* menuItems[7] = { "Home", "Settings", "Chart", "Trends", "Alerts", "Diagnostics", "About" };
-
-    // Adjust start_index based on currentMenu
-    if ((int)currentMenu >= (start_index + visibleMenuItems)) {
-        start_index++;
-    } else if ((int)currentMenu < start_index) {
-        start_index = 0;
-    }
-
-    // Ensure start_index stays within bounds
-    if (start_index < 0) {
-        start_index = 0;
-    } else if (start_index > 7) {
-        start_index = 0;
-    } else if (start_index + visibleMenuItems > 7) {
-        start_index = 7 - visibleMenuItems;
-    }
-
-    display.fillScreen(ST77XX_ORANGE); // Fill the entire screen with the background color
-    display.setTextSize(1);
-    display.setTextColor(ST7735_WHITE);
-    display.setCursor(10, 10);
-    display.print("MENU:");
-
-    int i = start_index;
-    for (int cursor_index = 0; cursor_index < visibleMenuItems; cursor_index++, i++) {
-        if (i >= 0 && i < 7) { // Ensure index is within bounds
-            display.setCursor(10, 30 + (cursor_index * MENU_ITEM_HEIGHT));
-
-            if (i == (int)currentMenu) {
-                display.print("> "); // Highlight the current menu item
-            } else {
-                display.print("  ");
-            }
-
-            display.print(menuItems[i]); // Use char* menu items
-        }
+// Sampling task: handle the ticks queued by interrupt_Handler()
+void sampleTask() {
+  TimerEvent event;
+  while (timerEvents.pop(event)) {
+    switch (event.type) {
+      case EVENT_SAMPLE:
+        lastSampleMillis = event.timestampMs;
+        // Read Temperature
+        readTemperature();
+#if LED_ENABLE
+        // Update LED's
+        updateLEDs();
+#endif
+        break;
     }
+  }
 }
 
-void loop() {
-  delay(10);
-  // Update the time from the NTP server
+// Clock task: update hours/minutes/seconds
+void clockTask() {
+  int lastSeconds = seconds;
   updateTime();
+#if BUTTON_ENABLE
+  if (seconds != lastSeconds) screens.markDirty();  // Uptime and clock fields moved on
+#endif
+}
 
-  
-  static unsigned long lastUpdate = 0;
-  unsigned long currentMillis = millis();
-
-  // Read temperature every second
-  if (currentMillis - lastUpdate > 1000) {
-    lastUpdate = currentMillis;
-    readTemperature(); // Ensure temperature is read periodically
+// Log task: send what fits in the UART FIFO, never waits for it
+void logTask() {
+#if PROFILE_ENABLE
+  // 'p' on the serial port dumps the profiling zones, a line per run while the queue has room
+  while (Serial.available() > 0) {
+    if (Serial.read() == 'p') profiler.startDump();
   }
+  char line[LOG_LINE_MAX];
+  if (logger.queued() < LOG_QUEUE_DEPTH / 2 && profiler.dumpLine(line, sizeof(line))) LOG_INFO("%s", line);
+#endif
+  logger.drain(Serial);
+}
 
 #if BUTTON_ENABLE
-  // Handle button presses
-  if (digitalRead(BTN_UP) == LOW) {
-     handleUp(); delay(200); 
+// Button interrupts: timestamp the edge, the button task does the rest (buttons are active low)
+void IRAM_ATTR upEdgeIsr() { buttons.edge(SCREEN_KEY_UP, digitalRead(BTN_UP) == LOW, millis()); }
+void IRAM_ATTR selectEdgeIsr() { buttons.edge(SCREEN_KEY_SELECT, digitalRead(BTN_SELECT) == LOW, millis()); }
+void IRAM_ATTR backEdgeIsr() { buttons.edge(SCREEN_KEY_BACK, digitalRead(BTN_BACK) == LOW, millis()); }
+
+// Button task: debounce the queued edges and act on the resulting events
+void buttonTask() {
+  buttons.poll(millis(), onButton);
+}
+
+void onButton(const ButtonEvent& event) {
+  switch (event.type) {
+    case BUTTON_PRESS:
+      // Act on the press itself, a held button fires once
+      LOG_DEBUG("Button %u pressed", event.button);
+#if ENABLE_BUZZER
+      if (event.button == SCREEN_KEY_UP) buzzer_buttonClick();
+      if (event.button == SCREEN_KEY_SELECT) buzzer_select();
+      if (event.button == SCREEN_KEY_BACK) buzzer_back();
+#endif
+      screens.handle(event);
+      break;
+    case BUTTON_REPEAT:
+      // Holding UP keeps stepping, the Settings screen also repeats BACK while editing
+      screens.handle(event);
+      break;
+    case BUTTON_LONG:
+      LOG_DEBUG("Button %u held", event.button);
+      screens.handle(event);
+      break;
+    case BUTTON_COMBO:
+      LOG_WARN("Entering OTA update mode...");
+      logger.flush(Serial);
+      enterOTAUpdateMode();
+      break;
+    default:
+      break;
   }
-  if (digitalRead(BTN_SELECT) == LOW) {
-     handleSelect(); 
-     delay(200);
+}
+
+// Screen task: draw what changed on the open screen or the menu and measure what it sent
+void screenTask() {
+  static uint32_t windowBytes = 0, windowFrames = 0; // SPI bytes and frames in the current second
+  static uint32_t windowUs = 0;                      // Frame time in the current second
+  static unsigned long windowStart = 0;
+  uint32_t before = display.spiBytes();
+  unsigned long frameStart = micros();
+  if (screens.tick()) {
+    windowUs += micros() - frameStart;
+    windowBytes += display.spiBytes() - before;
+    windowFrames++;
   }
-  if (digitalRead(BTN_BACK) == LOW) {
-    handleBack();
-    delay(200); 
+  if (millis() - windowStart >= 1000) {
+    spiFrameBytes = windowFrames ? windowBytes / windowFrames : 0;
+    screenFrameUs = windowFrames ? windowUs / windowFrames : 0;
+    windowBytes = 0;
+    windowUs = 0;
+    windowFrames = 0;
+    windowStart = millis();
   }
+}
 #endif
-  
-  checkSerialForOTAUpdate();
+
+void loop() {
+  // Run whichever tasks are due, nothing in here blocks
+  scheduler.run();
 }
 
 void enterOTAUpdateMode() {
+#if FLASH_LOG_ENABLE
+  flashLog.flush();  // The update ends in a restart, keep the queued records
+#endif
   unsigned long startMillis = millis();
   unsigned long currentMillis;
   int countdown = 30;
@@ -1299,18 +1855,4 @@ void enterOTAUpdateMode() {
   // ArduinoOTA.handle();
 }
 
-void checkSerialForOTAUpdate() {
-  /*if (Serial.available() > 0) {
-    String command = Serial.readStringUntil('\n');
-    command.trim(); // Remove any leading/trailing whitespace
 
-    if (command.equalsIgnoreCase("OTA_UPDATE")) {
-      Serial.println("Entering OTA update mode...");
-      enterOTAUpdateMode();
-    }
-  }*/
- if(digitalRead(BTN_UP) == LOW && digitalRead(BTN_SELECT) == LOW && digitalRead(BTN_BACK) == LOW) {
-    Serial.println("Entering OTA update mode...");
-    enterOTAUpdateMode();
-  }
-}
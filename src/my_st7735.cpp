@@ -0,0 +1,95 @@
+/*
+ * ST7735 driver subclass
+ * See my_st7735.h. The library's primitives do not call each other through the virtual
+ * table, so each transfer is counted exactly once.
+ */
+#include "my_st7735.h"
+
+void MyST7735::countRect(int16_t x, int16_t y, int16_t w, int16_t h) {
+  // Clip the same way the library does before it opens the address window
+  if (w < 0) { x += w + 1; w = -w; }
+  if (h < 0) { y += h + 1; h = -h; }
+  int16_t x2 = x + w - 1, y2 = y + h - 1;
+  if (w == 0 || h == 0 || x >= width() || y >= height() || x2 < 0 || y2 < 0) return;
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x2 >= width()) x2 = width() - 1;
+  if (y2 >= height()) y2 = height() - 1;
+  spiByteCount += ST7735_WINDOW_BYTES + (uint32_t)(x2 - x + 1) * (y2 - y + 1) * 2;
+}
+
+void MyST7735::pushRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t* pixels) {
+  // The caller keeps the block on screen, no clipping here
+  spiByteCount += ST7735_WINDOW_BYTES + (uint32_t)w * h * 2;
+  startWrite();
+  setAddrWindow(x, y, w, h);
+  writePixels(pixels, (uint32_t)w * h);
+  endWrite();
+}
+
+void MyST7735::setScrollArea(int16_t x0, int16_t x1) {
+  // Rotation 3 (MX | MV): screen x is RAM row 161 - (x + _xstart), the right edge comes first
+  uint16_t tfa = ST7735_RAM_ROWS - 1 - (x1 + _xstart);
+  uint16_t vsa = x1 - x0 + 1;
+  uint16_t bfa = ST7735_RAM_ROWS - tfa - vsa;
+  uint8_t data[6] = { (uint8_t)(tfa >> 8), (uint8_t)tfa, (uint8_t)(vsa >> 8), (uint8_t)vsa,
+                      (uint8_t)(bfa >> 8), (uint8_t)bfa };
+  sendCommand(ST77XX_VSCRDEF, data, 6);
+  spiByteCount += 7;
+  scrollTop = tfa;
+}
+
+void MyST7735::setScrollOffset(uint16_t offset) {
+  uint16_t ssa = scrollTop + offset;
+  uint8_t data[2] = { (uint8_t)(ssa >> 8), (uint8_t)ssa };
+  sendCommand(ST77XX_VSCRSADD, data, 2);
+  spiByteCount += 3;
+}
+
+void MyST7735::resetScroll() {
+  uint8_t data[6] = { 0, 0, 0, ST7735_RAM_ROWS, 0, 0 };
+  sendCommand(ST77XX_VSCRDEF, data, 6);
+  scrollTop = 0;
+  setScrollOffset(0);
+  spiByteCount += 7;
+}
+
+void MyST7735::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  countRect(x, y, 1, 1);
+  Adafruit_ST7735::drawPixel(x, y, color);
+}
+
+void MyST7735::writePixel(int16_t x, int16_t y, uint16_t color) {
+  countRect(x, y, 1, 1);
+  Adafruit_ST7735::writePixel(x, y, color);
+}
+
+void MyST7735::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  countRect(x, y, w, h);
+  Adafruit_ST7735::fillRect(x, y, w, h, color);
+}
+
+void MyST7735::writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  countRect(x, y, w, h);
+  Adafruit_ST7735::writeFillRect(x, y, w, h, color);
+}
+
+void MyST7735::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  countRect(x, y, w, 1);
+  Adafruit_ST7735::drawFastHLine(x, y, w, color);
+}
+
+void MyST7735::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  countRect(x, y, 1, h);
+  Adafruit_ST7735::drawFastVLine(x, y, h, color);
+}
+
+void MyST7735::writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  countRect(x, y, w, 1);
+  Adafruit_ST7735::writeFastHLine(x, y, w, color);
+}
+
+void MyST7735::writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  countRect(x, y, 1, h);
+  Adafruit_ST7735::writeFastVLine(x, y, h, color);
+}
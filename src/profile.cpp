@@ -0,0 +1,73 @@
+/*
+ * Profiling zones
+ * See profile.h for the macro and the histogram buckets.
+ */
+#include "profile.h"
+
+#if PROFILE_ENABLE
+
+Profiler profiler;
+
+uint8_t Profiler::zone(const char* name) {
+  for (uint8_t i = 0; i < count; i++) {
+    if (strcmp(zones[i].name, name) == 0) return i;
+  }
+  if (count == PROFILE_MAX_ZONES) return PROFILE_NO_ZONE;
+  zones[count] = {};
+  zones[count].name = name;
+  return count++;
+}
+
+void Profiler::record(uint8_t id, uint32_t cycles) {
+  if (id >= count) return;
+  ProfileZone& z = zones[id];
+  z.calls++;
+  z.totalCycles += cycles;
+  if (cycles > z.maxCycles) z.maxCycles = cycles;
+  int bits = cycles ? 32 - __builtin_clz(cycles) : 0;  // Bit length, floor(log2) + 1
+  int bucket = bits - PROFILE_HIST_MIN_BITS;
+  if (bucket < 0) bucket = 0;
+  if (bucket >= PROFILE_HIST_BUCKETS) bucket = PROFILE_HIST_BUCKETS - 1;
+  z.hist[bucket]++;
+}
+
+void Profiler::reset() {
+  for (uint8_t i = 0; i < count; i++) {
+    const char* name = zones[i].name;
+    zones[i] = {};
+    zones[i].name = name;
+  }
+}
+
+uint32_t Profiler::percentileCycles(uint8_t id, uint8_t percent) const {
+  const ProfileZone& z = zones[id];
+  uint64_t wanted = ((uint64_t)z.calls * percent + 99) / 100, seen = 0;
+  for (int i = 0; i < PROFILE_HIST_BUCKETS - 1; i++) {
+    seen += z.hist[i];
+    if (seen >= wanted) return 1UL << (i + PROFILE_HIST_MIN_BITS);
+  }
+  return z.maxCycles;  // In the open-ended last bucket
+}
+
+bool Profiler::dumpLine(char* line, size_t size) {
+  if (dumpNext < 0) return false;
+  if (dumpNext == 0) {
+    snprintf(line, size, "prof: %u zones, bucket i = under 2^(i+%d) cycles at %u MHz", count, PROFILE_HIST_MIN_BITS,
+             (unsigned)ESP.getCpuFreqMHz());
+    dumpNext = count ? 1 : -1;
+    return true;
+  }
+
+  // name calls avg/max us, then the histogram as bucket:count for the non-empty buckets
+  const ProfileZone& z = zones[dumpNext - 1];
+  dumpNext = dumpNext == count ? -1 : dumpNext + 1;
+  uint32_t mhz = ESP.getCpuFreqMHz();
+  int n = snprintf(line, size, "prof %s n%lu %lu/%luus", z.name, (unsigned long)z.calls,
+                   z.calls ? (unsigned long)(z.totalCycles / z.calls / mhz) : 0UL, (unsigned long)(z.maxCycles / mhz));
+  for (int i = 0; i < PROFILE_HIST_BUCKETS && n > 0 && (size_t)n < size; i++) {
+    if (z.hist[i]) n += snprintf(line + n, size - n, " %d:%lu", i, (unsigned long)z.hist[i]);
+  }
+  return true;
+}
+
+#endif
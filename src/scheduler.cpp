@@ -0,0 +1,74 @@
+/*
+ * Cooperative task scheduler
+ * See scheduler.h. Deadlines advance by exactly one period so that a task keeps a fixed
+ * cadence; a task that falls a whole period behind is re-phased instead of bursting.
+ */
+#include "scheduler.h"
+
+int Scheduler::addTask(const char* name, TaskCallback callback, uint32_t periodMs, uint32_t budgetUs) {
+  if (count >= SCHEDULER_MAX_TASKS || callback == nullptr) {
+    return -1;  // Table full or nothing to run
+  }
+
+  SchedulerTask& t = tasks[count];
+  memset(&t, 0, sizeof(t));
+  t.name = name;
+  t.callback = callback;
+  t.periodMs = periodMs;
+  t.budgetUs = budgetUs;
+  t.nextRunMs = millis();  // First run on the next tick
+  t.enabled = true;
+  return count++;
+}
+
+void Scheduler::setEnabled(int id, bool enabled) {
+  if (id < 0 || id >= count) return;
+  if (enabled && !tasks[id].enabled) {
+    tasks[id].nextRunMs = millis();  // Run as soon as it is re-enabled
+  }
+  tasks[id].enabled = enabled;
+}
+
+void Scheduler::run() {
+  ticks++;
+
+  for (uint8_t i = 0; i < count; i++) {
+    SchedulerTask& t = tasks[i];
+    if (!t.enabled) continue;
+
+    uint32_t now = millis();
+    if (t.periodMs != 0 && (int32_t)(now - t.nextRunMs) < 0) continue;  // Not due yet
+
+    uint32_t startUs = micros();
+    t.callback();
+    uint32_t elapsedUs = micros() - startUs;
+
+    // Runtime statistics
+    t.runCount++;
+    t.lastRunUs = elapsedUs;
+    t.totalRunUs += elapsedUs;
+    if (elapsedUs > t.maxRunUs) t.maxRunUs = elapsedUs;
+    if (t.budgetUs != 0 && elapsedUs > t.budgetUs) t.overrunCount++;
+
+    // Schedule the next deadline
+    if (t.periodMs != 0) {
+      t.nextRunMs += t.periodMs;
+      if ((int32_t)(millis() - t.nextRunMs) >= 0) {
+        t.lateCount++;  // Missed a whole period, re-phase rather than run back to back
+        t.nextRunMs = millis() + t.periodMs;
+      }
+    }
+  }
+}
+
+void Scheduler::resetStats() {
+  for (uint8_t i = 0; i < count; i++) {
+    SchedulerTask& t = tasks[i];
+    t.runCount = 0;
+    t.overrunCount = 0;
+    t.lateCount = 0;
+    t.lastRunUs = 0;
+    t.maxRunUs = 0;
+    t.totalRunUs = 0;
+  }
+}
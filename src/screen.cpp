@@ -0,0 +1,125 @@
+/*
+ * Screen framework
+ * See screen.h for the hooks and when they run.
+ */
+#include "screen.h"
+#include "profile.h"
+
+void ScreenManager::begin() {
+  for (uint8_t i = 0; i < SCREEN_MENU_ROWS; i++) menuRows[i] = TextField(10, SCREEN_MENU_TOP + i * SCREEN_MENU_ROW_HEIGHT, font);
+  hintField = TextField(0, SCREEN_HINT_Y, font);
+  enterMenu();
+}
+
+bool ScreenManager::tick() {
+  if (!isOpen()) {
+    if (menuValid && cursor == shownCursor && firstRow == shownFirst) {
+      skipCount++;
+      return false;
+    }
+    PROFILE_ZONE("menu");
+    // Only the rows whose text changed: both cursor rows, or all of them after a scroll
+    bool scrolled = !menuValid || firstRow != shownFirst;
+    for (uint8_t row = 0; row < SCREEN_MENU_ROWS; row++) {
+      uint8_t entry = firstRow + row;
+      if (scrolled || entry == cursor || entry == shownCursor) drawMenuRow(row);
+    }
+    shownCursor = cursor;
+    shownFirst = firstRow;
+    menuValid = true;
+    renderCount++;
+    return true;
+  }
+
+  const ScreenDef& s = screens[openIndex];
+  if (s.update && s.update()) dirty = true;
+  if (!dirty) {
+    skipCount++;
+    return false;
+  }
+  dirty = false;
+  PROFILE_ZONE("frame");
+  if (s.render) s.render();
+  renderCount++;
+  return true;
+}
+
+void ScreenManager::handle(const ButtonEvent& event) {
+  if (event.type != BUTTON_PRESS && event.type != BUTTON_REPEAT) {
+    if (isOpen() && screens[openIndex].input && screens[openIndex].input(event)) {
+      dirty = true;
+      tick();
+    }
+    return;
+  }
+  if (isOpen()) {
+    const ScreenDef& s = screens[openIndex];
+    if (s.input && s.input(event)) {
+      dirty = true;
+      tick();  // Answer the press now, not on the next screen tick
+    } else if (event.button == SCREEN_KEY_BACK && event.type == BUTTON_PRESS) {
+      close();
+    }
+    return;
+  }
+
+  // Menu: UP steps down the list (wrapping), SELECT opens, BACK returns to the top
+  if (event.button == SCREEN_KEY_UP) {
+    cursor = (cursor + 1) % count;
+  } else if (event.type != BUTTON_PRESS) {
+    return;
+  } else if (event.button == SCREEN_KEY_SELECT) {
+    open(cursor);
+    return;
+  } else if (event.button == SCREEN_KEY_BACK) {
+    cursor = 0;
+  }
+  // Keep the cursor inside the visible window
+  if (cursor < firstRow) firstRow = cursor;
+  if (cursor >= firstRow + SCREEN_MENU_ROWS) firstRow = cursor - SCREEN_MENU_ROWS + 1;
+  tick();
+}
+
+void ScreenManager::open(uint8_t index) {
+  if (index >= count) return;
+  openIndex = index;
+  restart();
+}
+
+void ScreenManager::restart() {
+  if (!isOpen()) return;
+  const ScreenDef& s = screens[openIndex];
+  s.enter();
+  hintField.invalidate();
+  if (s.hint) hintField.draw(gfx, s.hint, color, bg);
+  // First frame right away, not on the next tick
+  if (s.render) s.render();
+  renderCount++;
+  dirty = false;
+}
+
+void ScreenManager::close() {
+  if (!isOpen()) return;
+  if (screens[openIndex].leave) screens[openIndex].leave();
+  openIndex = -1;
+  enterMenu();
+}
+
+void ScreenManager::enterMenu() {
+  gfx.fillScreen(bg);
+  gfx.setFont(font);
+  gfx.setTextSize(1);
+  gfx.setTextColor(color);
+  gfx.setCursor(10, 10);
+  gfx.print("MENU:");
+  for (uint8_t i = 0; i < SCREEN_MENU_ROWS; i++) menuRows[i].invalidate();
+  menuValid = false;
+  tick();  // Draw the rows now, the menu shows up together with its title
+}
+
+void ScreenManager::drawMenuRow(uint8_t row) {
+  char line[TEXT_FIELD_MAX_CHARS + 1] = "";
+  uint8_t entry = firstRow + row;
+  if (entry < count) snprintf(line, sizeof(line), "%s%s", entry == cursor ? "> " : "  ", screens[entry].name);
+  menuRows[row].draw(gfx, line, color, bg);
+}
@@ -0,0 +1,90 @@
+/*
+ * Bit-packed time series codes
+ * See series_codec.h for the code tables.
+ */
+#include "series_codec.h"
+
+static const uint8_t timeWidths[3] = { 7, 9, 12 };
+static const uint8_t valueWidths[3] = { 6, 8, 12 };
+
+static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+void BitWriter::put(uint32_t value, uint8_t bits) {
+  while (bits > 0) {
+    uint8_t used = pos & 7, room = 8 - used, take = bits < room ? bits : room;
+    uint8_t chunk = (uint8_t)((value >> (bits - take)) & ((1u << take) - 1));
+    uint8_t& byte = data[pos >> 3];
+    if (used == 0) byte = 0;  // First bits of this byte, clear what an earlier block left
+    byte |= chunk << (room - take);
+    pos += take;
+    bits -= take;
+  }
+}
+
+uint32_t BitReader::get(uint8_t bits) {
+  uint32_t value = 0;
+  while (bits > 0) {
+    uint8_t used = pos & 7, room = 8 - used, take = bits < room ? bits : room;
+    uint8_t chunk = (uint8_t)((data[pos >> 3] >> (room - take)) & ((1u << take) - 1));
+    value = (value << take) | chunk;
+    pos += take;
+    bits -= take;
+  }
+  return value;
+}
+
+static uint8_t codeLength(uint32_t z, const uint8_t* widths) {
+  if (z == 0) return 1;
+  for (uint8_t i = 0; i < 3; i++) {
+    if (z < (1u << widths[i])) return i + 2 + widths[i];
+  }
+  return 4 + 32;
+}
+
+static void putCode(BitWriter& out, uint32_t z, const uint8_t* widths) {
+  if (z == 0) {
+    out.put(0, 1);
+    return;
+  }
+  for (uint8_t i = 0; i < 3; i++) {
+    if (z < (1u << widths[i])) {
+      out.put((1u << (i + 2)) - 2, i + 2);  // i + 1 ones and a zero
+      out.put(z, widths[i]);
+      return;
+    }
+  }
+  out.put(15, 4);
+  out.put(z, 32);
+}
+
+static uint32_t getCode(BitReader& in, const uint8_t* widths) {
+  uint8_t ones = 0;
+  while (ones < 4 && in.get(1)) ones++;
+  if (ones == 0) return 0;
+  return in.get(ones < 4 ? widths[ones - 1] : 32);
+}
+
+uint8_t timeCodeLength(int32_t change) { return codeLength(zigzag(change), timeWidths); }
+void putTimeCode(BitWriter& out, int32_t change) { putCode(out, zigzag(change), timeWidths); }
+int32_t getTimeCode(BitReader& in) { return unzigzag(getCode(in, timeWidths)); }
+
+uint8_t valueCodeLength(int32_t change) { return codeLength(zigzag(change), valueWidths); }
+void putValueCode(BitWriter& out, int32_t change) { putCode(out, zigzag(change), valueWidths); }
+int32_t getValueCode(BitReader& in) { return unzigzag(getCode(in, valueWidths)); }
+
+bool seriesAppend(BitWriter& out, SeriesPoint& last, uint32_t time, int32_t value) {
+  int32_t step = (int32_t)(time - last.time);
+  int32_t stepChange = seriesChange(step, last.step), valueChange = seriesChange(value, last.value);
+  if (!out.fits(timeCodeLength(stepChange) + valueCodeLength(valueChange))) return false;
+  putTimeCode(out, stepChange);
+  putValueCode(out, valueChange);
+  last = { time, step, value };
+  return true;
+}
+
+void seriesNext(BitReader& in, SeriesPoint& last) {
+  last.step = seriesApply(last.step, getTimeCode(in));
+  last.time += (uint32_t)last.step;
+  last.value = seriesApply(last.value, getValueCode(in));
+}
@@ -0,0 +1,76 @@
+/*
+ * Scrolling strip chart
+ * See strip_chart.h. A column is top..bottom plus the tick rows, sent as one 1-pixel-wide
+ * address window: 11 + 2 * rows bytes per value, whatever the chart width.
+ */
+#include "strip_chart.h"
+
+void StripChart::begin(int16_t x0, int16_t x1, int16_t top, int16_t bottom, CentiC minValue, CentiC maxValue, uint16_t bg) {
+  this->x0 = x0;
+  this->x1 = x1;
+  this->top = top;
+  this->bottom = bottom;
+  if (bottom - top + 1 + STRIP_CHART_TICK_ROWS > (int16_t)(sizeof(column) / sizeof(column[0]))) {
+    this->bottom = top + (sizeof(column) / sizeof(column[0])) - STRIP_CHART_TICK_ROWS - 1;
+  }
+  this->minValue = minValue.raw;
+  this->maxValue = maxValue > minValue ? maxValue.raw : minValue.raw + 1;
+  this->bg = bg;
+  lowRow = highRow = -1;
+  lastRow = -1;
+  offset = 0;
+  pushed = 0;
+
+  tft.fillRect(x0, 0, x1 - x0 + 1, tft.height(), bg);
+  tft.setScrollArea(x0, x1);
+  tft.setScrollOffset(0);
+  running = true;
+}
+
+void StripChart::setLimits(CentiC low, CentiC high, uint16_t color) {
+  lowRow = rowFor(low);
+  highRow = rowFor(high);
+  limitColor = color;
+}
+
+int16_t StripChart::rowFor(CentiC value) const {
+  int32_t span = maxValue - minValue;
+  int32_t scaled = (value.raw - minValue) * (bottom - top);
+  int16_t row = bottom - (int16_t)((scaled < 0 ? scaled - span / 2 : scaled + span / 2) / span);  // Rounded
+  if (row < top) row = top;
+  if (row > bottom) row = bottom;
+  return row;
+}
+
+void StripChart::push(CentiC value, uint16_t color, bool tick) {
+  if (!running) return;
+  int16_t rows = bottom - top + 1 + STRIP_CHART_TICK_ROWS;
+  for (int16_t i = 0; i < rows; i++) column[i] = bg;
+
+  // Limits are dashed: every other column
+  if (pushed & 1) {
+    if (lowRow >= 0) column[lowRow - top] = limitColor;
+    if (highRow >= 0) column[highRow - top] = limitColor;
+  }
+  if (tick) {
+    for (int16_t i = 0; i < STRIP_CHART_TICK_ROWS; i++) column[bottom - top + 1 + i] = ST77XX_WHITE;
+  }
+
+  int16_t row = rowFor(value);
+  int16_t from = (joinPoints && lastRow >= 0) ? lastRow : row;  // Vertical segment from the previous value
+  for (int16_t r = min(from, row); r <= max(from, row); r++) column[r - top] = color;
+  lastRow = row;
+
+  // Scroll one column left: the RAM column that was on the far left becomes the right edge
+  int16_t width = x1 - x0 + 1;
+  offset = (offset + width - 1) % width;
+  tft.pushRect(x1 - offset, top, 1, rows, column);
+  tft.setScrollOffset(offset);
+  pushed++;
+}
+
+void StripChart::end() {
+  if (!running) return;
+  tft.resetScroll();
+  running = false;
+}
@@ -0,0 +1,161 @@
+/*
+ * Binary telemetry frames
+ * See telemetry.h for the frame layout.
+ */
+#include "telemetry.h"
+
+static uint8_t* putVarint(uint8_t* p, uint32_t v) {
+  while (v >= 0x80) {
+    *p++ = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  *p++ = (uint8_t)v;
+  return p;
+}
+
+// Returns nullptr if the varint runs past end or is longer than 5 bytes
+static const uint8_t* getVarint(const uint8_t* p, const uint8_t* end, uint32_t& v) {
+  v = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    if (p >= end) return nullptr;
+    uint8_t b = *p++;
+    v |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) return p;
+  }
+  return nullptr;
+}
+
+static uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+uint16_t telemetryCrc16(const uint8_t* data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  while (length--) {
+    crc ^= (uint16_t)*data++ << 8;
+    for (int i = 0; i < 8; i++) crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+  }
+  return crc;
+}
+
+size_t cobsEncode(const uint8_t* in, size_t length, uint8_t* out) {
+  uint8_t* code = out;  // Where the length of the current run goes
+  uint8_t* p = out + 1;
+  uint8_t run = 1;
+  for (size_t i = 0; i < length; i++) {
+    if (in[i] == 0) {
+      *code = run;
+      code = p++;
+      run = 1;
+    } else {
+      *p++ = in[i];
+      if (++run == 0xFF) {
+        *code = run;
+        code = p++;
+        run = 1;
+      }
+    }
+  }
+  *code = run;
+  return p - out;
+}
+
+size_t cobsDecode(const uint8_t* in, size_t length, uint8_t* out) {
+  const uint8_t* end = in + length;
+  uint8_t* p = out;
+  while (in < end) {
+    uint8_t run = *in++;
+    if (run == 0 || in + run - 1 > end) return 0;
+    for (uint8_t i = 1; i < run; i++) {
+      if (*in == 0) return 0;
+      *p++ = *in++;
+    }
+    if (run != 0xFF && in < end) *p++ = 0;
+  }
+  return p - out;
+}
+
+size_t TelemetryEncoder::encode(const TelemetrySample& sample, uint8_t* out) {
+  uint8_t payload[TELEMETRY_PAYLOAD_MAX];
+  bool key = sent % TELEMETRY_KEYFRAME_EVERY == 0;
+  uint8_t* p = payload;
+  *p++ = (uint8_t)(((key ? TELEMETRY_TYPE_KEY : TELEMETRY_TYPE_DELTA) << 5) | (sample.flags & 0x1F));
+  *p++ = (uint8_t)sent;  // Sequence number, lets the decoder spot lost frames
+  if (key) {
+    p = putVarint(p, sample.timestampMs);
+    p = putVarint(p, sample.adcQ4);
+    p = putVarint(p, zigzag(sample.centiC));
+  } else {
+    p = putVarint(p, sample.timestampMs - prev.timestampMs);
+    p = putVarint(p, zigzag((int32_t)sample.adcQ4 - (int32_t)prev.adcQ4));
+    p = putVarint(p, zigzag(sample.centiC - prev.centiC));
+  }
+  uint16_t crc = telemetryCrc16(payload, p - payload);
+  *p++ = (uint8_t)crc;
+  *p++ = (uint8_t)(crc >> 8);
+
+  prev = sample;
+  sent++;
+  out[0] = 0;  // Ends whatever text came before
+  size_t n = 1 + cobsEncode(payload, p - payload, out + 1);
+  out[n++] = 0;
+  return n;
+}
+
+TelemetryDecoder::Result TelemetryDecoder::feed(uint8_t byte, TelemetrySample& sample) {
+  if (byte != 0) {
+    if (chunkLength < sizeof(chunk)) chunk[chunkLength++] = byte;
+    else oversized = true;
+    return NONE;
+  }
+  Result result = NONE;
+  if (oversized) {
+    // Longer than any frame: a text line, not worth counting
+  } else if (chunkLength > 0) {
+    result = decodeChunk(sample);
+  }
+  chunkLength = 0;
+  oversized = false;
+  return result;
+}
+
+TelemetryDecoder::Result TelemetryDecoder::decodeChunk(TelemetrySample& sample) {
+  uint8_t payload[TELEMETRY_FRAME_MAX];
+  size_t n = cobsDecode(chunk, chunkLength, payload);
+  if (n < 5 || telemetryCrc16(payload, n - 2) != (uint16_t)(payload[n - 2] | payload[n - 1] << 8)) {
+    bad++;
+    return BAD;
+  }
+  uint8_t type = payload[0] >> 5;
+  uint8_t seq = payload[1];
+  const uint8_t* p = payload + 2;
+  const uint8_t* end = payload + n - 2;
+  uint32_t a, b, c;
+  if ((type != TELEMETRY_TYPE_KEY && type != TELEMETRY_TYPE_DELTA) ||
+      !(p = getVarint(p, end, a)) || !(p = getVarint(p, end, b)) || !(p = getVarint(p, end, c)) || p != end) {
+    bad++;
+    return BAD;
+  }
+
+  if (synced && seq != nextSeq) {
+    lost += (uint8_t)(seq - nextSeq);
+    synced = false;
+  }
+  nextSeq = seq + 1;
+  if (type == TELEMETRY_TYPE_KEY) {
+    sample.timestampMs = a;
+    sample.adcQ4 = (uint16_t)b;
+    sample.centiC = unzigzag(c);
+  } else if (synced) {
+    sample.timestampMs = prev.timestampMs + a;
+    sample.adcQ4 = (uint16_t)(prev.adcQ4 + unzigzag(b));
+    sample.centiC = prev.centiC + unzigzag(c);
+  } else {
+    skipped++;
+    return SKIPPED;
+  }
+  sample.flags = payload[0] & 0x1F;
+  prev = sample;
+  synced = true;
+  samples++;
+  return SAMPLE;
+}
@@ -0,0 +1,104 @@
+/*
+ * Over-temperature prediction
+ * See temp_predictor.h.
+ */
+#include "temp_predictor.h"
+
+static_assert(PREDICT_TAU_S >= 1 && PREDICT_TAU_S <= PREDICT_MAX_TAU_S, "PREDICT_TAU_S out of range");
+
+// x * PREDICT_DECAY_Q16, rounded
+static inline int64_t decayed(int64_t x) {
+  return (x * PREDICT_DECAY_Q16 + (1L << (PREDICT_WEIGHT_BITS - 1))) >> PREDICT_WEIGHT_BITS;
+}
+
+// n / d rounded to nearest, d > 0
+static inline int64_t divRounded(int64_t n, int64_t d) {
+  return n < 0 ? (n - d / 2) / d : (n + d / 2) / d;
+}
+
+bool TempPredictor::update(uint32_t timestampMs, CentiC value, CentiC limit) {
+  int32_t y = value.raw;
+  if (samples > 0) {
+    // Whole seconds, lastMs keeps the remainder so jitter does not add up
+    uint32_t elapsed = timestampMs - lastMs;
+    int32_t step;
+    if (elapsed >= PREDICT_MAX_STEP_S * 1000UL) {
+      step = PREDICT_MAX_STEP_S;
+      lastMs = timestampMs;
+    } else {
+      step = (int32_t)((elapsed + 500) / 1000);
+      lastMs += (uint32_t)step * 1000;
+    }
+    // Move the origin to the new reading: t -> t - step, y -> y - (y_new - y_ref)
+    int32_t dy = y - reference;
+    stt += step * (step * s0 - 2 * st);
+    st -= step * s0;
+    sty -= step * sy;
+    sy -= dy * s0;
+    sty -= dy * st;
+    // Older readings weigh less, once per second
+    for (int32_t i = 0; i < step; i++) {
+      s0 = decayed(s0);
+      st = decayed(st);
+      stt = decayed(stt);
+      sy = decayed(sy);
+      sty = decayed(sty);
+    }
+  } else {
+    lastMs = timestampMs;
+  }
+  reference = y;
+  s0 += 1L << PREDICT_WEIGHT_BITS;  // The new reading, at t = 0 and y = 0
+  samples++;
+  fit();
+
+  // Early warning
+  uint32_t horizon = settings.horizonMin * 60UL;
+  int32_t eta = etaSeconds(limit);
+  if (horizon == 0 || value > limit) {
+    warned = predicted = false;  // Off, or the high alert has taken over
+  } else if (!warned) {
+    bool within = eta >= 0 && (uint32_t)eta <= horizon;
+    if (within && !predicted) changeMs = timestampMs;
+    predicted = within;
+    if (within && timestampMs - changeMs >= PREDICT_CONFIRM_S * 1000UL) {
+      warned = true;
+      warnCount++;
+      changeMs = timestampMs;
+    }
+  } else if ((eta < 0 || (uint32_t)eta > horizon * PREDICT_CLEAR_PCT / 100) &&
+             timestampMs - changeMs >= PREDICT_HOLD_S * 1000UL) {
+    warned = predicted = false;
+  }
+  return warned;
+}
+
+void TempPredictor::fit() {
+  int64_t w = s0 >> PREDICT_FIT_SHIFT, t = st >> PREDICT_FIT_SHIFT, tt = stt >> PREDICT_FIT_SHIFT;
+  int64_t sumY = sy >> PREDICT_FIT_SHIFT, sumTY = sty >> PREDICT_FIT_SHIFT;
+  int64_t det = w * tt - t * t;
+  haveFit = samples > 1 && det > 0;
+  if (!haveFit) {
+    rateQ8 = 0;
+    fitLevel = reference;
+    return;
+  }
+  // Slope in centi-degrees per second times 60 << PREDICT_RATE_BITS, and the line at t = 0
+  int64_t rate = divRounded((w * sumTY - t * sumY) * (60L << PREDICT_RATE_BITS), det);
+  const int64_t maxRate = (int64_t)INT16_MAX << PREDICT_RATE_BITS;
+  rateQ8 = (int32_t)(rate > maxRate ? maxRate : rate < -maxRate ? -maxRate : rate);
+  fitLevel = reference + (int32_t)divRounded(tt * sumY - t * sumTY, det);
+}
+
+CentiC TempPredictor::ratePerMin() const {
+  return CentiC::fromCenti((int32_t)divRounded(rateQ8, 1L << PREDICT_RATE_BITS));
+}
+
+int32_t TempPredictor::etaSeconds(CentiC limit) const {
+  if (!ready() || !haveFit || rateQ8 < (PREDICT_MIN_RATE << PREDICT_RATE_BITS)) return -1;
+  if (reference < fitLevel - PREDICT_MAX_DROP) return -1;  // The rise has ended, the fit has not caught up
+  int32_t gap = limit.raw - fitLevel;
+  if (gap <= 0) return 0;
+  int64_t eta = ((int64_t)gap * (60L << PREDICT_RATE_BITS)) / rateQ8;
+  return eta > PREDICT_MAX_ETA_S ? -1 : (int32_t)eta;
+}
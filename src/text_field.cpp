@@ -0,0 +1,90 @@
+/*
+ * Retained-mode text field
+ * See text_field.h. Glyphs are compared position by position while the old and new
+ * strings stay aligned; from the first glyph whose advance differs, the rest of the
+ * line is cleared in one rectangle and redrawn.
+ */
+#include "text_field.h"
+
+void TextField::measureLine() {
+  if (font == nullptr) {
+    top = 0;
+    height = 8 * size;  // Built-in font, cursor is the top-left corner
+    return;
+  }
+  // GFX font: the cursor is the baseline, take the extent of all glyphs
+  GFXglyph* glyphs = (GFXglyph*)pgm_read_pointer(&font->glyph);
+  uint16_t count = pgm_read_word(&font->last) - pgm_read_word(&font->first) + 1;
+  int16_t minY = 0, maxY = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    int8_t yo = (int8_t)pgm_read_byte(&glyphs[i].yOffset);
+    uint8_t h = pgm_read_byte(&glyphs[i].height);
+    if (yo < minY) minY = yo;
+    if (yo + h > maxY) maxY = yo + h;
+  }
+  top = minY * size;
+  height = (maxY - minY) * size;
+}
+
+int16_t TextField::advance(char c) const {
+  if (font == nullptr) return 6 * size;
+  uint8_t first = pgm_read_word(&font->first);
+  uint8_t lastChar = pgm_read_word(&font->last);
+  if ((uint8_t)c < first || (uint8_t)c > lastChar) return 0;
+  GFXglyph* glyphs = (GFXglyph*)pgm_read_pointer(&font->glyph);
+  return pgm_read_byte(&glyphs[(uint8_t)c - first].xAdvance) * size;
+}
+
+int16_t TextField::textWidth(const char* s, size_t n) const {
+  int16_t w = 0;
+  for (size_t i = 0; i < n; i++) w += advance(s[i]);
+  return w;
+}
+
+void TextField::draw(Adafruit_GFX& gfx, const char* text, uint16_t color, uint16_t bg) {
+  if (height == 0) measureLine();
+  gfx.setFont(font);  // drawChar() renders with the display's current font
+
+  size_t newLen = strnlen(text, TEXT_FIELD_MAX_CHARS);
+  size_t oldLen = valid ? strlen(last) : 0;
+  if (valid && color != lastColor) oldLen = 0;  // Repaint every glyph in the new color
+  int16_t boxTop = y + top;
+  int16_t px = x;
+  size_t i = 0;
+
+  if (!valid || color != lastColor) {
+    // Unknown or differently colored content: clear the old extent once
+    if (valid) gfx.fillRect(x, boxTop, textWidth(last, strlen(last)), height, bg);
+  } else {
+    // Skip the glyphs that are already on screen
+    while (i < newLen && i < oldLen && text[i] == last[i]) px += advance(text[i++]);
+  }
+
+  // Replace changed glyphs in place while both strings stay aligned
+  for (; i < newLen && i < oldLen; i++) {
+    int16_t a = advance(text[i]);
+    if (a != advance(last[i])) break;  // Everything after this glyph moves
+    if (text[i] != last[i]) {
+      gfx.fillRect(px, boxTop, a, height, bg);
+      gfx.drawChar(px, y, text[i], color, color, size, size);
+    }
+    px += a;
+  }
+
+  // Tail: clear up to the longer of the old and new ends, then draw the new glyphs
+  if (i < newLen || i < oldLen) {
+    int16_t oldEnd = px + textWidth(last + i, oldLen > i ? oldLen - i : 0);
+    int16_t newEnd = px + textWidth(text + i, newLen - i);
+    int16_t end = oldEnd > newEnd ? oldEnd : newEnd;
+    if (oldLen > i && end > px) gfx.fillRect(px, boxTop, end - px, height, bg);
+    for (; i < newLen; i++) {
+      gfx.drawChar(px, y, text[i], color, color, size, size);
+      px += advance(text[i]);
+    }
+  }
+
+  memcpy(last, text, newLen);
+  last[newLen] = '\0';
+  lastColor = color;
+  valid = true;
+}
@@ -0,0 +1,140 @@
+/*
+ * Streaming statistics for the Trends screen
+ * See trend_stats.h.
+ */
+#include "trend_stats.h"
+#include <stdio.h>
+
+int32_t MomentSums::mean() const {
+  if (n == 0) return 0;
+  return (int32_t)((sum < 0 ? sum - n / 2 : sum + n / 2) / n);
+}
+
+uint32_t MomentSums::variance() const {
+  if (n < 2) return 0;
+  // sumSq - sum^2 / n without squaring sum (2^64 at the extremes): with sum = m*n + r,
+  // sum^2 / n = m*sum + m*r + r^2 / n
+  int64_t m = sum / n, r = sum - m * n;
+  int64_t m2 = sumSq - m * sum - m * r - r * r / n;
+  return m2 > 0 ? (uint32_t)(m2 / (n - 1)) : 0;
+}
+
+uint32_t isqrtRounded(uint32_t x) {
+  // Bit by bit, then up one when x is past (root + 1/2)^2
+  uint32_t root = 0, bit = 1UL << 30;
+  while (bit > x) bit >>= 2;
+  uint32_t rest = x;
+  while (bit != 0) {
+    if (rest >= root + bit) {
+      rest -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return rest > root ? root + 1 : root;
+}
+
+#define P2_ONE (1LL << 32)  // One marker position in Q32
+
+void P2Quantile::add(int16_t sample) {
+  int32_t x = (int32_t)sample << P2_HEIGHT_BITS;
+  // The first five samples are the markers, kept sorted
+  if (count < 5) {
+    int i = count++;
+    while (i > 0 && q[i - 1] > x) {
+      q[i] = q[i - 1];
+      i--;
+    }
+    q[i] = x;
+    if (count == 5) {
+      for (int k = 0; k < 5; k++) pos[k] = k;
+      want[0] = 0;
+      want[1] = 2 * (int64_t)p;
+      want[2] = 4 * (int64_t)p;
+      want[3] = 2 * P2_ONE + 2 * (int64_t)p;
+      want[4] = 4 * P2_ONE;
+    }
+    return;
+  }
+  count++;
+
+  // Cell of x, the outer markers follow the extremes
+  int k;
+  if (x < q[0]) {
+    q[0] = x;
+    k = 0;
+  } else if (x >= q[4]) {
+    q[4] = x;
+    k = 3;
+  } else {
+    k = 0;
+    while (x >= q[k + 1]) k++;
+  }
+  for (int i = k + 1; i < 5; i++) pos[i]++;
+  want[1] += p / 2;
+  want[2] += p;
+  want[3] += (P2_ONE + p) / 2;
+  want[4] += P2_ONE;
+
+  // Move the middle markers towards their desired positions, along a parabola through the
+  // neighbours or, if that would pass a neighbour, linearly. Heights times positions can
+  // pass 2^31 on a day of readings, so the parabola is worked in 64 bits
+  for (int i = 1; i <= 3; i++) {
+    int64_t d = want[i] - ((int64_t)pos[i] << 32);
+    if ((d >= P2_ONE && pos[i + 1] - pos[i] > 1) || (d <= -P2_ONE && pos[i - 1] - pos[i] < -1)) {
+      int s = d > 0 ? 1 : -1;
+      int32_t left = pos[i] - pos[i - 1], right = pos[i + 1] - pos[i];
+      int64_t parabolic = q[i] + s * ((int64_t)(left + s) * (q[i + 1] - q[i]) / right +
+                                      (int64_t)(right - s) * (q[i] - q[i - 1]) / left) / (left + right);
+      if (q[i - 1] < parabolic && parabolic < q[i + 1]) q[i] = (int32_t)parabolic;
+      else q[i] += s * (q[i + s] - q[i]) / (pos[i + s] - pos[i]);
+      pos[i] += s;
+    }
+  }
+}
+
+int32_t P2Quantile::value() const {
+  if (count == 0) return 0;
+  int32_t height = q[2];
+  if (count < 5) height = q[(uint32_t)(((uint64_t)p * (count - 1) + (1UL << 31)) >> 32)];  // Nearest rank of the sorted samples
+  return (height + (1 << (P2_HEIGHT_BITS - 1))) >> P2_HEIGHT_BITS;
+}
+
+void TrendStats::add(uint32_t timestampMs, CentiC value, CentiC limit) {
+  // The previous reading holds until this one: its interval counts if it was above
+  uint32_t above = 0;
+  if (haveLast && lastAbove) {
+    above = timestampMs - lastMs;
+    if (above > STATS_MAX_STEP_MS) above = STATS_MAX_STEP_MS;  // A gap, not a measured interval
+  }
+  totalAboveMs += above;
+  lastMs = timestampMs;
+  lastAbove = value > limit;
+  haveLast = true;
+
+  // One event per rise above the limit, the hysteresis keeps noise at the limit from
+  // counting again
+  bool started = false;
+  if (!inEvent && value > limit) {
+    inEvent = started = true;
+    eventStartMs = timestampMs;
+    events++;
+  } else if (inEvent && value.raw < limit.raw - STATS_CROSS_HYSTERESIS) {
+    inEvent = false;
+    lastEventMs = timestampMs - eventStartMs;
+    if (lastEventMs > longestEventMs) longestEventMs = lastEventMs;
+  }
+
+  hourWindow.add(timestampMs, value, above, started);
+  dayWindow.add(timestampMs, value, above, started);
+}
+
+void formatDuration(char* out, size_t size, uint32_t ms) {
+  unsigned long s = ms / 1000;
+  if (s < 60) snprintf(out, size, "%lus", s);
+  else if (s < 3600) snprintf(out, size, "%lum%02lus", s / 60, s % 60);
+  else if (s < 100 * 3600UL) snprintf(out, size, "%luh%02lum", s / 3600, s / 60 % 60);
+  else snprintf(out, size, "%lud%02luh", s / 86400, s / 3600 % 24);
+}
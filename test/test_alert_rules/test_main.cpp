@@ -0,0 +1,209 @@
+/*
+ * AlertEngine against a brute-force model that judges every rule on every reading: random
+ * rules, readings and threshold moves (also while rules are pending or active), then the
+ * states and the logged events compared after each step.
+ * Run with: pio test -e native
+ */
+#include <unity.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "alert_rules.h"
+
+static std::mt19937 rng;
+
+void setUp() { rng.seed(7); }
+void tearDown() {}
+
+// The plain version: each rule on its own, no sorted lists or cursors
+struct ReferenceEngine {
+  enum State { IDLE, PENDING, ACTIVE };
+  AlertRule rules[ALERT_MAX_RULES];
+  State state[ALERT_MAX_RULES];
+  uint32_t since[ALERT_MAX_RULES];
+  uint8_t count = 0;
+  bool haveLast = false;
+  uint32_t lastMs = 0;
+  CentiC lastValue;
+  std::vector<AlertEvent> events;
+
+  void begin(const AlertRule* table, uint8_t n) {
+    count = n;
+    for (uint8_t i = 0; i < n; i++) {
+      rules[i] = table[i];
+      state[i] = IDLE;
+    }
+  }
+
+  void judge(uint8_t i, uint32_t timestampMs, CentiC value) {
+    const AlertRule& r = rules[i];
+    int32_t k = r.direction == ALERT_ABOVE ? value.raw : -(int32_t)value.raw;
+    int32_t raiseAt = r.direction == ALERT_ABOVE ? r.threshold.raw : -(int32_t)r.threshold.raw;
+    int32_t clearAt = raiseAt - r.hysteresis.raw;
+    if (state[i] == ACTIVE) {
+      if (k < clearAt) {
+        state[i] = IDLE;
+        events.push_back({ timestampMs, value, i, false });
+      }
+      return;
+    }
+    if (k <= raiseAt) {
+      state[i] = IDLE;
+      return;
+    }
+    if (state[i] == IDLE) {
+      state[i] = PENDING;
+      since[i] = timestampMs;
+    }
+    if (timestampMs - since[i] >= r.minDurationS * 1000UL) {
+      state[i] = ACTIVE;
+      events.push_back({ timestampMs, value, i, true });
+    }
+  }
+
+  void update(uint32_t timestampMs, CentiC value) {
+    for (uint8_t i = 0; i < count; i++) judge(i, timestampMs, value);
+    haveLast = true;
+    lastMs = timestampMs;
+    lastValue = value;
+  }
+
+  // The moved rule, and every other one, judged again on the last reading
+  void setThreshold(uint8_t rule, CentiC threshold) {
+    rules[rule].threshold = threshold;
+    if (!haveLast) return;
+    for (uint8_t i = 0; i < count; i++) judge(i, lastMs, lastValue);
+  }
+};
+
+static AlertRule randomRule() {
+  AlertRule r;
+  r.name = "rule";
+  r.direction = rng() % 2 ? ALERT_BELOW : ALERT_ABOVE;
+  r.threshold = CentiC::fromCenti(2000 + (int32_t)(rng() % 2000));
+  r.hysteresis = CentiC::fromCenti(rng() % 4 == 0 ? 0 : (int32_t)(rng() % 150));
+  r.minDurationS = rng() % 4 == 0 ? 0 : (uint16_t)(rng() % 20);
+  r.severity = ALERT_WARNING;
+  return r;
+}
+
+// Events logged by the engine since eventsLogged() was before, oldest first
+static void collect(const AlertEngine& engine, uint32_t before, std::vector<AlertEvent>& into) {
+  uint32_t added = engine.eventsLogged() - before;
+  TEST_ASSERT_TRUE(added <= ALERT_EVENT_CAPACITY);
+  for (uint32_t k = added; k > 0; k--) into.push_back(engine.event((uint16_t)(k - 1)));
+}
+
+// One step's events in a fixed order: the engine logs the rules of a reading in threshold
+// order, the model in rule order
+static void sortEvents(std::vector<AlertEvent>& events) {
+  std::sort(events.begin(), events.end(), [](const AlertEvent& a, const AlertEvent& b) {
+    return a.rule != b.rule ? a.rule < b.rule : a.raised < b.raised;
+  });
+}
+
+static void compareStep(const AlertEngine& engine, const ReferenceEngine& reference, std::vector<AlertEvent>& got,
+                        size_t expectedFrom) {
+  std::vector<AlertEvent> expected(reference.events.begin() + expectedFrom, reference.events.end());
+  sortEvents(got);
+  sortEvents(expected);
+  TEST_ASSERT_EQUAL_UINT32(expected.size(), got.size());
+  for (size_t i = 0; i < got.size(); i++) {
+    TEST_ASSERT_EQUAL_UINT32(expected[i].timestampMs, got[i].timestampMs);
+    TEST_ASSERT_EQUAL_INT(expected[i].value.raw, got[i].value.raw);
+    TEST_ASSERT_EQUAL_UINT8(expected[i].rule, got[i].rule);
+    TEST_ASSERT_EQUAL_UINT8(expected[i].raised, got[i].raised);
+  }
+  uint8_t active = 0;
+  for (uint8_t i = 0; i < reference.count; i++) {
+    bool on = reference.state[i] == ReferenceEngine::ACTIVE;
+    TEST_ASSERT_TRUE_MESSAGE(engine.active(i) == on, "rule state differs");
+    active += on;
+  }
+  TEST_ASSERT_EQUAL_UINT8(active, engine.activeCount());
+}
+
+static void test_random_readings_match_model() {
+  uint32_t events = 0, moves = 0, movesWhileSet = 0;
+  for (int trial = 0; trial < 400; trial++) {
+    uint8_t n = 1 + rng() % ALERT_MAX_RULES;
+    AlertRule rules[ALERT_MAX_RULES];
+    for (uint8_t i = 0; i < n; i++) rules[i] = randomRule();
+    AlertEngine engine;
+    engine.begin(rules, n);
+    ReferenceEngine reference;
+    reference.begin(rules, n);
+
+    uint32_t time = UINT32_MAX - 600000UL - (rng() % 600000);  // millis() wraps a few minutes in
+    int32_t value = 3000;
+    for (int step = 0; step < 2000; step++) {
+      std::vector<AlertEvent> got;
+      size_t expectedFrom = reference.events.size();
+      uint32_t before = engine.eventsLogged();
+
+      // Thresholds moved onto the reading's neighbourhood, so rules flip both ways
+      if (rng() % 25 == 0) {
+        uint8_t rule = rng() % n;
+        CentiC threshold = CentiC::fromCenti(value + (int32_t)(rng() % 301) - 150);
+        if (reference.state[rule] != ReferenceEngine::IDLE) movesWhileSet++;
+        moves++;
+        engine.setThreshold(rule, threshold);
+        reference.setThreshold(rule, threshold);
+        collect(engine, before, got);
+        compareStep(engine, reference, got, expectedFrom);
+        got.clear();
+        expectedFrom = reference.events.size();
+        before = engine.eventsLogged();
+      }
+
+      value += (int32_t)(rng() % 41) - 20;
+      if (rng() % 50 == 0) value += (int32_t)(rng() % 1001) - 500;  // Jumps across several thresholds
+      value = std::max<int32_t>(1500, std::min<int32_t>(4500, value));
+      time += rng() % 10 == 0 ? 1 + rng() % 5000 : 1000;
+      engine.update(time, CentiC::fromCenti(value));
+      reference.update(time, CentiC::fromCenti(value));
+      collect(engine, before, got);
+      compareStep(engine, reference, got, expectedFrom);
+    }
+    events += reference.events.size();
+  }
+  // The run has to have exercised the cases, not just passed
+  TEST_ASSERT_TRUE(events > 10000);
+  TEST_ASSERT_TRUE(movesWhileSet > moves / 10);
+}
+
+// Directed: a threshold moved while the rule waits out its minimum duration, and while raised
+static void test_threshold_moved_while_pending_or_active() {
+  AlertRule rule = { "hot", ALERT_ABOVE, CentiC::fromDegrees(30), CentiC::fromCenti(50), 5, ALERT_WARNING };
+  AlertEngine engine;
+  engine.begin(&rule, 1);
+  uint32_t time = 0;
+  engine.update(time += 1000, CentiC::fromDegrees(31));  // Pending, due at 6000
+  engine.setThreshold(0, CentiC::fromDegrees(32));        // Above the reading, the wait is dropped
+  for (int i = 0; i < 10; i++) engine.update(time += 1000, CentiC::fromDegrees(31));
+  TEST_ASSERT_FALSE(engine.active(0));
+  TEST_ASSERT_EQUAL_UINT32(0, engine.eventsLogged());
+
+  engine.setThreshold(0, CentiC::fromDegrees(30));  // Below again, the wait starts over at 11000
+  for (int i = 0; i < 4; i++) engine.update(time += 1000, CentiC::fromDegrees(31));
+  TEST_ASSERT_FALSE(engine.active(0));
+  engine.update(time += 1000, CentiC::fromDegrees(31));
+  TEST_ASSERT_TRUE(engine.active(0));
+  TEST_ASSERT_EQUAL_UINT32(16000, engine.event(0).timestampMs);
+
+  engine.setThreshold(0, CentiC::fromCenti(3120));  // Clear point 31.20 C, the reading is still raised
+  TEST_ASSERT_TRUE(engine.active(0));
+  engine.setThreshold(0, CentiC::fromCenti(3160));  // Clear point 31.10 C, cleared on the last reading
+  TEST_ASSERT_FALSE(engine.active(0));
+  TEST_ASSERT_EQUAL_UINT32(2, engine.eventsLogged());
+  TEST_ASSERT_FALSE(engine.event(0).raised);
+  TEST_ASSERT_EQUAL_UINT32(16000, engine.event(0).timestampMs);
+  TEST_ASSERT_EQUAL_INT(3100, engine.event(0).value.raw);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_random_readings_match_model);
+  RUN_TEST(test_threshold_moved_while_pending_or_active);
+  return UNITY_END();
+}
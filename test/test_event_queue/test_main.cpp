@@ -0,0 +1,95 @@
+/*
+ * EventQueue: one producer thread and one consumer thread, as the Ticker callback and loop()
+ * use it. Run with: pio test -e native
+ */
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include "event_queue.h"
+
+static const uint32_t EVENTS = 200000;
+
+void setUp() {}
+void tearDown() {}
+
+// The producer only pushes while there is room: every event arrives, in order, none dropped
+static void test_order_without_loss() {
+  static EventQueue<uint32_t, 64> queue;
+  uint32_t pushed = 0;
+  std::thread producer([&] {
+    for (uint32_t i = 0; i < EVENTS; i++) {
+      while (queue.size() >= 64) std::this_thread::yield();  // Only the consumer makes room
+      if (queue.push(i)) pushed++;
+    }
+  });
+  uint32_t expected = 0, outOfOrder = 0, value;
+  while (expected < EVENTS) {
+    if (!queue.pop(value)) {
+      std::this_thread::yield();  // Let the producer run, also on a single core
+      continue;
+    }
+    if (value != expected) outOfOrder++;
+    expected = value + 1;
+  }
+  producer.join();
+  TEST_ASSERT_EQUAL_UINT32(0, outOfOrder);
+  TEST_ASSERT_EQUAL_UINT32(EVENTS, pushed);
+  TEST_ASSERT_EQUAL_UINT32(0, queue.dropped());
+  TEST_ASSERT_TRUE(queue.empty());
+}
+
+// The consumer falls behind: the survivors stay in order and every lost event is counted
+static void test_full_queue_counts_drops() {
+  static EventQueue<uint32_t, 16> queue;
+  uint32_t accepted = 0;
+  std::atomic<bool> done{false};
+  std::thread producer([&] {
+    for (uint32_t i = 0; i < EVENTS; i++) {
+      if (queue.push(i)) accepted++;
+    }
+    done.store(true, std::memory_order_release);
+  });
+  uint32_t received = 0, outOfOrder = 0, last = 0, value;
+  bool first = true;
+  for (;;) {
+    bool finished = done.load(std::memory_order_acquire);  // Before the pop, so nothing is left behind
+    if (queue.pop(value)) {
+      if (!first && value <= last) outOfOrder++;
+      last = value;
+      first = false;
+      received++;
+      if ((received & 63) == 0) std::this_thread::yield();  // Fall behind now and then
+    } else if (finished) {
+      break;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  TEST_ASSERT_EQUAL_UINT32(0, outOfOrder);
+  TEST_ASSERT_EQUAL_UINT32(accepted, received);
+  TEST_ASSERT_EQUAL_UINT32(EVENTS, received + queue.dropped());
+}
+
+// Single thread: exactly N fit, each further push is one drop
+static void test_drop_count_exact() {
+  EventQueue<uint8_t, 8> queue;
+  for (uint8_t i = 0; i < 8; i++) TEST_ASSERT_TRUE(queue.push(i));
+  for (uint8_t i = 0; i < 5; i++) TEST_ASSERT_FALSE(queue.push(100 + i));
+  TEST_ASSERT_EQUAL_UINT32(5, queue.dropped());
+  TEST_ASSERT_EQUAL_UINT32(8, queue.size());
+  uint8_t value;
+  for (uint8_t i = 0; i < 8; i++) {
+    TEST_ASSERT_TRUE(queue.pop(value));
+    TEST_ASSERT_EQUAL_UINT8(i, value);
+  }
+  TEST_ASSERT_FALSE(queue.pop(value));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_order_without_loss);
+  RUN_TEST(test_full_queue_counts_drops);
+  RUN_TEST(test_drop_count_exact);
+  return UNITY_END();
+}
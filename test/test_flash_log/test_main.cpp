@@ -0,0 +1,241 @@
+/*
+ * FlashLog on the native LittleFS shim: rotation through every segment, range queries
+ * against a linear scan of what was appended, and recovery from a torn or corrupted tail.
+ * Run with: pio test -e native
+ */
+#include <unity.h>
+#include <LittleFS.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "flash_log.h"
+
+static std::mt19937 rng;
+static FlashLog flashLog;
+static std::vector<FlashLogRecord> written;  // Everything appended, oldest first
+
+void setUp() {
+  rng.seed(2024);
+  LittleFS.format();
+  written.clear();
+}
+void tearDown() {}
+
+// Minute records as updateChartData() makes them, noisy so blocks fill at their slowest
+static void appendRecords(size_t count) {
+  FlashLogRecord r = written.empty() ? FlashLogRecord{ 1700000000, CentiC::fromCenti(2700), CentiC::fromCenti(2800),
+                                                       CentiC::fromCenti(2750), 60, 0 }
+                                     : written.back();
+  for (size_t i = 0; i < count; i++) {
+    r.time += 60 + (rng() % 10 == 0 ? rng() % 600 : 0);  // Now and then a gap
+    int16_t mean = (int16_t)(r.mean.raw + (int)(rng() % 61) - 30);
+    r.mean = CentiC::fromCenti(mean);
+    r.min = CentiC::fromCenti(mean - (int16_t)(rng() % 80));
+    r.max = CentiC::fromCenti(mean + (int16_t)(rng() % 80));
+    r.count = (uint16_t)(55 + rng() % 6);
+    r.crossings += rng() % 20 == 0;
+    flashLog.append(r);
+    written.push_back(r);
+  }
+}
+
+static bool collect(const FlashLogRecord& record, void* context) {
+  static_cast<std::vector<FlashLogRecord>*>(context)->push_back(record);
+  return true;
+}
+
+static std::vector<FlashLogRecord> query(uint32_t from, uint32_t to) {
+  std::vector<FlashLogRecord> out;
+  uint32_t visited = flashLog.query(from, to, collect, &out);
+  TEST_ASSERT_EQUAL_UINT32(out.size(), visited);
+  return out;
+}
+
+static bool sameRecord(const FlashLogRecord& a, const FlashLogRecord& b) {
+  return a.time == b.time && a.min == b.min && a.max == b.max && a.mean == b.mean && a.count == b.count &&
+         a.crossings == b.crossings;
+}
+
+// Index in written of the first record of the stored log, which must run from there to the end
+static size_t checkStoredIsSuffix() {
+  std::vector<FlashLogRecord> stored = query(0, UINT32_MAX);
+  TEST_ASSERT_TRUE(!stored.empty() && stored.size() <= written.size());
+  size_t start = written.size() - stored.size();
+  for (size_t i = 0; i < stored.size(); i++) {
+    TEST_ASSERT_TRUE_MESSAGE(sameRecord(written[start + i], stored[i]), "stored record differs");
+  }
+  return start;
+}
+
+// Path of the newest segment file, the names are fixed-width hex sequence numbers
+static std::string newestSegment() {
+  Dir dir = LittleFS.openDir(FLASH_LOG_DIR);
+  std::string newest;
+  while (dir.next()) newest = std::max(newest, std::string(dir.fileName().c_str()));
+  return FLASH_LOG_DIR "/" + newest;
+}
+
+static void test_rotation_through_all_segments() {
+  TEST_ASSERT_TRUE(flashLog.begin(LittleFS));
+  // Enough for every segment to fill and the oldest ones to be deleted more than once over
+  size_t perPass = FLASH_LOG_SEGMENTS * FLASH_LOG_SEGMENT_BLOCKS * 50;
+  size_t dropped = 0;
+  for (int pass = 0; pass < 3; pass++) {
+    appendRecords(perPass);
+    flashLog.flush();
+    TEST_ASSERT_EQUAL_UINT8(FLASH_LOG_SEGMENTS, flashLog.segments());
+    size_t start = checkStoredIsSuffix();
+    TEST_ASSERT_TRUE_MESSAGE(start > dropped, "oldest segment not deleted");
+    dropped = start;
+    // What is kept: at least all segments but the open one full
+    TEST_ASSERT_TRUE(flashLog.storedBlocks() > (uint32_t)(FLASH_LOG_SEGMENTS - 1) * FLASH_LOG_SEGMENT_BLOCKS);
+  }
+  uint32_t files = 0;
+  Dir dir = LittleFS.openDir(FLASH_LOG_DIR);
+  while (dir.next()) files++;
+  TEST_ASSERT_EQUAL_UINT32(FLASH_LOG_SEGMENTS, files);
+
+  // A restart finds the same log
+  TEST_ASSERT_TRUE(flashLog.begin(LittleFS));
+  TEST_ASSERT_EQUAL_UINT32(dropped, checkStoredIsSuffix());
+  TEST_ASSERT_EQUAL_UINT32(0, flashLog.recoveredBlocks());  // Nothing torn, the first test
+}
+
+static void test_random_ranges_match_linear_scan() {
+  TEST_ASSERT_TRUE(flashLog.begin(LittleFS));
+  appendRecords(FLASH_LOG_SEGMENTS * FLASH_LOG_SEGMENT_BLOCKS * 90);  // Rotated, and a block left open
+  size_t start = checkStoredIsSuffix();
+  uint32_t first = written[start].time, last = written.back().time;
+  for (int round = 0; round < 2000; round++) {
+    // Ranges inside, across either end and outside the log, from empty to all of it
+    uint32_t span = last - first + 7200;
+    uint32_t from = first - 3600 + rng() % span;
+    uint32_t to = rng() % 8 == 0 ? from : from + rng() % (rng() % 4 == 0 ? span : 7200);
+    if (round == 0) from = 0, to = UINT32_MAX;
+    std::vector<FlashLogRecord> got = query(from, to);
+    size_t expected = 0, at = 0;
+    for (size_t i = start; i < written.size(); i++) {
+      if (written[i].time < from || written[i].time >= to) continue;
+      TEST_ASSERT_TRUE_MESSAGE(at < got.size() && sameRecord(written[i], got[at]), "range query differs");
+      at++;
+      expected++;
+    }
+    TEST_ASSERT_EQUAL_UINT32(expected, got.size());
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, flashLog.crcErrors());  // No test before damages a block
+}
+
+// The last block written is cut short, as by a reset in the middle of the write
+static void test_truncated_tail_block_is_cut() {
+  TEST_ASSERT_TRUE(flashLog.begin(LittleFS));
+  appendRecords(3000);
+  flashLog.flush();
+  std::string path = newestSegment();
+  File file = LittleFS.open(path.c_str(), "r+");
+  TEST_ASSERT_TRUE(file.truncate(file.size() - FLASH_LOG_BLOCK_BYTES / 3));
+  file.close();
+
+  uint32_t cut = flashLog.recoveredBlocks();  // The counters run on across begin()
+  TEST_ASSERT_TRUE(flashLog.begin(LittleFS));
+  TEST_ASSERT_EQUAL_UINT32(cut + 1, flashLog.recoveredBlocks());
+  std::vector<FlashLogRecord> stored = query(0, UINT32_MAX);
+  // Only the torn block is lost, and a block holds fewer records than twice its bytes
+  TEST_ASSERT_TRUE(stored.size() < written.size() && stored.size() + FLASH_LOG_BLOCK_BYTES * 2 > written.size());
+  for (size_t i = 0; i < stored.size(); i++) TEST_ASSERT_TRUE(sameRecord(written[i], stored[i]));
+
+  // Logging carries on after the cut
+  written.resize(stored.size());
+  appendRecords(500);
+  flashLog.flush();
+  TEST_ASSERT_TRUE(flashLog.begin(LittleFS));
+  std::vector<FlashLogRecord> after = query(0, UINT32_MAX);
+  TEST_ASSERT_EQUAL_UINT32(written.size(), after.size());
+  for (size_t i = 0; i < after.size(); i++) TEST_ASSERT_TRUE(sameRecord(written[i], after[i]));
+}
+
+// One byte of the last block changes on flash: its CRC fails and begin() drops it; a bad
+// block further back is skipped by queries, never returned
+static void test_corrupted_blocks_are_dropped() {
+  TEST_ASSERT_TRUE(flashLog.begin(LittleFS));
+  appendRecords(3000);
+  flashLog.flush();
+  std::string path = newestSegment();
+  File file = LittleFS.open(path.c_str(), "r+");
+  size_t size = file.size();
+  uint8_t byte;
+  for (size_t offset : { size - FLASH_LOG_BLOCK_BYTES / 2, size - FLASH_LOG_BLOCK_BYTES * 5 / 2 }) {
+    file.seek(offset);
+    file.read(&byte, 1);
+    byte ^= 0x10;
+    file.seek(offset);
+    file.write(&byte, 1);
+  }
+  file.close();
+
+  uint32_t cut = flashLog.recoveredBlocks(), crcErrors = flashLog.crcErrors();
+  TEST_ASSERT_TRUE(flashLog.begin(LittleFS));
+  TEST_ASSERT_EQUAL_UINT32(cut + 1, flashLog.recoveredBlocks());
+  std::vector<FlashLogRecord> stored = query(0, UINT32_MAX);
+  TEST_ASSERT_TRUE(flashLog.crcErrors() > crcErrors);
+  // What comes back is written records in order, with the two blocks' records missing
+  size_t at = 0;
+  for (const FlashLogRecord& r : stored) {
+    while (at < written.size() && written[at].time != r.time) at++;
+    TEST_ASSERT_TRUE_MESSAGE(at < written.size() && sameRecord(written[at], r), "record not written");
+    at++;
+  }
+  TEST_ASSERT_TRUE(stored.size() < written.size());
+}
+
+// The Trends 7d line folds a week of minute records: 604800 readings overflow a bucket's
+// count, and at 40 C its sum as well
+static void test_week_summary_folds_a_full_week() {
+  const uint32_t minutes = 7 * 1440;
+  TEST_ASSERT_TRUE(flashLog.begin(LittleFS));
+  FlashLogRecord r = { 1700000000, CentiC::fromCenti(3950), CentiC::fromCenti(4050), CentiC::fromDegrees(40), 60, 0 };
+  for (uint32_t i = 0; i < minutes; i++) {
+    r.time += 60;
+    flashLog.append(r);
+  }
+  RollupSummary week = {};
+  TEST_ASSERT_EQUAL_UINT32(minutes, flashLog.query(0, UINT32_MAX, flashLogFoldSummary, &week));
+  TEST_ASSERT_EQUAL_UINT32(minutes * 60, week.count);
+  TEST_ASSERT_EQUAL_INT(4000, week.mean().raw);
+  TEST_ASSERT_EQUAL_INT(3950, week.min.raw);
+  TEST_ASSERT_EQUAL_INT(4050, week.max.raw);
+
+  // Noisy records with gaps, the last 7 days against sums over what was written
+  LittleFS.format();
+  TEST_ASSERT_TRUE(flashLog.begin(LittleFS));
+  appendRecords(minutes + 1000);
+  uint32_t from = written.back().time - 7 * 86400UL;
+  week = {};
+  flashLog.query(from, UINT32_MAX, flashLogFoldSummary, &week);
+  int64_t sum = 0;
+  uint32_t count = 0;
+  int16_t lo = INT16_MAX, hi = INT16_MIN;
+  for (const FlashLogRecord& w : written) {
+    if (w.time < from) continue;
+    sum += (int64_t)w.mean.raw * w.count;
+    count += w.count;
+    lo = std::min(lo, w.min.raw);
+    hi = std::max(hi, w.max.raw);
+  }
+  TEST_ASSERT_TRUE(count > UINT16_MAX);
+  TEST_ASSERT_EQUAL_UINT32(count, week.count);
+  TEST_ASSERT_TRUE(week.sum == sum);
+  TEST_ASSERT_EQUAL_INT((int32_t)((sum + count / 2) / count), week.mean().raw);
+  TEST_ASSERT_EQUAL_INT(lo, week.min.raw);
+  TEST_ASSERT_EQUAL_INT(hi, week.max.raw);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_rotation_through_all_segments);
+  RUN_TEST(test_random_ranges_match_linear_scan);
+  RUN_TEST(test_truncated_tail_block_is_cut);
+  RUN_TEST(test_corrupted_blocks_are_dropped);
+  RUN_TEST(test_week_summary_folds_a_full_week);
+  return UNITY_END();
+}
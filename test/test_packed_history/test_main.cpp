@@ -0,0 +1,118 @@
+/*
+ * PackedHistory against a plain deque of the same readings: random pushes in phases from
+ * steady to wild, then contents, order, min/max and random access compared after each push.
+ * Run with: pio test -e native
+ */
+#include <unity.h>
+#include <algorithm>
+#include <deque>
+#include <random>
+#include "packed_history.h"
+
+static std::mt19937 rng;
+
+void setUp() { rng.seed(99); }
+void tearDown() {}
+
+struct Reading {
+  uint32_t time;
+  int16_t value;
+};
+
+// The history must hold the newest readings pushed, as many as it reports
+static void compare(const PackedHistory<HISTORY_BLOCKS, HISTORY_BLOCK_BYTES>& history, std::deque<Reading>& reference,
+                    bool full) {
+  TEST_ASSERT_TRUE(history.size() <= reference.size());
+  while (reference.size() > history.size()) reference.pop_front();
+  TEST_ASSERT_EQUAL_UINT32(reference.back().time, history.newest().timestampMs);
+  TEST_ASSERT_EQUAL_INT(reference.back().value, history.newest().value.raw);
+  TEST_ASSERT_EQUAL_UINT32(reference.front().time, history.oldest().timestampMs);
+  TEST_ASSERT_EQUAL_INT(reference.front().value, history.oldest().value.raw);
+  int16_t lo = INT16_MAX, hi = INT16_MIN;
+  for (const Reading& r : reference) {
+    lo = std::min(lo, r.value);
+    hi = std::max(hi, r.value);
+  }
+  TEST_ASSERT_EQUAL_INT(lo, history.min().raw);
+  TEST_ASSERT_EQUAL_INT(hi, history.max().raw);
+  if (!full) return;
+  size_t i = 0;
+  for (auto sample : history) {
+    TEST_ASSERT_TRUE_MESSAGE(sample.timestampMs == reference[i].time && sample.value.raw == reference[i].value,
+                             "iterator reading differs");
+    i++;
+  }
+  TEST_ASSERT_EQUAL_UINT32(reference.size(), i);
+  // Random access jumps back and forth, the decoder cursor has to find its place again
+  for (int k = 0; k < 50; k++) {
+    uint16_t at = (uint16_t)(rng() % history.size());
+    TEST_ASSERT_TRUE_MESSAGE(history[at].timestampMs == reference[at].time && history[at].value.raw == reference[at].value,
+                             "indexed reading differs");
+  }
+}
+
+static void test_random_pushes_match_deque() {
+  static PackedHistory<HISTORY_BLOCKS, HISTORY_BLOCK_BYTES> history;
+  std::deque<Reading> reference;
+  uint32_t time = UINT32_MAX - 3600000UL;  // millis() wraps an hour in
+  int32_t value = 2750;
+  uint32_t pushes = 0;
+  for (int phase = 0; phase < 40; phase++) {
+    int kind = phase % 5;
+    int length = 200 + rng() % 2000;
+    for (int n = 0; n < length; n++) {
+      uint32_t step = 1000;
+      int32_t change = 0;
+      switch (kind) {
+        case 0: change = rng() % 20 == 0 ? (int)(rng() % 3) - 1 : 0; break;   // Steady
+        case 1: change = (int)(rng() % 41) - 20; step += rng() % 11; break;  // Noisy, jittered ticks
+        case 2: change = (int)(rng() % 2001) - 1000; break;                 // Large jumps
+        case 3: change = (int)(rng() % 7) - 3; step = rng() % 3 == 0 ? rng() % 100000000 : 1000; break;  // Gaps
+        case 4: change = rng() % 2 ? 32767 : -32768; break;                 // The int16 ends
+      }
+      value = kind == 4 ? change : std::max<int32_t>(-32768, std::min<int32_t>(32767, value + change));
+      time += step;
+      history.push(time, CentiC::fromCenti((int16_t)value));
+      reference.push_back({ time, (int16_t)value });
+      pushes++;
+      compare(history, reference, n % 97 == 0 || n == length - 1);
+    }
+    if (kind == 4) value = 2750;
+  }
+  TEST_ASSERT_EQUAL_UINT32(pushes, history.totalPushed());
+}
+
+// Once full it keeps at least BLOCKS - 1 blocks of readings
+static void test_keeps_all_but_one_block() {
+  static PackedHistory<HISTORY_BLOCKS, HISTORY_BLOCK_BYTES> history;
+  uint32_t time = 0;
+  uint16_t fewest = UINT16_MAX;
+  for (int n = 0; n < 20000; n++) {
+    history.push(time += 1000, CentiC::fromCenti((int16_t)(2750 + (int)(rng() % 41) - 20)));
+    if (n > 5000) fewest = std::min(fewest, history.size());
+  }
+  // The noisiest readings above take at most 13 bits each
+  TEST_ASSERT_TRUE(fewest >= (HISTORY_BLOCKS - 1) * (HISTORY_BLOCK_BYTES * 8 / 13));
+}
+
+static void test_clear_starts_over() {
+  static PackedHistory<HISTORY_BLOCKS, HISTORY_BLOCK_BYTES> history;
+  for (int n = 0; n < 3000; n++) history.push(n * 1000, CentiC::fromCenti((int16_t)(n % 300)));
+  (void)history[10];  // Leave the decoder cursor somewhere
+  history.clear();
+  TEST_ASSERT_TRUE(history.empty());
+  std::deque<Reading> reference;
+  for (int n = 0; n < 500; n++) {
+    history.push(5000000 + n * 1000, CentiC::fromCenti((int16_t)(-n)));
+    reference.push_back({ (uint32_t)(5000000 + n * 1000), (int16_t)(-n) });
+  }
+  compare(history, reference, true);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_random_pushes_match_deque);
+  RUN_TEST(test_keeps_all_but_one_block);
+  RUN_TEST(test_clear_starts_over);
+  return UNITY_END();
+}
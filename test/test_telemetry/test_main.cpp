@@ -0,0 +1,176 @@
+/*
+ * Telemetry frames: COBS and CRC building blocks, encoder to decoder round trips, and a
+ * damaged stream (text mixed in, lost frames, bit flips). Run with: pio test -e native
+ */
+#include <unity.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "telemetry.h"
+
+static std::mt19937 rng;
+
+void setUp() { rng.seed(12345); }
+void tearDown() {}
+
+// A plausible run of readings: one per second with jitter, slow drift and now and then a jump
+static std::vector<TelemetrySample> makeSamples(size_t count) {
+  std::vector<TelemetrySample> samples;
+  TelemetrySample s = { 1000, 500 * 16, 2750, 0 };
+  for (size_t i = 0; i < count; i++) {
+    s.timestampMs += 990 + rng() % 20;
+    int step = (int)(rng() % 7) - 3;
+    if (rng() % 50 == 0) step *= 100;
+    s.adcQ4 = (uint16_t)(s.adcQ4 + step);
+    s.centiC += step * 3;
+    s.flags = rng() % 16 == 0 ? (uint8_t)(rng() & 0x0F) : s.flags;
+    samples.push_back(s);
+  }
+  return samples;
+}
+
+static bool sameSample(const TelemetrySample& a, const TelemetrySample& b) {
+  return a.timestampMs == b.timestampMs && a.adcQ4 == b.adcQ4 && a.centiC == b.centiC && a.flags == b.flags;
+}
+
+static std::vector<uint8_t> encodeFrame(TelemetryEncoder& encoder, const TelemetrySample& sample) {
+  uint8_t frame[TELEMETRY_FRAME_MAX];
+  size_t n = encoder.encode(sample, frame);
+  TEST_ASSERT_LESS_OR_EQUAL(TELEMETRY_FRAME_MAX, n);
+  return std::vector<uint8_t>(frame, frame + n);
+}
+
+static void test_crc_check_value() {
+  const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+  TEST_ASSERT_EQUAL_HEX16(0x29B1, telemetryCrc16(check, sizeof(check)));
+  TEST_ASSERT_EQUAL_HEX16(0xFFFF, telemetryCrc16(check, 0));
+}
+
+static void test_cobs_round_trip_random() {
+  uint8_t in[600], encoded[600 + 600 / 254 + 1], decoded[600];
+  for (int round = 0; round < 5000; round++) {
+    size_t length = 1 + rng() % sizeof(in);
+    int zeroEvery = 1 + rng() % 300;  // From mostly zeros to runs far longer than 254 bytes
+    for (size_t i = 0; i < length; i++) in[i] = rng() % zeroEvery == 0 ? 0 : (uint8_t)(1 + rng() % 255);
+    size_t n = cobsEncode(in, length, encoded);
+    TEST_ASSERT_LESS_OR_EQUAL(length + length / 254 + 1, n);
+    for (size_t i = 0; i < n; i++) TEST_ASSERT_TRUE_MESSAGE(encoded[i] != 0, "COBS output holds a zero");
+    TEST_ASSERT_EQUAL_UINT32(length, cobsDecode(encoded, n, decoded));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(in, decoded, length);
+  }
+}
+
+static void test_cobs_rejects_malformed() {
+  const uint8_t runPastEnd[] = { 0x05, 0x11, 0x22 };
+  const uint8_t zeroInside[] = { 0x03, 0x11, 0x00 };
+  uint8_t out[8];
+  TEST_ASSERT_EQUAL_UINT32(0, cobsDecode(runPastEnd, sizeof(runPastEnd), out));
+  TEST_ASSERT_EQUAL_UINT32(0, cobsDecode(zeroInside, sizeof(zeroInside), out));
+}
+
+// Frames interleaved with log lines on the same UART: every sample comes out, unchanged
+static void test_stream_with_text_lines() {
+  std::vector<TelemetrySample> sent = makeSamples(2000);
+  TelemetryEncoder encoder;
+  std::string stream;
+  for (size_t i = 0; i < sent.size(); i++) {
+    if (rng() % 4 == 0) stream += "[" + std::to_string(sent[i].timestampMs) + " I] Temperature: 27.50\r\n";
+    if (rng() % 9 == 0) stream += "ok\r\n";  // Shorter than a frame, counted as bad
+    std::vector<uint8_t> frame = encodeFrame(encoder, sent[i]);
+    stream.append(frame.begin(), frame.end());
+  }
+  TelemetryDecoder decoder;
+  TelemetrySample sample;
+  size_t next = 0;
+  for (char c : stream) {
+    if (decoder.feed((uint8_t)c, sample) != TelemetryDecoder::SAMPLE) continue;
+    TEST_ASSERT_TRUE_MESSAGE(next < sent.size() && sameSample(sent[next], sample), "wrong sample");
+    next++;
+  }
+  TEST_ASSERT_EQUAL_UINT32(sent.size(), next);
+  TEST_ASSERT_EQUAL_UINT32(0, decoder.lost);
+  TEST_ASSERT_EQUAL_UINT32(0, decoder.skipped);
+}
+
+// Feed frames, checking every decoded sample against the one sent with it
+struct Checker {
+  TelemetryDecoder decoder;
+  uint32_t wrong = 0, decoded = 0;
+  bool feed(const std::vector<uint8_t>& bytes, const TelemetrySample& expected) {
+    bool got = false;
+    TelemetrySample sample;
+    for (uint8_t b : bytes) {
+      if (decoder.feed(b, sample) != TelemetryDecoder::SAMPLE) continue;
+      if (!sameSample(expected, sample)) wrong++;
+      decoded++;
+      got = true;
+    }
+    return got;
+  }
+};
+
+// A lost delta frame: the deltas after it are skipped, the next keyframe brings the decoder back
+static void test_lost_frames_resync_at_keyframe() {
+  std::vector<TelemetrySample> sent = makeSamples(20 * TELEMETRY_KEYFRAME_EVERY);
+  TelemetryEncoder encoder;
+  Checker checker;
+  bool dropping = false;
+  uint32_t dropped = 0;
+  for (size_t i = 0; i < sent.size(); i++) {
+    std::vector<uint8_t> frame = encodeFrame(encoder, sent[i]);
+    bool key = i % TELEMETRY_KEYFRAME_EVERY == 0;
+    if (key) dropping = false;
+    if (!key && rng() % 10 == 0) {
+      dropping = true;  // Lose this one, the decoder cannot apply deltas until the next keyframe
+      dropped++;
+      continue;
+    }
+    bool got = checker.feed(frame, sent[i]);
+    TEST_ASSERT_TRUE_MESSAGE(got == !dropping, dropping ? "delta applied after a lost frame" : "sample missing");
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, checker.wrong);
+  TEST_ASSERT_TRUE(dropped > 0);
+  TEST_ASSERT_EQUAL_UINT32(0, checker.decoder.bad);
+  TEST_ASSERT_TRUE(checker.decoder.lost > 0);
+  TEST_ASSERT_TRUE(checker.decoder.skipped > 0);
+}
+
+// Single bit flips anywhere in a frame, delimiters included: never a wrong sample, and the
+// decoder is back at the next keyframe
+static void test_bit_flips_never_give_wrong_samples() {
+  std::vector<TelemetrySample> sent = makeSamples(200 * TELEMETRY_KEYFRAME_EVERY);
+  TelemetryEncoder encoder;
+  Checker checker;
+  bool damaged = false;
+  uint32_t flips = 0, missing = 0;
+  for (size_t i = 0; i < sent.size(); i++) {
+    std::vector<uint8_t> frame = encodeFrame(encoder, sent[i]);
+    bool key = i % TELEMETRY_KEYFRAME_EVERY == 0;
+    bool flip = rng() % 8 == 0;
+    if (flip) {
+      size_t bit = rng() % (frame.size() * 8);
+      frame[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+      flips++;
+    }
+    bool got = checker.feed(frame, sent[i]);
+    if (key && !flip) damaged = false;  // An intact keyframe always resyncs
+    if (flip) damaged = true;
+    if (!damaged && !got) missing++;
+  }
+  TEST_ASSERT_EQUAL_UINT32(0, checker.wrong);
+  TEST_ASSERT_TRUE(flips > 100);
+  TEST_ASSERT_EQUAL_UINT32(0, missing);
+  TEST_ASSERT_TRUE(checker.decoder.bad > 0);
+  TEST_ASSERT_TRUE(checker.decoded > sent.size() / 3);  // One flip in 8 frames, each costs up to a keyframe interval
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_crc_check_value);
+  RUN_TEST(test_cobs_round_trip_random);
+  RUN_TEST(test_cobs_rejects_malformed);
+  RUN_TEST(test_stream_with_text_lines);
+  RUN_TEST(test_lost_frames_resync_at_keyframe);
+  RUN_TEST(test_bit_flips_never_give_wrong_samples);
+  return UNITY_END();
+}
@@ -0,0 +1,613 @@
+/*
+ * Streaming serial log analyzer
+ * One pass over a capture in fixed-size chunks, memory does not grow with the file size.
+ * Understands the old captures ("Temperature: 27.59", "Indian Time: 22:38:20", lines
+ * spliced together when output overlapped) and the logger format ("[12345 I] text x6").
+ *
+ * Lines are resynced on the rightmost "Temperature:" / "Time:" anchor, so a reading glued
+ * behind a fragment ("e: 22:38:20Indian Time: 22:38:21") or missing the start of its label
+ * ("ndian Time: 22:38:20") is still recovered. Lines that only hold fragments are counted
+ * as corrupt.
+ *
+ * Readings are timestamped from the "[ms" prefix, or else from the last wall-clock line
+ * (second resolution). "xN" lines stand for N readings spaced by --period-ms.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 tools/log_analyze.cpp -o log_analyze
+ *
+ * Usage:
+ *   log_analyze [--high C] [--low C] [--gap-ms N] [--period-ms N] [--csv out.csv] [capture...]
+ *   log_analyze --bench [MB]   (parse throughput on a synthetic capture of that size)
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <sys/resource.h>
+
+#define LINE_MAX_CHARS 256         // Longer lines are cut and counted as corrupt
+#define CHUNK_BYTES (1 << 20)      // Read size
+#define MAX_TYPES 48               // Distinct message types tracked, the rest go to "(other)"
+#define TYPE_KEY_CHARS 40          // Message type key: text with digit runs replaced by '#'
+#define HIST_MIN_CENTI (-5500)     // Exact percentile histogram, 0.01 C bins
+#define HIST_MAX_CENTI 15000
+#define HIST_BINS (HIST_MAX_CENTI - HIST_MIN_CENTI + 1)
+#define CLOCK_STEP_MAX_S 60        // Larger wall-clock steps need a second line to agree
+#define CLOCK_CONFIRM_S 2          // ...one to this many seconds later
+#define CLOCK_PAUSE_MAX_S 3600     // Confirmed forward jumps up to this are a pause in the output
+#define NO_TIME INT64_MIN
+
+static const char* const keywords[] = { "Indian Time: ", "Temperature: " };
+// Pieces of those labels that do not occur in other messages ("Timer interrupt attached.")
+static const char* const labelPieces[] = { "Indi", "ndia", "dian", "ian ", "an T", "n Ti", "Temp",
+                                           "empe", "mper", "pera", "erat", "ratu", "atur", "ture" };
+
+struct MessageType {
+  char key[TYPE_KEY_CHARS + 1];
+  uint32_t hash;
+  uint64_t lines;
+};
+
+struct Options {
+  int32_t highCenti = 4000;     // Firmware default alert limits
+  int32_t lowCenti = 2000;
+  int64_t gapMs = 3000;         // Interval between readings counted as a gap
+  int64_t periodMs = 1000;      // Spacing of readings folded into "xN"
+  FILE* csv = nullptr;
+};
+
+class LogAnalyzer {
+public:
+  explicit LogAnalyzer(const Options& options) : opt(options) {}
+
+  // Feed the next piece of the capture, lines may span calls
+  void feed(const char* data, size_t length) {
+    bytes += length;
+    const char* end = data + length;
+    while (data < end) {
+      const char* newline = (const char*)memchr(data, '\n', end - data);
+      const char* stop = newline ? newline : end;
+      size_t n = stop - data;
+      if (newline && lineLength == 0 && !lineTooLong && n <= LINE_MAX_CHARS) {
+        endLine(data, n, false);  // Whole line inside this piece, no copy
+      } else {
+        // Line spans pieces: carry it over in line[]
+        size_t room = LINE_MAX_CHARS - lineLength;
+        if (n > room) lineTooLong = true;
+        memcpy(line + lineLength, data, n < room ? n : room);
+        lineLength += n < room ? n : room;
+        if (newline) {
+          endLine(line, lineLength, lineTooLong);
+          lineLength = 0;
+          lineTooLong = false;
+        }
+      }
+      data = stop + 1;
+    }
+  }
+
+  void finish() {
+    if (lineLength > 0 || lineTooLong) endLine(line, lineLength, lineTooLong);
+    lineLength = 0;
+    lineTooLong = false;
+  }
+
+  void report(FILE* out, const char* name, double seconds) const;
+
+  uint64_t bytes = 0;
+  uint64_t lines = 0;
+  uint64_t samples = 0;
+
+private:
+  void endLine(const char* s, size_t n, bool tooLong);
+  void handleLine(const char* s, size_t n);
+  bool parseTemperature(const char* s, const char* end, int32_t& centi, uint32_t& repeats) const;
+  bool parseClock(const char* s, const char* end, int32_t& secondOfDay) const;
+  bool restIsClean(const char* s, const char* end, uint32_t& repeats) const;
+  void addSample(int64_t timeMs, int32_t centi);
+  void countType(const char* s, const char* end, uint64_t count);
+  int64_t clockToMs(int32_t secondOfDay);
+
+  Options opt;
+  char line[LINE_MAX_CHARS];
+  size_t lineLength = 0;
+  bool lineTooLong = false;
+
+  // Line classes
+  uint64_t corrupt = 0;     // Nothing recoverable, only fragments
+  uint64_t recovered = 0;   // Reading parsed behind junk or with a cut label
+  uint64_t clockRejected = 0;  // Wall-clock values that no following line agreed with
+  uint64_t clockJumps = 0;     // Confirmed wall-clock steps (NTP sync, restart)
+
+  // Time base
+  int64_t lastTimeMs = NO_TIME;  // Latest timestamp seen on any line
+  int64_t firstTimeMs = NO_TIME;
+  int64_t clockMs = 0;           // Timeline position of the last accepted wall-clock line
+  int32_t lastClock = -1;        // Its second of the day
+  int32_t pendingClock = -1;     // Jump waiting for confirmation
+  uint32_t pendingLines = 0;     // Lines that showed it
+
+  // Readings
+  int64_t lastSampleMs = NO_TIME;
+  int64_t firstSampleMs = NO_TIME;
+  uint64_t timedSamples = 0;
+  uint64_t gaps = 0;
+  int64_t longestGapMs = 0;
+  int64_t longestGapAtMs = 0;
+  int64_t minIntervalMs = INT64_MAX;
+  int64_t maxIntervalMs = 0;
+  int64_t sumCenti = 0;
+  uint32_t hist[HIST_BINS] = {};
+  uint64_t belowHist = 0, aboveHist = 0;
+  int32_t minCenti = INT32_MAX, maxCenti = INT32_MIN;
+
+  // Threshold crossings (same strict comparisons as the firmware alert logic)
+  int zone = 0;               // -1 below low, 0 between, 1 above high
+  bool haveZone = false;
+  uint64_t highCrossings = 0, lowCrossings = 0;
+  int64_t msAboveHigh = 0, msBelowLow = 0;
+
+  MessageType types[MAX_TYPES];
+  int typeCount = 0;
+  uint64_t otherTypeLines = 0;
+};
+
+void LogAnalyzer::endLine(const char* s, size_t n, bool tooLong) {
+  lines++;
+  if (tooLong) {
+    corrupt++;
+    return;
+  }
+  if (n > 0 && s[n - 1] == '\r') n--;
+  handleLine(s, n);
+}
+
+static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Rightmost occurrence of word in [s, end)
+static const char* findLast(const char* s, const char* end, const char* word) {
+  size_t w = strlen(word);
+  for (const char* p = end - w; p >= s; p--) {
+    if (memcmp(p, word, w) == 0) return p;
+  }
+  return nullptr;
+}
+
+// Trailing text is fine when it is empty, a logger " xN" count, or the start of the next
+// message whose newline was lost ("Indian Time: 22:38:20I")
+bool LogAnalyzer::restIsClean(const char* s, const char* end, uint32_t& repeats) const {
+  repeats = 1;
+  if (s == end) return true;
+  if (end - s >= 3 && s[0] == ' ' && s[1] == 'x' && isDigit(s[2])) {
+    uint32_t n = 0;
+    for (s += 2; s < end && isDigit(*s); s++) n = n * 10 + (*s - '0');
+    repeats = n;
+    return s == end && n > 0;
+  }
+  for (const char* k : keywords) {
+    if ((size_t)(end - s) < strlen(k) && memcmp(s, k, end - s) == 0) return true;
+  }
+  return false;
+}
+
+// "27.59" / "-3.5" -> centi-degrees, the firmware prints two decimals
+bool LogAnalyzer::parseTemperature(const char* s, const char* end, int32_t& centi, uint32_t& repeats) const {
+  bool negative = s < end && *s == '-';
+  if (negative) s++;
+  if (s >= end || !isDigit(*s)) return false;
+  int32_t whole = 0;
+  int digits = 0;
+  for (; s < end && isDigit(*s); s++) {
+    whole = whole * 10 + (*s - '0');
+    if (++digits > 6) return false;
+  }
+  int32_t fraction = 0;
+  if (s < end && *s == '.') {
+    s++;
+    int places = 0;
+    for (; s < end && isDigit(*s) && places < 2; s++, places++) fraction = fraction * 10 + (*s - '0');
+    if (places == 0) return false;
+    if (places == 1) fraction *= 10;
+  }
+  centi = whole * 100 + fraction;
+  if (negative) centi = -centi;
+  return restIsClean(s, end, repeats);
+}
+
+// "22:38:20" -> second of the day
+bool LogAnalyzer::parseClock(const char* s, const char* end, int32_t& secondOfDay) const {
+  int field[3];
+  for (int i = 0; i < 3; i++) {
+    int digits = 0, value = 0;
+    for (; s < end && isDigit(*s) && digits < 2; s++, digits++) value = value * 10 + (*s - '0');
+    if (digits == 0) return false;  // Older builds printed "22:40:0", not zero padded
+    field[i] = value;
+    if (i < 2) {
+      if (s >= end || *s != ':') return false;
+      s++;
+    }
+  }
+  if (field[0] > 23 || field[1] > 59 || field[2] > 59) return false;
+  uint32_t repeats;
+  if (!restIsClean(s, end, repeats)) return false;
+  secondOfDay = field[0] * 3600 + field[1] * 60 + field[2];
+  return true;
+}
+
+// Wall-clock line -> timeline ms. Midnight is an ordinary step. A forward jump of up to
+// CLOCK_PAUSE_MAX_S is output that stalled and counts as elapsed time, anything else (a
+// reboot, the first NTP sync) moves the clock by an unknown amount of real time, so the
+// timeline carries on from the last good value.
+int64_t LogAnalyzer::clockToMs(int32_t secondOfDay) {
+  if (lastClock < 0) {
+    clockMs = (int64_t)secondOfDay * 1000;
+  } else {
+    int32_t step = (secondOfDay - lastClock + 86400) % 86400;
+    if (step > CLOCK_STEP_MAX_S) {
+      // An odd value is a corrupted line ("Time: 22:40:1" cut from "22:40:15"), the same
+      // corruption can repeat. A real jump is believed once the clock ticks on from it.
+      int32_t follow = pendingClock < 0 ? -1 : (secondOfDay - pendingClock + 86400) % 86400;
+      if (follow < 1 || follow > CLOCK_CONFIRM_S) {
+        if (secondOfDay != pendingClock) pendingLines = 0;
+        pendingClock = secondOfDay;
+        pendingLines++;
+        clockRejected++;
+        return NO_TIME;
+      }
+      clockRejected -= pendingLines;
+      clockJumps++;
+      if (step > CLOCK_PAUSE_MAX_S) step = follow;
+    }
+    clockMs += (int64_t)step * 1000;
+  }
+  lastClock = secondOfDay;
+  pendingClock = -1;
+  pendingLines = 0;
+  return clockMs;
+}
+
+void LogAnalyzer::handleLine(const char* s, size_t n) {
+  const char* end = s + n;
+  for (const char* p = s; p < end; p++) {
+    if ((unsigned char)*p < 0x20 && *p != '\t') {  // Binary noise, e.g. a boot ROM dump at the wrong baud
+      corrupt++;
+      return;
+    }
+  }
+
+  // Logger prefix "[12345 I] "
+  int64_t prefixMs = NO_TIME;
+  if (n >= 6 && s[0] == '[' && isDigit(s[1])) {
+    const char* p = s + 1;
+    int64_t ms = 0;
+    for (; p < end && isDigit(*p); p++) ms = ms * 10 + (*p - '0');
+    if (end - p >= 4 && p[0] == ' ' && strchr("EWID", p[1]) && p[2] == ']' && p[3] == ' ') {
+      prefixMs = ms;
+      s = p + 4;
+    }
+  }
+  if (prefixMs != NO_TIME) {
+    lastTimeMs = prefixMs;
+    if (firstTimeMs == NO_TIME) firstTimeMs = prefixMs;
+  }
+
+  int32_t centi, clock;
+  uint32_t repeats;
+  const char* anchor = findLast(s, end, "Temperature: ");
+  if (anchor && parseTemperature(anchor + 13, end, centi, repeats)) {
+    if (anchor != s) recovered++;
+    countType("Temperature: #", nullptr, repeats);
+    for (uint32_t i = 0; i < repeats; i++) {
+      addSample(lastTimeMs == NO_TIME ? NO_TIME : lastTimeMs + (int64_t)i * opt.periodMs, centi);
+    }
+    return;
+  }
+
+  // Wall clock, "Indian Time: hh:mm:ss", or a label cut down to "Time: " / "n Time: ",
+  // or the bare " hh:mm:ss" of older builds
+  anchor = findLast(s, end, "Time: ");
+  const char* value = anchor ? anchor + 6 : s;
+  while (!anchor && value < end && *value == ' ') value++;
+  if ((anchor || (value < end && isDigit(*value))) && parseClock(value, end, clock)) {
+    bool wholeLabel = anchor == s + 7 && memcmp(s, "Indian ", 7) == 0;
+    if (anchor && !wholeLabel) recovered++;
+    countType(anchor ? "Indian Time: #:#:#" : "#:#:#", nullptr, 1);
+    if (prefixMs == NO_TIME) {
+      int64_t ms = clockToMs(clock);
+      if (ms != NO_TIME) {
+        lastTimeMs = ms;
+        if (firstTimeMs == NO_TIME) firstTimeMs = ms;
+      }
+    }
+    return;
+  }
+
+  // A line holding a piece of a known label, or a clock/temperature value without its
+  // label, is a fragment
+  for (const char* p = s; p + 2 < end; p++) {
+    if (isDigit(p[0]) && (p[1] == ':' || p[1] == '.') && isDigit(p[2])) {
+      corrupt++;
+      return;
+    }
+  }
+  for (const char* piece : labelPieces) {
+    if (findLast(s, end, piece)) {
+      corrupt++;
+      return;
+    }
+  }
+  if (s == end) return;
+
+  uint32_t count = 1;
+  const char* x = findLast(s, end, " x");
+  if (x && restIsClean(x, end, count)) end = x;
+  countType(s, end, count);
+}
+
+void LogAnalyzer::addSample(int64_t timeMs, int32_t centi) {
+  samples++;
+  sumCenti += centi;
+  if (centi < minCenti) minCenti = centi;
+  if (centi > maxCenti) maxCenti = centi;
+  if (centi < HIST_MIN_CENTI) belowHist++;
+  else if (centi > HIST_MAX_CENTI) aboveHist++;
+  else hist[centi - HIST_MIN_CENTI]++;
+
+  if (timeMs != NO_TIME) {
+    timedSamples++;
+    if (firstSampleMs == NO_TIME) firstSampleMs = timeMs;
+    if (lastSampleMs != NO_TIME) {
+      int64_t interval = timeMs - lastSampleMs;
+      if (interval < minIntervalMs) minIntervalMs = interval;
+      if (interval > maxIntervalMs) maxIntervalMs = interval;
+      if (interval > opt.gapMs) {
+        gaps++;
+        if (interval > longestGapMs) {
+          longestGapMs = interval;
+          longestGapAtMs = lastSampleMs;
+        }
+      }
+      if (haveZone && zone > 0) msAboveHigh += interval;
+      if (haveZone && zone < 0) msBelowLow += interval;
+    }
+    lastSampleMs = timeMs;
+  }
+
+  int newZone = centi > opt.highCenti ? 1 : centi < opt.lowCenti ? -1 : 0;
+  if (newZone != zone || !haveZone) {  // Starting above/below the limits counts too
+    if (newZone > 0) highCrossings++;
+    if (newZone < 0) lowCrossings++;
+  }
+  zone = newZone;
+  haveZone = true;
+
+  if (opt.csv) {
+    if (timeMs != NO_TIME) fprintf(opt.csv, "%lld,", (long long)timeMs);
+    else fprintf(opt.csv, ",");
+    fprintf(opt.csv, "%s%d.%02d\n", centi < 0 ? "-" : "", abs(centi) / 100, abs(centi) % 100);
+  }
+}
+
+// Count a line under its type: text with digit runs folded to '#' (end == nullptr: s is the key)
+void LogAnalyzer::countType(const char* s, const char* end, uint64_t count) {
+  char key[TYPE_KEY_CHARS + 1];
+  size_t k = 0;
+  if (!end) {
+    k = strlen(s);
+    memcpy(key, s, k);
+  } else {
+    for (; s < end && k < TYPE_KEY_CHARS; s++) {
+      if (isDigit(*s)) {
+        if (k == 0 || key[k - 1] != '#') key[k++] = '#';
+      } else {
+        key[k++] = *s;
+      }
+    }
+  }
+  key[k] = 0;
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < k; i++) hash = (hash ^ (uint8_t)key[i]) * 16777619u;
+  for (int i = 0; i < typeCount; i++) {
+    if (types[i].hash == hash && strcmp(types[i].key, key) == 0) {
+      types[i].lines += count;
+      return;
+    }
+  }
+  if (typeCount == MAX_TYPES) {
+    otherTypeLines += count;
+    return;
+  }
+  memcpy(types[typeCount].key, key, k + 1);
+  types[typeCount].hash = hash;
+  types[typeCount].lines = count;
+  typeCount++;
+}
+
+static void printCenti(FILE* out, const char* label, int32_t centi) {
+  fprintf(out, " %s %s%d.%02d", label, centi < 0 ? "-" : "", abs(centi) / 100, abs(centi) % 100);
+}
+
+void LogAnalyzer::report(FILE* out, const char* name, double seconds) const {
+  fprintf(out, "== %s\n", name);
+  fprintf(out, "bytes %llu, lines %llu, corrupt %llu, recovered %llu, clock rejected %llu\n",
+          (unsigned long long)bytes, (unsigned long long)lines, (unsigned long long)corrupt,
+          (unsigned long long)recovered, (unsigned long long)clockRejected);
+  if (clockJumps) fprintf(out, "wall clock jumped %llu times\n", (unsigned long long)clockJumps);
+  if (seconds > 0) {
+    fprintf(out, "parsed in %.3f s, %.1f MB/s, %.2f M lines/s\n", seconds, bytes / seconds / 1e6,
+            lines / seconds / 1e6);
+  }
+
+  double spanS = firstTimeMs != NO_TIME && lastTimeMs > firstTimeMs ? (lastTimeMs - firstTimeMs) / 1000.0 : 0;
+  if (spanS > 0) fprintf(out, "time span %.0f s\n", spanS);
+
+  fprintf(out, "readings %llu", (unsigned long long)samples);
+  if (samples > 0) {
+    printCenti(out, "min", minCenti);
+    printCenti(out, "mean", (int32_t)(sumCenti / (int64_t)samples));
+    printCenti(out, "max", maxCenti);
+    static const int pct[] = { 1, 5, 50, 95, 99 };
+    for (int p : pct) {
+      // Nearest-rank percentile from the 0.01 C histogram
+      uint64_t rank = (samples * p + 99) / 100, seen = belowHist;
+      int32_t value = minCenti;
+      if (seen < rank) {
+        value = maxCenti;
+        for (int b = 0; b < HIST_BINS; b++) {
+          seen += hist[b];
+          if (seen >= rank) {
+            value = b + HIST_MIN_CENTI;
+            break;
+          }
+        }
+      }
+      char label[8];
+      snprintf(label, sizeof(label), "p%d", p);
+      printCenti(out, label, value);
+    }
+  }
+  fprintf(out, "\n");
+
+  if (timedSamples > 1) {
+    double readingSpanS = (lastSampleMs - firstSampleMs) / 1000.0;
+    fprintf(out, "sample rate %.3f /s, interval min %lld ms max %lld ms, gaps > %lld ms: %llu",
+            readingSpanS > 0 ? (timedSamples - 1) / readingSpanS : 0.0, (long long)minIntervalMs,
+            (long long)maxIntervalMs, (long long)opt.gapMs, (unsigned long long)gaps);
+    if (gaps) fprintf(out, " (longest %lld ms at t=%lld ms)", (long long)longestGapMs, (long long)longestGapAtMs);
+    fprintf(out, "\n");
+  } else if (samples > 0) {
+    fprintf(out, "no timestamps in this capture, rate and gaps unknown\n");
+  }
+
+  if (samples > 0) {
+    fprintf(out, "crossings:");
+    printCenti(out, "above", opt.highCenti);
+    fprintf(out, " %llu (%lld s),", (unsigned long long)highCrossings, (long long)(msAboveHigh / 1000));
+    printCenti(out, "below", opt.lowCenti);
+    fprintf(out, " %llu (%lld s)\n", (unsigned long long)lowCrossings, (long long)(msBelowLow / 1000));
+  }
+
+  // Message types by line count
+  bool printed[MAX_TYPES] = {};
+  for (int n = 0; n < typeCount; n++) {
+    int best = -1;
+    for (int i = 0; i < typeCount; i++) {
+      if (!printed[i] && (best < 0 || types[i].lines > types[best].lines)) best = i;
+    }
+    printed[best] = true;
+    fprintf(out, "  %10llu", (unsigned long long)types[best].lines);
+    if (spanS > 0) fprintf(out, " %9.3f/s", types[best].lines / spanS);
+    fprintf(out, "  %s\n", types[best].key);
+  }
+  if (otherTypeLines) fprintf(out, "  %10llu  (other)\n", (unsigned long long)otherTypeLines);
+  if (corrupt) fprintf(out, "  %10llu  (corrupt)\n", (unsigned long long)corrupt);
+}
+
+static long peakRssKb() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+// Synthetic capture like the old ones: wall clock spam, one reading a second, ~1% of the
+// lines spliced into the next, plus logger-format lines
+static std::string syntheticBlock(size_t bytes) {
+  std::string block;
+  uint32_t rng = 1, second = 0, ms = 0;
+  char text[64];
+  while (block.size() < bytes) {
+    rng = rng * 1664525u + 1013904223u;
+    int kind = rng >> 24;
+    int n;
+    if (kind < 200) {
+      n = snprintf(text, sizeof(text), "Indian Time: %02u:%02u:%02u\n", second / 3600 % 24, second / 60 % 60, second % 60);
+    } else if (kind < 240) {
+      second++;
+      n = snprintf(text, sizeof(text), "Temperature: %u.%02u\n", 20 + (rng >> 8) % 25, (rng >> 4) % 100);
+    } else {
+      ms += 1000;
+      n = snprintf(text, sizeof(text), "[%u I] Temperature: %u.%02u x%u\n", ms, 20 + (rng >> 8) % 25, (rng >> 4) % 100, 1 + (rng & 7));
+    }
+    if ((rng & 0x7F) == 0) n = 5 + (rng >> 12) % (n - 5);  // Cut: newline lost, next line glued on
+    block.append(text, n);
+  }
+  return block;
+}
+
+static int bench(double megabytes) {
+  const size_t blockBytes = 8 << 20;
+  std::string block = syntheticBlock(blockBytes);
+  Options options;
+  LogAnalyzer analyzer(options);
+  uint64_t total = (uint64_t)(megabytes * 1e6);
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t fed = 0; fed < total; fed += block.size()) {
+    for (size_t off = 0; off < block.size(); off += CHUNK_BYTES) {
+      analyzer.feed(block.data() + off, block.size() - off < CHUNK_BYTES ? block.size() - off : CHUNK_BYTES);
+    }
+  }
+  analyzer.finish();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("bench: %.0f MB, %llu lines, %llu readings in %.3f s: %.1f MB/s, %.2f M lines/s, peak RSS %ld kB\n",
+         analyzer.bytes / 1e6, (unsigned long long)analyzer.lines, (unsigned long long)analyzer.samples, seconds,
+         analyzer.bytes / seconds / 1e6, analyzer.lines / seconds / 1e6, peakRssKb());
+  return 0;
+}
+
+static int usage(const char* argv0) {
+  fprintf(stderr, "usage: %s [--high C] [--low C] [--gap-ms N] [--period-ms N] [--csv out.csv] [capture...]\n"
+                  "       %s --bench [MB]\n", argv0, argv0);
+  return 2;
+}
+
+int main(int argc, char** argv) {
+  Options options;
+  int first = argc;
+  for (int i = 1; i < argc; i++) {
+    std::string a = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (a == "--bench") return bench(hasValue ? atof(argv[i + 1]) : 1024);
+    else if (a == "--high" && hasValue) options.highCenti = (int32_t)(atof(argv[++i]) * 100);
+    else if (a == "--low" && hasValue) options.lowCenti = (int32_t)(atof(argv[++i]) * 100);
+    else if (a == "--gap-ms" && hasValue) options.gapMs = atoll(argv[++i]);
+    else if (a == "--period-ms" && hasValue) options.periodMs = atoll(argv[++i]);
+    else if (a == "--csv" && hasValue) {
+      if (!(options.csv = fopen(argv[++i], "w"))) {
+        perror(argv[i]);
+        return 1;
+      }
+      fprintf(options.csv, "time_ms,temp_c\n");
+    } else if (a[0] == '-' && a.size() > 1) {
+      return usage(argv[0]);
+    } else {
+      first = i;
+      break;
+    }
+  }
+
+  static char chunk[CHUNK_BYTES];
+  int status = 0;
+  for (int i = first; i <= argc; i++) {
+    if (i == argc && first != argc) break;
+    const char* name = i < argc ? argv[i] : "(stdin)";
+    FILE* in = i < argc ? fopen(name, "rb") : stdin;
+    if (!in) {
+      perror(name);
+      status = 1;
+      continue;
+    }
+    LogAnalyzer* analyzer = new LogAnalyzer(options);  // ~80 kB of histogram, keep it off the stack
+    auto start = std::chrono::steady_clock::now();
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) analyzer->feed(chunk, n);
+    analyzer->finish();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    analyzer->report(stdout, name, seconds);
+    delete analyzer;
+    if (in != stdin) fclose(in);
+  }
+  if (options.csv) fclose(options.csv);
+  return status;
+}
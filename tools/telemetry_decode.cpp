@@ -0,0 +1,50 @@
+/*
+ * Host-side telemetry decoder
+ * Reads a serial capture of a TELEMETRY_BINARY=1 build and writes one CSV row per decoded
+ * reading. Text log lines in the capture are skipped, frames lost or damaged on the line
+ * are counted in the summary on stderr.
+ *
+ * Build (from the repository root):
+ *   g++ -std=c++17 -O2 -Iinclude tools/telemetry_decode.cpp src/telemetry.cpp -o telemetry_decode
+ *
+ * Usage:
+ *   telemetry_decode capture.bin > capture.csv
+ *   telemetry_decode < /dev/ttyUSB0
+ */
+#include <stdio.h>
+#include <string.h>
+#include "telemetry.h"
+
+int main(int argc, char** argv) {
+  FILE* in = stdin;
+  if (argc > 2 || (argc == 2 && (!strcmp(argv[1], "-h") || !strcmp(argv[1], "--help")))) {
+    fprintf(stderr, "usage: %s [capture]\n", argv[0]);
+    return 2;
+  }
+  if (argc == 2 && !(in = fopen(argv[1], "rb"))) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  TelemetryDecoder decoder;
+  TelemetrySample sample;
+  printf("timestamp_ms,adc_q4,temp_c,fan,high_alert,low_alert,early_warning\n");
+  unsigned char buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+    for (size_t i = 0; i < n; i++) {
+      if (decoder.feed(buffer[i], sample) != TelemetryDecoder::SAMPLE) continue;
+      long centi = sample.centiC < 0 ? -(long)sample.centiC : sample.centiC;
+      printf("%lu,%u,%s%ld.%02ld,%d,%d,%d,%d\n", (unsigned long)sample.timestampMs, (unsigned)sample.adcQ4,
+             sample.centiC < 0 ? "-" : "", centi / 100, centi % 100,
+             (sample.flags & TELEMETRY_FLAG_FAN) != 0, (sample.flags & TELEMETRY_FLAG_HIGH) != 0,
+             (sample.flags & TELEMETRY_FLAG_LOW) != 0, (sample.flags & TELEMETRY_FLAG_EARLY) != 0);
+    }
+  }
+  if (in != stdin) fclose(in);
+
+  fprintf(stderr, "%lu samples, %lu bad frames, %lu lost, %lu skipped waiting for a keyframe\n",
+          (unsigned long)decoder.samples, (unsigned long)decoder.bad, (unsigned long)decoder.lost,
+          (unsigned long)decoder.skipped);
+  return 0;
+}